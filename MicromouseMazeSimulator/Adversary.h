@@ -0,0 +1,238 @@
+#ifndef Adversary_h
+#define Adversary_h
+
+#include <cstring>  // memcmp
+#include <vector>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm> // std::max
+
+#include "Dir.h"
+#include "MazeDefinitions.h"
+
+/**
+ * Search for mazes a PathFinder does badly in: parallel hill climbing over wall toggles.
+ *
+ * Every thread starts from a seed maze and keeps toggling a few walls at random, keeping the
+ * change when the score (e.g. the steps of a headless run) does not go down. Toggles keep the
+ * maze a valid contest maze:
+ *     - every cell reachable from the start stays reachable (some built-in mazes have cells
+ *       that cannot be reached, closing walls is not held against them)
+ *     - the start keeps its east wall, the center its open inside and its walls around
+ *       (so its entrances are those of the seed)
+ *     - no post that has a wall loses its last one
+ * The best mazes of all threads are kept, a maze at most once.
+ */
+namespace Adversary {
+    /**
+     * The walls of a maze in the format of MazeDefinitions: column major, 1 north, 2 east,
+     * 4 south and 8 west when closed. This is what BasicMazeWorld decodes and saves.
+     */
+    template <unsigned LEN>
+    struct Maze {
+        unsigned char cells[LEN][LEN];
+
+        inline bool closed(unsigned x, unsigned y, Dir d) const {
+            return cells[x][y] & bit(d);
+        }
+
+        // close or open the wall on side d of (x,y), seen from both sides. Not for the outer walls.
+        void set(unsigned x, unsigned y, Dir d, bool closed) {
+            unsigned nx = x, ny = y;
+            step(nx, ny, d);
+            if(closed) {
+                cells[x][y] |= bit(d);
+                cells[nx][ny] |= bit(opposite(d));
+            } else {
+                cells[x][y] &= ~bit(d);
+                cells[nx][ny] &= ~bit(opposite(d));
+            }
+        }
+
+        bool operator==(const Maze &other) const {
+            return memcmp(cells, other.cells, sizeof(cells)) == 0;
+        }
+
+        static inline unsigned char bit(Dir d) {
+            return d == NORTH ? 1 : d == EAST ? 2 : d == SOUTH ? 4 : 8;
+        }
+
+        static inline void step(unsigned &x, unsigned &y, Dir d) {
+            x += d == EAST ? 1 : d == WEST ? -1 : 0;
+            y += d == NORTH ? 1 : d == SOUTH ? -1 : 0;
+        }
+    };
+
+    template <unsigned LEN>
+    inline bool isCenter(unsigned x, unsigned y) {
+        return (x == LEN / 2 - 1 || x == LEN / 2) && (y == LEN / 2 - 1 || y == LEN / 2);
+    }
+
+    // number of cells that can be reached from the start, the start included.
+    template <unsigned LEN>
+    unsigned reachable(const Maze<LEN> &maze) {
+        bool seen[LEN][LEN] = {};
+        unsigned stack[LEN * LEN];
+        unsigned top = 0, reached = 1;
+        seen[0][0] = true;
+        stack[top++] = 0;
+        const Dir sides[] = {NORTH, EAST, SOUTH, WEST};
+        while(top) {
+            const unsigned cell = stack[--top];
+            const unsigned x = cell / LEN, y = cell % LEN;
+            for(unsigned s = 0; s < 4; s++) {
+                if(maze.closed(x, y, sides[s]))
+                    continue;
+                unsigned nx = x, ny = y;
+                Maze<LEN>::step(nx, ny, sides[s]);
+                if(!seen[nx][ny]) {
+                    seen[nx][ny] = true;
+                    reached++;
+                    stack[top++] = nx * LEN + ny;
+                }
+            }
+        }
+        return reached;
+    }
+
+    // posts inside the maze, but the one in the middle of the center, without any wall.
+    template <unsigned LEN>
+    unsigned lonelyPosts(const Maze<LEN> &maze) {
+        unsigned lonely = 0;
+        for(unsigned i = 1; i < LEN; i++) {
+            for(unsigned j = 1; j < LEN; j++) {
+                if(i == LEN / 2 && j == LEN / 2)
+                    continue;
+                // the walls to the north, south, east and west of the post at the corner of cell (i,j).
+                lonely += !maze.closed(i - 1, j, EAST) && !maze.closed(i - 1, j - 1, EAST) &&
+                          !maze.closed(i, j - 1, NORTH) && !maze.closed(i - 1, j - 1, NORTH);
+            }
+        }
+        return lonely;
+    }
+
+    /**
+     * Toggle one to three walls, keeping the maze valid (see above).
+     * @return false if no valid toggle was found in a reasonable number of tries
+     */
+    template <unsigned LEN>
+    bool mutate(Maze<LEN> &maze, std::mt19937 &random) {
+        const unsigned toggles = 1 + random() % 3;
+        const unsigned lonely = lonelyPosts(maze);
+        // closing a wall can only take cells away, so keeping the count keeps every one of them.
+        unsigned cells = reachable(maze);
+        unsigned done = 0;
+        for(unsigned tries = 0; done < toggles && tries < 64; tries++) {
+            // the north or east wall of a cell that is not on the outside.
+            const unsigned x = random() % LEN, y = random() % LEN;
+            const Dir d = random() % 2 ? NORTH : EAST;
+            if((d == NORTH && y == LEN - 1) || (d == EAST && x == LEN - 1))
+                continue;
+            unsigned nx = x, ny = y;
+            Maze<LEN>::step(nx, ny, d);
+            // the start's east wall, and every wall of the center.
+            if((x == 0 && y == 0 && d == EAST) || isCenter<LEN>(x, y) || isCenter<LEN>(nx, ny))
+                continue;
+
+            const bool closing = !maze.closed(x, y, d);
+            maze.set(x, y, d, closing);
+            if(closing ? reachable(maze) < cells : lonelyPosts(maze) > lonely) {
+                maze.set(x, y, d, !closing);
+                continue;
+            }
+            // opening one may add cells, which have to stay reachable from then on.
+            if(!closing)
+                cells = reachable(maze);
+            done++;
+        }
+        return done > 0;
+    }
+
+    /**
+     * A maze found by the search.
+     */
+    template <unsigned LEN>
+    struct Found {
+        Maze<LEN> maze;
+        unsigned long score;
+        // seed it was grown from, and the evaluation that found it.
+        unsigned seed;
+        unsigned long evaluation;
+    };
+
+    /**
+     * Hill climb from the seeds on threads threads until evaluations scores have been taken.
+     * Each seed gets a climb of the same length (at least one per thread), taken by whichever
+     * thread is free.
+     * @param score: unsigned long (const Maze<LEN> &), called on many threads at once
+     * @param keep: number of best mazes to return
+     * @return the best mazes, best first
+     */
+    template <unsigned LEN, typename Score>
+    std::vector<Found<LEN> > search(const std::vector<Maze<LEN> > &seeds, Score score, unsigned long evaluations,
+                                   unsigned threads, unsigned keep, unsigned randomSeed = 1) {
+        std::vector<Found<LEN> > best;
+        std::mutex bestLock;
+        std::atomic<unsigned long> taken(0);
+        std::atomic<unsigned> nextSeed(0);
+
+        // keep a maze if it is among the best so far and not kept already.
+        auto offer = [&](const Found<LEN> &found) {
+            std::lock_guard<std::mutex> lock(bestLock);
+            for(size_t i = 0; i < best.size(); i++) {
+                if(best[i].maze == found.maze)
+                    return;
+            }
+            if(best.size() == keep && found.score <= best.back().score)
+                return;
+            if(best.size() == keep)
+                best.pop_back();
+            size_t at = best.size();
+            while(at > 0 && best[at - 1].score < found.score) {
+                at--;
+            }
+            best.insert(best.begin() + at, found);
+        };
+
+        // every seed gets climbs of the same length, taken by the threads in turn.
+        const unsigned long climb = std::max(1ul, evaluations / std::max<unsigned long>(std::max(1u, threads), seeds.size()));
+        std::vector<std::thread> workers;
+        for(unsigned t = 0; t < std::max(1u, threads); t++) {
+            workers.push_back(std::thread([&, t]() {
+                std::mt19937 random(randomSeed * 7919 + t);
+                Found<LEN> current;
+                unsigned long climbed = climb;
+                for(unsigned long e; (e = taken++) < evaluations; climbed++) {
+                    if(climbed == climb) {
+                        // the next seed nobody has climbed from yet, round and round.
+                        current.seed = nextSeed++ % seeds.size();
+                        current.maze = seeds[current.seed];
+                        current.score = score(current.maze);
+                        current.evaluation = e;
+                        offer(current);
+                        climbed = 0;
+                        continue;
+                    }
+                    Found<LEN> candidate = current;
+                    if(!mutate(candidate.maze, random))
+                        continue;
+                    candidate.score = score(candidate.maze);
+                    candidate.evaluation = e;
+                    // sideways moves too, so the climb can cross plateaus.
+                    if(candidate.score >= current.score) {
+                        current = candidate;
+                        offer(current);
+                    }
+                }
+            }));
+        }
+        for(size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+        return best;
+    }
+}
+
+#endif
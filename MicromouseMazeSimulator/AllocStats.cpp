@@ -0,0 +1,175 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <iomanip>
+#include "AllocStats.h"
+
+namespace AllocStats {
+    namespace {
+        // Counters live in fixed tables, counting must never allocate.
+        const unsigned MAX_ENTRIES = 64;
+
+        struct Entry {
+            std::atomic<const char *> name;
+            std::atomic<uint64_t> allocations;
+            std::atomic<uint64_t> bytes;
+        };
+
+        struct Table {
+            Entry entries[MAX_ENTRIES];
+            std::atomic<unsigned> used;
+            std::atomic_flag adding;
+
+            // find the entry of name, adding it if needed. NULL if the table is full.
+            Entry *find(const char *name) {
+                for(;;) {
+                    const unsigned n = used.load(std::memory_order_acquire);
+                    for(unsigned i = 0; i < n; i++) {
+                        if(entries[i].name.load(std::memory_order_relaxed) == name) {
+                            return &entries[i];
+                        }
+                    }
+                    if(n == MAX_ENTRIES) {
+                        return NULL;
+                    }
+                    if(!adding.test_and_set(std::memory_order_acquire)) {
+                        // nobody else added it in the meantime?
+                        if(used.load(std::memory_order_relaxed) == n) {
+                            entries[n].name.store(name, std::memory_order_relaxed);
+                            used.store(n + 1, std::memory_order_release);
+                        }
+                        adding.clear(std::memory_order_release);
+                    }
+                }
+            }
+        };
+
+        // zero initialized, usable before any constructor runs.
+        Table groups;
+        Table phases;
+        std::atomic<bool> tracking;
+        std::atomic<uint64_t> totalAllocations;
+        std::atomic<uint64_t> totalBytes;
+
+        thread_local const char *currentGroup = NULL;
+        thread_local const char *currentPhase = NULL;
+
+        void add(Table &table, const char *name, uint64_t size) {
+            Entry *entry = table.find(name);
+            if(entry) {
+                entry->allocations.fetch_add(1, std::memory_order_relaxed);
+                entry->bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+        }
+
+        void print(std::ostream &out, const char *title, Table &table, unsigned long steps) {
+            out << title << ":" << std::endl;
+            const unsigned n = table.used.load();
+            for(unsigned i = 0; i < n; i++) {
+                const uint64_t allocations = table.entries[i].allocations;
+                if(allocations == 0) {
+                    continue;
+                }
+                out << "  " << std::left << std::setw(28) << table.entries[i].name.load() << std::right
+                    << std::setw(10) << allocations << " allocations" << std::setw(12) << table.entries[i].bytes << " bytes";
+                if(steps) {
+                    out << std::setw(10) << std::fixed << std::setprecision(2) << (double)allocations / steps << " per step";
+                }
+                out << std::endl;
+            }
+        }
+    }
+
+    void track(bool on) {
+        tracking = on;
+    }
+
+    void setPhase(const char *name) {
+        currentPhase = name;
+    }
+
+    uint64_t allocations() {
+        return totalAllocations;
+    }
+
+    uint64_t bytes() {
+        return totalBytes;
+    }
+
+    void count(uint64_t size) {
+        if(!tracking.load(std::memory_order_relaxed)) {
+            return;
+        }
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        totalBytes.fetch_add(size, std::memory_order_relaxed);
+        add(groups, currentGroup ? currentGroup : "(no group)", size);
+        add(phases, currentPhase ? currentPhase : "(no phase)", size);
+    }
+
+    void report(std::ostream &out, unsigned long steps) {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+
+        out << "Allocations: " << allocations() << " (" << bytes() << " bytes)";
+        if(steps) {
+            out << ", " << std::fixed << std::setprecision(2) << (double)allocations() / steps << " allocations and "
+                << (double)bytes() / steps << " bytes per step";
+        }
+        out << std::endl;
+        print(out, "Per phase", phases, steps);
+        print(out, "Per function group", groups, steps);
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    Group::Group(const char *name) : previous(currentGroup) {
+        currentGroup = name;
+    }
+
+    Group::~Group() {
+        currentGroup = previous;
+    }
+}
+
+#ifdef ALLOC_TRACKING
+
+void *operator new(size_t size) {
+    AllocStats::count(size);
+    void *p = malloc(size ? size : 1);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    AllocStats::count(size);
+    return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef AllocStats_h
+#define AllocStats_h
+
+#include <stdint.h> // uint64_t
+#include <ostream>
+
+/**
+ * Allocation tracking.
+ *
+ * When built with -DALLOC_TRACKING (make alloc), the global operator new is replaced
+ * by a counting one. While tracking is on, every allocation is counted in total, for
+ * the function group the calling thread is in (innermost ALLOC_GROUP) and for its
+ * phase (e.g. the FloodFill mode, set with ALLOC_PHASE). Without ALLOC_TRACKING the
+ * macros compile to nothing.
+ */
+namespace AllocStats {
+    // start or stop counting. Allocations while stopped are not counted anywhere.
+    void track(bool on);
+
+    // name the phase the calling thread is in. name must outlive the program, NULL for none.
+    void setPhase(const char *name);
+
+    // allocations and bytes counted so far.
+    uint64_t allocations();
+    uint64_t bytes();
+
+    // print totals, per step figures and the breakdown per phase and per function group.
+    void report(std::ostream &out, unsigned long steps);
+
+    // called by the counting operator new.
+    void count(uint64_t size);
+
+    // attributes the allocations of a scope to a function group.
+    class Group {
+    public:
+        explicit Group(const char *name);
+        ~Group();
+
+    private:
+        Group(const Group &);
+        Group &operator=(const Group &);
+
+        const char *previous;
+    };
+}
+
+#ifdef ALLOC_TRACKING
+#define ALLOC_GROUP(name) AllocStats::Group allocGroup(name)
+#define ALLOC_PHASE(name) AllocStats::setPhase(name)
+#else
+#define ALLOC_GROUP(name)
+#define ALLOC_PHASE(name)
+#endif
+
+#endif
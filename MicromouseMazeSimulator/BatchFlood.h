@@ -0,0 +1,397 @@
+#ifndef BatchFlood_h
+#define BatchFlood_h
+
+#include <stdint.h> // uint16_t, uint32_t, uint64_t
+#include <cstddef>  // size_t
+#include <cstring>  // memset
+#include <vector>
+
+#include "BitVector256.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Distances from the center for a whole corpus of mazes, many mazes per pass.
+ *
+ * A maze is held as bitboards, a word per column: bit y of column x stands for cell (x,y).
+ * A register holds the same column of WIDTH different mazes side by side, and the flood is
+ * breadth first on all of them at once: the cells reached at distance d+1 are the open
+ * neighbors of those at distance d, moved by a shift along the column and taken from the
+ * columns next door across it. The batch runs until no maze reaches a new cell.
+ *
+ * Distances are bit sliced: bit b of the distance of every cell reached at distance d is
+ * ORed into plane b, so a level costs a few logical operations per column whatever the
+ * number of cells it reaches, and no cell is ever looked at one at a time.
+ *
+ * WIDTH is 16 mazes of 16x16 (8 of 32x32) with -mavx2, 8 (4) with SSE2 and 4 (2) in a
+ * 64 bit word otherwise.
+ */
+namespace BatchFlood {
+    // distance of a cell the flood did not reach.
+    const unsigned UNREACHED = 0xffff;
+
+    // "AVX2", "SSE2" or "64 bit words", whichever the batch was built with.
+    inline const char *instructionSet() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE2__)
+        return "SSE2";
+#else
+        return "64 bit words";
+#endif
+    }
+
+    /**
+     * The walls of one maze: bit y of column x is set when (x,y) is open to that side.
+     * South and west are the north and east of the neighbor, the outer walls are never open.
+     */
+    template <unsigned LEN>
+    struct Walls {
+        typedef typename BitVector<LEN>::Column Column;
+
+        Column north[LEN];
+        Column east[LEN];
+
+        // every wall present.
+        Walls() {
+            memset(north, 0, sizeof(north));
+            memset(east, 0, sizeof(east));
+        }
+
+        // a wall is open if either cell says so, as in BasicMazeWorld.
+        explicit Walls(const unsigned char (*encoding)[LEN]) {
+            const unsigned westMask  = 1 << 3;
+            const unsigned southMask = 1 << 2;
+            const unsigned eastMask  = 1 << 1;
+            const unsigned northMask = 1 << 0;
+            memset(north, 0, sizeof(north));
+            memset(east, 0, sizeof(east));
+            for(unsigned x = 0; x < LEN; x++) {
+                for(unsigned y = 0; y < LEN; y++) {
+                    if(y + 1 < LEN && ((encoding[x][y] & northMask) == 0 || (encoding[x][y + 1] & southMask) == 0))
+                        north[x] |= (Column)1 << y;
+                    if(x + 1 < LEN && ((encoding[x][y] & eastMask) == 0 || (encoding[x + 1][y] & westMask) == 0))
+                        east[x] |= (Column)1 << y;
+                }
+            }
+        }
+
+        inline bool isNorthOpen(unsigned x, unsigned y) const {
+            return (north[x] >> y) & 1;
+        }
+
+        inline bool isEastOpen(unsigned x, unsigned y) const {
+            return (east[x] >> y) & 1;
+        }
+
+        /**
+         * Carve a maze: a depth first (recursive backtracker) perfect maze, loops extra walls
+         * removed at random and the four center cells opened to each other.
+         * The same seed always gives the same maze.
+         */
+        void generate(uint32_t seed, unsigned loops) {
+            memset(north, 0, sizeof(north));
+            memset(east, 0, sizeof(east));
+            uint32_t state = seed ? seed : 1;
+
+            Column visited[LEN];
+            memset(visited, 0, sizeof(visited));
+            unsigned stack[LEN * LEN];
+            unsigned depth = 0;
+            stack[depth++] = 0;
+            visited[0] = 1;
+            while(depth) {
+                const unsigned x = stack[depth - 1] / LEN;
+                const unsigned y = stack[depth - 1] % LEN;
+                // unvisited neighbors, as 0 north, 1 south, 2 east, 3 west.
+                unsigned options[4];
+                unsigned n = 0;
+                if(y + 1 < LEN && !((visited[x] >> (y + 1)) & 1))
+                    options[n++] = 0;
+                if(y > 0 && !((visited[x] >> (y - 1)) & 1))
+                    options[n++] = 1;
+                if(x + 1 < LEN && !((visited[x + 1] >> y) & 1))
+                    options[n++] = 2;
+                if(x > 0 && !((visited[x - 1] >> y) & 1))
+                    options[n++] = 3;
+                if(n == 0) {
+                    depth--;
+                    continue;
+                }
+                switch(options[next(state) % n]) {
+                    case 0:
+                        north[x] |= (Column)1 << y;
+                        stack[depth++] = x * LEN + y + 1;
+                        visited[x] |= (Column)1 << (y + 1);
+                        break;
+                    case 1:
+                        north[x] |= (Column)1 << (y - 1);
+                        stack[depth++] = x * LEN + y - 1;
+                        visited[x] |= (Column)1 << (y - 1);
+                        break;
+                    case 2:
+                        east[x] |= (Column)1 << y;
+                        stack[depth++] = (x + 1) * LEN + y;
+                        visited[x + 1] |= (Column)1 << y;
+                        break;
+                    default:
+                        east[x - 1] |= (Column)1 << y;
+                        stack[depth++] = (x - 1) * LEN + y;
+                        visited[x - 1] |= (Column)1 << y;
+                        break;
+                }
+            }
+
+            for(unsigned k = 0; k < loops; k++) {
+                const unsigned x = next(state) % LEN;
+                const unsigned y = next(state) % LEN;
+                if(next(state) % 2) {
+                    if(y + 1 < LEN)
+                        north[x] |= (Column)1 << y;
+                } else if(x + 1 < LEN) {
+                    east[x] |= (Column)1 << y;
+                }
+            }
+
+            const unsigned mid = LEN / 2;
+            north[mid - 1] |= (Column)1 << (mid - 1);
+            north[mid] |= (Column)1 << (mid - 1);
+            east[mid - 1] |= (Column)3 << (mid - 1);
+        }
+
+    protected:
+        // xorshift32, the generator only needs to be fast and repeatable.
+        static inline uint32_t next(uint32_t &state) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+    };
+
+    /**
+     * What the flood found out about one maze.
+     */
+    template <unsigned LEN>
+    struct Result {
+        typedef typename BitVector<LEN>::Column Column;
+
+        // bits of the largest distance, one cell less than the maze.
+        static const unsigned BITS = LEN <= 16 ? 8 : 10;
+
+        // bit y of reached[x] is set if (x,y) can be reached from the center.
+        Column reached[LEN];
+        // bit y of plane[b][x] is bit b of the distance of (x,y).
+        Column plane[BITS][LEN];
+
+        // distance from the start cell (0,0) to the center, UNREACHED if walled off.
+        unsigned pathLength;
+        // cells reachable from the center, the center included.
+        unsigned cells;
+        // reachable cells by number of open sides: dead ends, corridors and turns, 3 and 4 way junctions.
+        unsigned degree[5];
+
+        inline unsigned distance(unsigned x, unsigned y) const {
+            if(!((reached[x] >> y) & 1))
+                return UNREACHED;
+            unsigned d = 0;
+            for(unsigned b = 0; b < BITS; b++) {
+                d |= ((plane[b][x] >> y) & 1) << b;
+            }
+            return d;
+        }
+    };
+
+#if defined(__AVX2__)
+    typedef __m256i Vector;
+
+    inline Vector zero() { return _mm256_setzero_si256(); }
+    inline Vector load(const void *p) { return _mm256_load_si256((const __m256i *)p); }
+    inline void store(void *p, Vector v) { _mm256_store_si256((__m256i *)p, v); }
+    inline Vector bitAnd(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+    inline Vector bitOr(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+    inline Vector bitXor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+    // a & ~b
+    inline Vector andNot(Vector a, Vector b) { return _mm256_andnot_si256(b, a); }
+    // the outer walls are closed, so no bit is ever shifted into the next lane.
+    inline Vector up(Vector a) { return _mm256_slli_epi64(a, 1); }
+    inline Vector down(Vector a) { return _mm256_srli_epi64(a, 1); }
+    inline bool any(Vector a) { return !_mm256_testz_si256(a, a); }
+#elif defined(__SSE2__)
+    typedef __m128i Vector;
+
+    inline Vector zero() { return _mm_setzero_si128(); }
+    inline Vector load(const void *p) { return _mm_load_si128((const __m128i *)p); }
+    inline void store(void *p, Vector v) { _mm_store_si128((__m128i *)p, v); }
+    inline Vector bitAnd(Vector a, Vector b) { return _mm_and_si128(a, b); }
+    inline Vector bitOr(Vector a, Vector b) { return _mm_or_si128(a, b); }
+    inline Vector bitXor(Vector a, Vector b) { return _mm_xor_si128(a, b); }
+    inline Vector andNot(Vector a, Vector b) { return _mm_andnot_si128(b, a); }
+    inline Vector up(Vector a) { return _mm_slli_epi64(a, 1); }
+    inline Vector down(Vector a) { return _mm_srli_epi64(a, 1); }
+    inline bool any(Vector a) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) != 0xffff; }
+#else
+    typedef uint64_t Vector;
+
+    inline Vector zero() { return 0; }
+    // through memcpy, the lanes are declared as narrower words.
+    inline Vector load(const void *p) { Vector v; memcpy(&v, p, sizeof(v)); return v; }
+    inline void store(void *p, Vector v) { memcpy(p, &v, sizeof(v)); }
+    inline Vector bitAnd(Vector a, Vector b) { return a & b; }
+    inline Vector bitOr(Vector a, Vector b) { return a | b; }
+    inline Vector bitXor(Vector a, Vector b) { return a ^ b; }
+    inline Vector andNot(Vector a, Vector b) { return a & ~b; }
+    inline Vector up(Vector a) { return a << 1; }
+    inline Vector down(Vector a) { return a >> 1; }
+    inline bool any(Vector a) { return a != 0; }
+#endif
+
+    /**
+     * Floods WIDTH mazes at a time. The working set is a few kilobytes and is reused from
+     * batch to batch, so a Batch is best kept for the whole corpus.
+     */
+    template <unsigned LEN>
+    class Batch {
+    public:
+        typedef typename BitVector<LEN>::Column Column;
+
+        // mazes per pass.
+        static const unsigned WIDTH = sizeof(Vector) / sizeof(Column);
+        static const unsigned BITS = Result<LEN>::BITS;
+
+        /**
+         * Flood up to WIDTH mazes.
+         * @param mazes: walls of the mazes
+         * @param results: one per maze, filled in
+         * @param count: number of mazes, at most WIDTH
+         * @return number of levels, the largest distance of all the mazes plus one
+         */
+        unsigned flood(const Walls<LEN> *mazes, Result<LEN> *results, unsigned count) {
+            // transpose: lane m of column x is column x of maze m. Missing mazes are all walls.
+            memset(lanes, 0, sizeof(lanes));
+            for(unsigned m = 0; m < count; m++) {
+                for(unsigned x = 0; x < LEN; x++) {
+                    lanes[NORTH][x][m] = mazes[m].north[x];
+                    lanes[EAST][x][m] = mazes[m].east[x];
+                }
+            }
+            const unsigned mid = LEN / 2;
+            for(unsigned m = 0; m < WIDTH; m++) {
+                lanes[FRONT][mid - 1][m] = (Column)3 << (mid - 1);
+                lanes[FRONT][mid][m] = (Column)3 << (mid - 1);
+            }
+
+            Vector north[LEN], south[LEN], east[LEN], west[LEN];
+            Vector front[LEN], reached[LEN], plane[BITS][LEN];
+            for(unsigned x = 0; x < LEN; x++) {
+                north[x] = load(lanes[NORTH][x]);
+                east[x] = load(lanes[EAST][x]);
+                // open to the south when the cell below is open to the north.
+                south[x] = up(north[x]);
+                front[x] = load(lanes[FRONT][x]);
+                reached[x] = front[x];
+                for(unsigned b = 0; b < BITS; b++) {
+                    plane[b][x] = zero();
+                }
+            }
+            for(unsigned x = 0; x < LEN; x++) {
+                west[x] = x > 0 ? east[x - 1] : zero();
+            }
+
+            unsigned d = 0;
+            for(bool moved = true; moved; ) {
+                d++;
+                moved = false;
+                Vector next[LEN];
+                for(unsigned x = 0; x < LEN; x++) {
+                    Vector n = bitOr(up(bitAnd(front[x], north[x])), down(bitAnd(front[x], south[x])));
+                    if(x > 0)
+                        n = bitOr(n, bitAnd(front[x - 1], east[x - 1]));
+                    if(x + 1 < LEN)
+                        n = bitOr(n, bitAnd(front[x + 1], west[x + 1]));
+                    next[x] = andNot(n, reached[x]);
+                }
+                Vector all = zero();
+                for(unsigned x = 0; x < LEN; x++) {
+                    front[x] = next[x];
+                    reached[x] = bitOr(reached[x], next[x]);
+                    all = bitOr(all, next[x]);
+                    for(unsigned bits = d; bits; bits &= bits - 1) {
+                        const unsigned b = __builtin_ctz(bits);
+                        plane[b][x] = bitOr(plane[b][x], next[x]);
+                    }
+                }
+                moved = any(all);
+            }
+
+            // open sides of every cell, added up bit sliced: degree = 4 * bit2 + 2 * bit1 + bit0.
+            for(unsigned x = 0; x < LEN; x++) {
+                const Vector ns = bitXor(north[x], south[x]);
+                const Vector ew = bitXor(east[x], west[x]);
+                const Vector nsPair = bitAnd(north[x], south[x]);
+                const Vector ewPair = bitAnd(east[x], west[x]);
+                const Vector bit0 = bitXor(ns, ew);
+                // two pairs make 4, one pair or one of each 2.
+                const Vector bit2 = bitAnd(nsPair, ewPair);
+                const Vector bit1 = andNot(bitOr(bitOr(nsPair, ewPair), bitAnd(ns, ew)), bit2);
+                store(lanes[DEGREE1][x], bitAnd(reached[x], andNot(andNot(bit0, bit1), bit2)));
+                store(lanes[DEGREE2][x], bitAnd(reached[x], andNot(bit1, bit0)));
+                store(lanes[DEGREE3][x], bitAnd(reached[x], bitAnd(bit0, bit1)));
+                store(lanes[DEGREE4][x], bitAnd(reached[x], bit2));
+                store(lanes[REACHED][x], reached[x]);
+                for(unsigned b = 0; b < BITS; b++) {
+                    store(planes[b][x], plane[b][x]);
+                }
+            }
+
+            for(unsigned m = 0; m < count; m++) {
+                Result<LEN> &r = results[m];
+                unsigned counts[5] = {0, 0, 0, 0, 0};
+                for(unsigned x = 0; x < LEN; x++) {
+                    r.reached[x] = lanes[REACHED][x][m];
+                    for(unsigned b = 0; b < BITS; b++) {
+                        r.plane[b][x] = planes[b][x][m];
+                    }
+                    counts[0] += __builtin_popcount(lanes[REACHED][x][m]);
+                    for(unsigned k = 1; k <= 4; k++) {
+                        counts[k] += __builtin_popcount(lanes[DEGREE1 + k - 1][x][m]);
+                    }
+                }
+                r.cells = counts[0];
+                r.degree[1] = counts[1];
+                r.degree[2] = counts[2];
+                r.degree[3] = counts[3];
+                r.degree[4] = counts[4];
+                r.degree[0] = counts[0] - counts[1] - counts[2] - counts[3] - counts[4];
+                r.pathLength = r.distance(0, 0);
+            }
+            return d;
+        }
+
+        /**
+         * Flood a whole corpus, WIDTH mazes at a time.
+         * @return number of batches
+         */
+        size_t floodAll(const std::vector<Walls<LEN> > &mazes, std::vector<Result<LEN> > &results) {
+            results.resize(mazes.size());
+            size_t batches = 0;
+            for(size_t first = 0; first < mazes.size(); first += WIDTH) {
+                const size_t left = mazes.size() - first;
+                flood(&mazes[first], &results[first], left < WIDTH ? left : WIDTH);
+                batches++;
+            }
+            return batches;
+        }
+
+    protected:
+        // rows of lanes, the way between the mazes and the registers.
+        enum { NORTH, EAST, FRONT, REACHED, DEGREE1, DEGREE2, DEGREE3, DEGREE4, ROWS };
+
+        alignas(32) Column lanes[ROWS][LEN][WIDTH];
+        alignas(32) Column planes[BITS][LEN][WIDTH];
+    };
+}
+
+#endif
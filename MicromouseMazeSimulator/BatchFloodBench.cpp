@@ -0,0 +1,221 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <chrono>
+#include <vector>
+#include "MazeDefinitions.h"
+#include "BatchFlood.h"
+
+/**
+ * Distance fields, shortest path lengths and branching statistics of a whole corpus of mazes.
+ *
+ * The corpus is every built-in maze of the size followed by generated ones. It is flooded
+ * one maze at a time by a plain breadth first search, then WIDTH mazes at a time by
+ * BatchFlood, both timed in mazes per second. The batch has to give every cell of every
+ * maze the distance of the plain search.
+ */
+
+// breadth first distances from the center, one maze at a time, with the degree histogram of BatchFlood.
+template <unsigned LEN>
+void floodOne(const BatchFlood::Walls<LEN> &walls, uint16_t distance[LEN][LEN], unsigned degree[5], unsigned &cells) {
+    for(unsigned x = 0; x < LEN; x++) {
+        for(unsigned y = 0; y < LEN; y++) {
+            distance[x][y] = BatchFlood::UNREACHED;
+        }
+    }
+    unsigned queue[LEN * LEN];
+    unsigned tail = 0;
+    const unsigned mid = LEN / 2;
+    for(unsigned x = mid - 1; x <= mid; x++) {
+        for(unsigned y = mid - 1; y <= mid; y++) {
+            distance[x][y] = 0;
+            queue[tail++] = x * LEN + y;
+        }
+    }
+    for(unsigned k = 0; k < 5; k++) {
+        degree[k] = 0;
+    }
+    for(unsigned head = 0; head < tail; head++) {
+        const unsigned x = queue[head] / LEN;
+        const unsigned y = queue[head] % LEN;
+        const uint16_t d = distance[x][y] + 1;
+        const bool north = walls.isNorthOpen(x, y);
+        const bool south = y > 0 && walls.isNorthOpen(x, y - 1);
+        const bool east = walls.isEastOpen(x, y);
+        const bool west = x > 0 && walls.isEastOpen(x - 1, y);
+        degree[north + south + east + west]++;
+        if(north && distance[x][y + 1] == BatchFlood::UNREACHED) {
+            distance[x][y + 1] = d;
+            queue[tail++] = queue[head] + 1;
+        }
+        if(south && distance[x][y - 1] == BatchFlood::UNREACHED) {
+            distance[x][y - 1] = d;
+            queue[tail++] = queue[head] - 1;
+        }
+        if(east && distance[x + 1][y] == BatchFlood::UNREACHED) {
+            distance[x + 1][y] = d;
+            queue[tail++] = queue[head] + LEN;
+        }
+        if(west && distance[x - 1][y] == BatchFlood::UNREACHED) {
+            distance[x - 1][y] = d;
+            queue[tail++] = queue[head] - LEN;
+        }
+    }
+    cells = tail;
+}
+
+// best time in nanoseconds of as many calls to flood as fit in minSeconds, at least two.
+template <typename Flood>
+double bestOf(double minSeconds, Flood flood) {
+    double best = 0;
+    double spent = 0;
+    for(unsigned run = 0; run < 2 || spent < minSeconds * 1e9; run++) {
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        flood();
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        spent += nanos;
+        if(run == 0 || nanos < best) {
+            best = nanos;
+        }
+    }
+    return best;
+}
+
+template <unsigned LEN>
+int run(unsigned generated, unsigned loops, double minSeconds, const char *csvFile) {
+    const unsigned builtIn = MazeDefinitions::Encodings<LEN>::COUNT;
+    std::vector<BatchFlood::Walls<LEN> > corpus;
+    for(unsigned i = 0; i < builtIn; i++) {
+        corpus.push_back(BatchFlood::Walls<LEN>(MazeDefinitions::Encodings<LEN>::get(i)));
+    }
+    for(unsigned i = 0; i < generated; i++) {
+        corpus.push_back(BatchFlood::Walls<LEN>());
+        corpus.back().generate(i + 1, loops);
+    }
+
+    // one maze at a time.
+    std::vector<uint16_t> distances(corpus.size() * LEN * LEN);
+    std::vector<unsigned> cells(corpus.size());
+    std::vector<unsigned> degrees(corpus.size() * 5);
+    const double single = bestOf(minSeconds, [&]() {
+        for(size_t m = 0; m < corpus.size(); m++) {
+            floodOne<LEN>(corpus[m], (uint16_t (*)[LEN])&distances[m * LEN * LEN], &degrees[m * 5], cells[m]);
+        }
+    });
+
+    // WIDTH at a time.
+    BatchFlood::Batch<LEN> batch;
+    std::vector<BatchFlood::Result<LEN> > results;
+    const double batched = bestOf(minSeconds, [&]() { batch.floodAll(corpus, results); });
+
+    size_t mismatches = 0;
+    for(size_t m = 0; m < corpus.size(); m++) {
+        bool same = results[m].cells == cells[m];
+        for(unsigned k = 0; k < 5; k++) {
+            same &= results[m].degree[k] == degrees[m * 5 + k];
+        }
+        for(unsigned x = 0; x < LEN; x++) {
+            for(unsigned y = 0; y < LEN; y++) {
+                same &= results[m].distance(x, y) == distances[(m * LEN + x) * LEN + y];
+            }
+        }
+        mismatches += !same;
+    }
+
+    std::cout << LEN << " x " << LEN << ": " << builtIn << " built-in and " << generated << " generated mazes ("
+              << loops << " loops each), " << BatchFlood::instructionSet() << ", "
+              << BatchFlood::Batch<LEN>::WIDTH << " mazes per pass" << std::endl;
+    std::cout << "maze  path  cells  dead ends  corridors  3-way  4-way" << std::endl;
+    for(unsigned m = 0; m < builtIn; m++) {
+        const BatchFlood::Result<LEN> &r = results[m];
+        std::cout << std::setw(4) << m << std::setw(6) << r.pathLength << std::setw(7) << r.cells
+                  << std::setw(11) << r.degree[1] << std::setw(11) << r.degree[2]
+                  << std::setw(7) << r.degree[3] << std::setw(7) << r.degree[4] << std::endl;
+    }
+
+    // the generated part of the corpus as a whole.
+    if(generated) {
+        unsigned shortest = BatchFlood::UNREACHED, longest = 0;
+        double path = 0, deadEnds = 0, junctions = 0;
+        for(size_t m = builtIn; m < corpus.size(); m++) {
+            const BatchFlood::Result<LEN> &r = results[m];
+            shortest = r.pathLength < shortest ? r.pathLength : shortest;
+            longest = r.pathLength > longest ? r.pathLength : longest;
+            path += r.pathLength;
+            deadEnds += r.degree[1];
+            junctions += r.degree[3] + r.degree[4];
+        }
+        std::cout << "generated: path " << shortest << " to " << longest << ", mean " << std::fixed << std::setprecision(1)
+                  << path / generated << ", " << deadEnds / generated << " dead ends and "
+                  << junctions / generated << " junctions per maze" << std::endl;
+    }
+
+    std::cout << "           total (ms)  mazes/s" << std::endl;
+    std::cout << "one maze  " << std::fixed << std::setprecision(3) << std::setw(11) << single / 1e6
+              << std::setprecision(0) << std::setw(9) << corpus.size() / (single / 1e9) << std::endl;
+    std::cout << "batched   " << std::fixed << std::setprecision(3) << std::setw(11) << batched / 1e6
+              << std::setprecision(0) << std::setw(9) << corpus.size() / (batched / 1e9)
+              << std::setprecision(2) << "  (" << single / batched << "x)" << std::endl;
+
+    if(csvFile) {
+        std::ofstream csv(csvFile);
+        csv << "maze,path,cells,degree0,degree1,degree2,degree3,degree4" << std::endl;
+        for(size_t m = 0; m < corpus.size(); m++) {
+            const BatchFlood::Result<LEN> &r = results[m];
+            csv << m << "," << r.pathLength << "," << r.cells;
+            for(unsigned k = 0; k < 5; k++) {
+                csv << "," << r.degree[k];
+            }
+            csv << std::endl;
+        }
+    }
+
+    if(mismatches) {
+        std::cout << "FAIL: " << mismatches << " mazes flooded differently one at a time and batched" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned size = 16;
+    unsigned generated = 10000;
+    int loops = -1;
+    double minSeconds = 0.2;
+    const char *csvFile = NULL;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            generated = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            minSeconds = atof(argv[++i]);
+        } else if(strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+            csvFile = argv[++i];
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-s 16|32] [-n N] [-l N] [-t SECONDS] [-o FILE]" << std::endl;
+            std::cout << "\t-s 16|32 will flood mazes of this size (default 16)" << std::endl;
+            std::cout << "\t-n N will add N generated mazes to the built-in ones (default 10000)" << std::endl;
+            std::cout << "\t-l N will remove N extra walls of each generated maze to make loops (default 32 for 16x16, 128 for 32x32)" << std::endl;
+            std::cout << "\t-t SECONDS will repeat each flood of the corpus for at least this long and keep the best time (default 0.2)" << std::endl;
+            std::cout << "\t-o FILE will write the path length, reachable cells and degree histogram of every maze as CSV" << std::endl;
+            return -1;
+        }
+    }
+
+    switch(size) {
+        case MazeDefinitions::MAZE_LEN:
+            return run<MazeDefinitions::MAZE_LEN>(generated, loops < 0 ? 2 * MazeDefinitions::MAZE_LEN : loops, minSeconds, csvFile);
+        case MazeDefinitions::HALF_SIZE_MAZE_LEN:
+            return run<MazeDefinitions::HALF_SIZE_MAZE_LEN>(generated, loops < 0 ? 4 * MazeDefinitions::HALF_SIZE_MAZE_LEN : loops, minSeconds, csvFile);
+        default:
+            std::cout << "Size must be " << MazeDefinitions::MAZE_LEN << " or " << MazeDefinitions::HALF_SIZE_MAZE_LEN << std::endl;
+            return -1;
+    }
+}
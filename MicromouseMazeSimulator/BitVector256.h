@@ -1,30 +1,39 @@
 #ifndef BitVector256_h
 #define BitVector256_h
 
-#include <stdint.h> // uint16_t
+#include <stdint.h> // uint16_t, uint32_t
 #include <cstring> // memset
+#include <type_traits> // std::conditional
 
-class BitVector256 {
+/**
+ * One bit per cell of a VECTOR_SIZE x VECTOR_SIZE maze, a word per column.
+ */
+template <unsigned SIZE>
+class BitVector {
 public:
-    static const unsigned VECTOR_SIZE = 16;
+    static const unsigned VECTOR_SIZE = SIZE;
 
-    BitVector256() {
+    static_assert(VECTOR_SIZE <= 32, "a column has to fit in a 32 bit word");
+
+    typedef typename std::conditional<VECTOR_SIZE <= 16, uint16_t, uint32_t>::type Column;
+
+    BitVector() {
         clearAll();
     }
 
     inline void set(unsigned x, unsigned y) {
         if(x < VECTOR_SIZE && y < VECTOR_SIZE)
-            vector[x] |= 1<<y;
+            vector[x] |= (Column)1<<y;
     }
 
     inline void clear(unsigned x, unsigned y) {
         if(x < VECTOR_SIZE && y < VECTOR_SIZE)
-            vector[x] &= ~(1<<y);
+            vector[x] &= ~((Column)1<<y);
     }
 
     inline bool get(unsigned x, unsigned y) const {
         if(x < VECTOR_SIZE && y < VECTOR_SIZE)
-            return (vector[x] & 1<<y) != 0;
+            return (vector[x] & (Column)1<<y) != 0;
 
         return 0;
     }
@@ -37,8 +46,21 @@ public:
         memset(vector, ~0, sizeof(vector));
     }
 
+    inline unsigned count() const {
+        unsigned n = 0;
+        for(unsigned i = 0; i < VECTOR_SIZE; i++) {
+            for(Column bits = vector[i]; bits; bits &= bits - 1) {
+                n++;
+            }
+        }
+        return n;
+    }
+
 protected:
-    uint16_t vector[(VECTOR_SIZE * VECTOR_SIZE) / (8*sizeof(uint16_t))];
+    Column vector[VECTOR_SIZE];
 };
 
+// the classic 16x16 maze
+typedef BitVector<16> BitVector256;
+
 #endif
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <chrono>
+#include <vector>
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "MouseSession.h"
+#include "CoroutineFinder.h"
+
+/**
+ * Thousands of coroutine mice on one thread.
+ *
+ * Every built-in maze of the size gets N wall followers, half of them keeping a hand on the
+ * left wall, half on the right, all run by one Coroutine::Scheduler a movement at a time.
+ * Each mouse has to make as many movements as the same finder run alone with MouseSession::start.
+ */
+
+template <unsigned LEN>
+bool isAtCenter(unsigned x, unsigned y) {
+    const unsigned mid = LEN / 2;
+    return (x == mid || x == mid - 1) && (y == mid || y == mid - 1);
+}
+
+// LeftWallFollower (main.cpp) as straight-line code, for either hand.
+template <unsigned LEN>
+Coroutine::Program wallFollower(Coroutine::FrameArena &arena, const Coroutine::Senses &senses, bool leftHand) {
+    (void)arena;
+    const MouseMovement towardHand = leftHand ? TurnCounterClockwise : TurnClockwise;
+    const MouseMovement awayFromHand = leftHand ? TurnClockwise : TurnCounterClockwise;
+    bool visitedStart = false;
+    for(;;) {
+        if(isAtCenter<LEN>(senses.x, senses.y))
+            co_return;
+        // back at the start: the center cannot be found this way.
+        if(senses.x == 0 && senses.y == 0) {
+            if(visitedStart)
+                co_return;
+            visitedStart = true;
+        }
+
+        const bool handWall = leftHand ? senses.leftWall : senses.rightWall;
+        if(!handWall) {
+            // take the opening on the side of the hand.
+            co_yield towardHand;
+            co_yield MoveForward;
+        } else if(!senses.frontWall) {
+            co_yield MoveForward;
+        } else {
+            co_yield awayFromHand;
+        }
+    }
+}
+
+template <unsigned LEN>
+int run(unsigned miceEach) {
+    const unsigned mazes = MazeDefinitions::Encodings<LEN>::COUNT;
+    Coroutine::FrameArena arena;
+
+    // each finder alone, through the PathFinder adapter.
+    std::vector<unsigned long> reference(2 * mazes);
+    for(unsigned m = 0; m < mazes; m++) {
+        for(unsigned hand = 0; hand < 2; hand++) {
+            Coroutine::BasicCoroutineFinder<LEN> finder;
+            finder.run(wallFollower<LEN>(arena, finder.getSenses(), hand == 0));
+            BasicMouseSession<LEN> session(BasicMazeWorld<LEN>::get(m), &finder);
+            session.start();
+            reference[2 * m + hand] = session.getStepCount();
+        }
+    }
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    Coroutine::Scheduler<LEN> scheduler(arena);
+    for(unsigned m = 0; m < mazes; m++) {
+        for(unsigned i = 0; i < miceEach; i++) {
+            scheduler.add(BasicMazeWorld<LEN>::get(m), wallFollower<LEN>, i % 2 == 0);
+        }
+    }
+    const std::chrono::steady_clock::time_point added = std::chrono::steady_clock::now();
+    const unsigned long movements = scheduler.run();
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < scheduler.size(); i++) {
+        const unsigned m = i / miceEach;
+        const unsigned hand = (i % miceEach) % 2;
+        mismatches += scheduler.getSession(i).getStepCount() != reference[2 * m + hand];
+    }
+
+    const double setupNanos = std::chrono::duration<double, std::nano>(added - begin).count();
+    const double runNanos = std::chrono::duration<double, std::nano>(end - added).count();
+    std::cout << LEN << "x" << LEN << ": " << scheduler.size() << " mice on one thread, " << miceEach << " in each of "
+              << mazes << " mazes" << std::endl;
+    for(unsigned m = 0; m < mazes; m++) {
+        std::cout << "Maze " << m << ": left hand " << reference[2 * m] << " movements, right hand "
+                  << reference[2 * m + 1] << " movements" << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(1)
+              << "Setup: " << setupNanos / 1e6 << " ms, " << setupNanos / scheduler.size() << " ns per mouse" << std::endl
+              << "Run: " << movements << " movements in " << runNanos / 1e6 << " ms, "
+              << runNanos / movements << " ns per movement" << std::endl
+              << "Memory: " << arena.getBytes() / 1024.0 << " KB of coroutine frames (" << arena.getLive() << " live), "
+              << sizeof(BasicMouseSession<LEN>) + sizeof(Coroutine::BasicCoroutineFinder<LEN>) << " bytes of session and finder per mouse" << std::endl;
+
+    if(mismatches) {
+        std::cout << "FAIL: " << mismatches << " mice moved differently together than alone" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned size = MazeDefinitions::MAZE_LEN;
+    unsigned miceEach = 1000;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            miceEach = atoi(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-s 16|32] [-n N]" << std::endl;
+            std::cout << "\t-s 16|32 will run the mice in the mazes of this size (default 16)" << std::endl;
+            std::cout << "\t-n N will put N mice in every maze (default 1000)" << std::endl;
+            return -1;
+        }
+    }
+
+    switch(size) {
+        case MazeDefinitions::MAZE_LEN:
+            return run<MazeDefinitions::MAZE_LEN>(miceEach);
+        case MazeDefinitions::HALF_SIZE_MAZE_LEN:
+            return run<MazeDefinitions::HALF_SIZE_MAZE_LEN>(miceEach);
+        default:
+            std::cout << "Size must be " << MazeDefinitions::MAZE_LEN << " or " << MazeDefinitions::HALF_SIZE_MAZE_LEN << std::endl;
+            return -1;
+    }
+}
@@ -0,0 +1,321 @@
+#ifndef CoroutineFinder_h
+#define CoroutineFinder_h
+
+#if !defined(__cpp_impl_coroutine)
+#error "CoroutineFinder.h needs C++20 coroutines, build with -std=c++20"
+#endif
+
+#include <coroutine>
+#include <cstddef>  // size_t
+#include <cstdlib>  // malloc, free
+#include <new>      // std::bad_alloc
+#include <vector>
+#include <deque>
+#include <utility>  // std::pair
+
+#include "MouseSession.h"
+#include "PathFinder.h"
+
+/**
+ * PathFinders written as straight-line code.
+ *
+ * A finder is a coroutine returning Coroutine::Program that co_yields the movements of the
+ * mouse, one at a time, and looks at the walls around it in Senses in between:
+ *
+ *     Coroutine::Program forward(Coroutine::FrameArena &arena, const Coroutine::Senses &senses) {
+ *         while(!senses.frontWall)
+ *             co_yield MoveForward;
+ *     }
+ *
+ * Where it is in the search is where it is in the code, instead of a mode and flags kept in
+ * members between nextMovement calls. Returning from the coroutine is MouseMovement::Finish.
+ *
+ * The first argument of every finder is the FrameArena its frame is allocated from, the
+ * compiler passes it to the frame's operator new. BasicCoroutineFinder adapts a program to
+ * BasicPathFinder, and Scheduler runs thousands of them on one thread, a movement at a time.
+ */
+namespace Coroutine {
+    /**
+     * Coroutine frames, carved out of large blocks. A released frame is kept for the next
+     * frame of the same size, which in a sweep is the next run of the same finder.
+     * Not thread safe, use one arena per thread.
+     */
+    class FrameArena {
+    public:
+        explicit FrameArena(size_t blockBytes = 1 << 16)
+        : blockBytes(blockBytes), cursor(NULL), left(0), bytes(0), live(0) {}
+
+        ~FrameArena() {
+            for(size_t i = 0; i < blocks.size(); i++) {
+                free(blocks[i]);
+            }
+        }
+
+        void *allocate(size_t size) {
+            const size_t total = round(size);
+            live++;
+            for(size_t i = 0; i < freeFrames.size(); i++) {
+                if(freeFrames[i].first == total && freeFrames[i].second) {
+                    Header *h = freeFrames[i].second;
+                    freeFrames[i].second = h->next;
+                    h->arena = this;
+                    return h + 1;
+                }
+            }
+            if(total > left) {
+                const size_t n = total > blockBytes ? total : blockBytes;
+                cursor = (char *)malloc(n);
+                if(!cursor)
+                    throw std::bad_alloc();
+                blocks.push_back(cursor);
+                left = n;
+                bytes += n;
+            }
+            Header *h = (Header *)cursor;
+            cursor += total;
+            left -= total;
+            h->arena = this;
+            return h + 1;
+        }
+
+        // give a frame back to the arena it came from.
+        static void release(void *frame, size_t size) {
+            Header *h = (Header *)frame - 1;
+            h->arena->reuse(h, round(size));
+        }
+
+        // bytes taken from the system so far.
+        inline size_t getBytes() const {
+            return bytes;
+        }
+
+        // frames allocated and not released.
+        inline size_t getLive() const {
+            return live;
+        }
+
+    protected:
+        // in front of every frame: the arena while allocated, the next free frame once released.
+        union alignas(16) Header {
+            FrameArena *arena;
+            Header *next;
+        };
+
+        static inline size_t round(size_t size) {
+            return sizeof(Header) + ((size + sizeof(Header) - 1) & ~(sizeof(Header) - 1));
+        }
+
+        void reuse(Header *h, size_t total) {
+            live--;
+            for(size_t i = 0; i < freeFrames.size(); i++) {
+                if(freeFrames[i].first == total) {
+                    h->next = freeFrames[i].second;
+                    freeFrames[i].second = h;
+                    return;
+                }
+            }
+            h->next = NULL;
+            freeFrames.push_back(std::make_pair(total, h));
+        }
+
+        size_t blockBytes;
+        std::vector<char *> blocks;
+        char *cursor;
+        size_t left;
+        // free frames by size. There are as many sizes as there are finders.
+        std::vector<std::pair<size_t, Header *> > freeFrames;
+        size_t bytes;
+        size_t live;
+    };
+
+    // what the mouse knows each time its program is resumed.
+    struct Senses {
+        Senses() : x(0), y(0), frontWall(false), leftWall(false), rightWall(false) {}
+
+        unsigned x;
+        unsigned y;
+        bool frontWall;
+        bool leftWall;
+        bool rightWall;
+    };
+
+    /**
+     * A running finder: the handle of its coroutine, destroyed with the Program.
+     */
+    class Program {
+    public:
+        struct promise_type {
+            MouseMovement movement;
+
+            promise_type() : movement(Finish) {}
+
+            Program get_return_object() {
+                return Program(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            // the finder starts on the first call to next, when there are senses to look at.
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(MouseMovement m) noexcept {
+                movement = m;
+                return {};
+            }
+            void return_void() noexcept {
+                movement = Finish;
+            }
+            void unhandled_exception() {
+                throw;
+            }
+
+            // the frame comes from the arena given as the finder's first argument.
+            // There is no operator new(size_t), so a finder without an arena does not compile.
+            template <typename... Args>
+            static void *operator new(size_t size, FrameArena &arena, Args &...) {
+                return arena.allocate(size);
+            }
+            static void operator delete(void *frame, size_t size) {
+                FrameArena::release(frame, size);
+            }
+        };
+
+        Program() : handle(NULL) {}
+
+        explicit Program(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        Program(Program &&other) : handle(other.handle) {
+            other.handle = NULL;
+        }
+
+        Program &operator=(Program &&other) {
+            if(this != &other) {
+                if(handle)
+                    handle.destroy();
+                handle = other.handle;
+                other.handle = NULL;
+            }
+            return *this;
+        }
+
+        ~Program() {
+            if(handle)
+                handle.destroy();
+        }
+
+        /**
+         * Run the finder up to its next movement.
+         * @return the movement, Finish once the finder has returned
+         */
+        inline MouseMovement next() {
+            if(!handle || handle.done())
+                return Finish;
+            handle.resume();
+            return handle.done() ? Finish : handle.promise().movement;
+        }
+
+    private:
+        Program(const Program &);
+        Program &operator=(const Program &);
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    /**
+     * A Program as a PathFinder. Start the program with the senses of this finder:
+     *
+     *     Coroutine::BasicCoroutineFinder<LEN> finder;
+     *     finder.run(forward(arena, finder.getSenses()));
+     *
+     * The finder must not move while the program runs, the program holds on to its senses.
+     */
+    template <unsigned LEN>
+    class BasicCoroutineFinder : public BasicPathFinder<LEN> {
+    public:
+        inline const Senses &getSenses() const {
+            return senses;
+        }
+
+        void run(Program newProgram) {
+            program = std::move(newProgram);
+        }
+
+        MouseMovement nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze) {
+            senses.x = x;
+            senses.y = y;
+            senses.frontWall = maze.wallInFront();
+            senses.leftWall = maze.wallOnLeft();
+            senses.rightWall = maze.wallOnRight();
+            return program.next();
+        }
+
+    protected:
+        Senses senses;
+        Program program;
+    };
+
+    /**
+     * Many mice on one thread. Every mouse is a MouseSession driven by a BasicCoroutineFinder;
+     * run() moves each unfinished mouse by one movement in turn until all have finished.
+     */
+    template <unsigned LEN>
+    class Scheduler {
+    public:
+        explicit Scheduler(FrameArena &arena) : arena(arena) {}
+
+        /**
+         * Add a mouse.
+         * @param world: maze to run in, shared with any number of mice
+         * @param finder: a finder taking (FrameArena &, const Senses &, args...)
+         * @param args: the rest of the finder's arguments
+         * @return index of the mouse
+         */
+        template <typename Finder, typename... Args>
+        size_t add(const BasicMazeWorld<LEN> &world, Finder finder, Args... args) {
+            // a deque never moves its elements, the sessions and programs point into them.
+            finders.emplace_back();
+            BasicCoroutineFinder<LEN> &f = finders.back();
+            f.run(finder(arena, f.getSenses(), args...));
+            sessions.emplace_back(world, &f);
+            return sessions.size() - 1;
+        }
+
+        /**
+         * Run every mouse to the end.
+         * @return number of movements made, by all the mice together
+         */
+        unsigned long run() {
+            std::vector<size_t> running;
+            running.reserve(sessions.size());
+            for(size_t i = 0; i < sessions.size(); i++) {
+                running.push_back(i);
+            }
+            unsigned long steps = 0;
+            while(!running.empty()) {
+                for(size_t k = 0; k < running.size(); ) {
+                    if(sessions[running[k]].step()) {
+                        steps++;
+                        k++;
+                    } else {
+                        // finished: the last one takes its place.
+                        running[k] = running.back();
+                        running.pop_back();
+                    }
+                }
+            }
+            return steps;
+        }
+
+        inline size_t size() const {
+            return sessions.size();
+        }
+
+        inline const BasicMouseSession<LEN> &getSession(size_t i) const {
+            return sessions[i];
+        }
+
+    protected:
+        FrameArena &arena;
+        std::deque<BasicCoroutineFinder<LEN> > finders;
+        std::deque<BasicMouseSession<LEN> > sessions;
+    };
+}
+
+#endif
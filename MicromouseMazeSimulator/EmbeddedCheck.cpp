@@ -0,0 +1,61 @@
+#include <iostream>
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "MouseMovement.h"
+#include "FloodFillEmbedded.h"
+
+/**
+ * Runs the freestanding FloodFill (FloodFillEmbedded.cpp, built the way make embedded builds it)
+ * through every built-in classic maze, the way the firmware would: only through its C interface,
+ * keeping track of the pose itself. The steps are those of ./run -q -m N.
+ */
+
+int main() {
+    const unsigned len = MazeDefinitions::MAZE_LEN;
+    const unsigned long stepLimit = 16 * len * len;
+    int failed = 0;
+    for(unsigned m = 0; m < MazeDefinitions::Encodings<len>::COUNT; m++) {
+        const MazeWorld &world = MazeWorld::get(m);
+        unsigned x = 0, y = 0;
+        Dir heading = NORTH;
+        unsigned long steps = 0;
+        bool finished = false;
+
+        floodFillReset();
+        while(!finished && steps < stepLimit) {
+            const MouseMovement movement = (MouseMovement)floodFillNextMovement(x, y,
+                !world.isOpen(x, y, heading), !world.isOpen(x, y, counterClockwise(heading)), !world.isOpen(x, y, clockwise(heading)));
+            switch(movement) {
+                case MoveForward:
+                case MoveBackward: {
+                    const Dir d = movement == MoveForward ? heading : opposite(heading);
+                    if(!world.isOpen(x, y, d)) {
+                        std::cout << "Maze " << m << ": crashed into a wall at (" << x << "," << y << ") after " << steps << " steps" << std::endl;
+                        return 1;
+                    }
+                    x += d == EAST ? 1 : d == WEST ? -1 : 0;
+                    y += d == NORTH ? 1 : d == SOUTH ? -1 : 0;
+                    break;
+                }
+                case TurnClockwise:
+                    heading = clockwise(heading);
+                    break;
+                case TurnCounterClockwise:
+                    heading = counterClockwise(heading);
+                    break;
+                case TurnAround:
+                    heading = opposite(heading);
+                    break;
+                case Wait:
+                    break;
+                case Finish:
+                    finished = true;
+                    continue;
+            }
+            steps++;
+        }
+        std::cout << "Maze " << m << ": " << steps << " steps" << (finished ? "" : ", cut off") << std::endl;
+        failed |= !finished;
+    }
+    return failed;
+}
@@ -1,882 +1,781 @@
 #include <iostream>
+#include <sstream>
 #include <cstdlib>  // atoi
-#include "Maze.h"
+#include <cstring>  // memset, strcmp
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm> // std::max
+#include "MouseSession.h"
 #include "MazeDefinitions.h"
-#include "PathFinder.h"
-#include <stack>
-#include <queue>
-#define INFINITY 10*MazeDefinitions::MAZE_LEN
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "AllocStats.h"
+#include "Log.h"
+#include "RelaxKernel.h"
+#include "ResultCache.h"
+#include "Replay.h"
+#include "LiveView.h"
+#include "Oracle.h"
+#include "Adversary.h"
+#include "FloodFill.h"
 
 /**
- * Our implementation.
- * Use floodfill algorithm to traverse the maze and to find shortest path.
- * For clarity, sost class functions implementation is at the bottom of this file.
- * 
- * Basic idea:
- * [1] use flood fill algorithm(see the slides) to search the center
- * [2] when at the center, reassign distance values of all cells based on 
- *     the actual distance from the cell to the center.
- * [3] construct the shortest 'route' between center and origin
- * [4] use the 'route' to run back home to finish search run
- * [5] use the 'route' to run to center for speed run
- * [6] use the 'route' to run back home for speed run 
- **  
-
-   Initial values:
-   Manhattan Distance = 
-   use getMDistance to obtain this.
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 15 |14 |13 |12 |11 |10 | 9 | 8 | 7 | 7 | 8 | 9 |10 |11 |12 |13 |14 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 14 |13 |12 |11 |10 | 9 | 8 | 7 | 6 | 6 | 7 | 8 | 9 |10 |11 |12 |13 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 13 |12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 5 | 6 | 7 | 8 | 9 |10 |11 |12 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 4 | 5 | 6 | 7 | 8 | 9 |10 |11 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |10 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 9  | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 8  | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 | 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 |  
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 7  | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 | 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 6  | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 5  | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 4  |10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |10 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 3  |11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 4 | 5 | 6 | 7 | 8 | 9 |10 |11 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 2  |12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 5 | 6 | 7 | 8 | 9 |10 |11 |12 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 1  |13 |12 |11 |10 | 9 | 8 | 7 | 6 | 6 | 7 | 8 | 9 |10 |11 |12 |13 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
- 0  |14 |13 |12 |11 |10 | 9 | 8 | 7 | 7 | 8 | 9 |10 |11 |12 |13 |14 |
-    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
-     0    1   2   3   4   5   6   7   8   9  10  11  12  13  14  15 
+ * The simulator: runs FloodFill (FloodFill.h) through the built-in mazes, and the reports and
+ * searches built on those runs. See the usage in main.
  */
 
-// similar to LeftWallFollower. JK, not really.
-class FloodFill : public PathFinder {
-public:
-
-
-    /*******
-     * 
-     * Helper Structures
-     *
-     **/
-
-    // algorithm mode
-    enum Mode
-    {
-        MODE_SEARCH,        // finding distances. Mouse should be at the center when done searching.
-        MODE_BACK_HOME,     // After we reach center, find a way to go back home.    
-        MODE_FAST,          // second run to center. Speed run.
-        MODE_FAST_BACK_HOME // second run to origin
-    };
-
-    /**
-     * Cell structure contains information of a single cell of the map.
-     * info includes:  
-     * bool northWall, southWall, eastWall, westWall
-     *      4 adjacent wall status.
-     *      When the mouse walks through the cell, it records the adjacent wall status.
-     * unsigned distance:
-     *      initially, 'distance' hold Manhatan distance(see the above illustration). 
-     *      This value will be modified after applying floodfill algorithm (step 2).
-     * bool visited:
-     *      Tells us whether or not the mouse has visited this cell. We need this because 
-     *      only the cell that the mouse has visited has valid wall status. So before we check
-     *      wall status, we need to make sure that the cell is visited.
-     */
-    struct Cell{
-        Cell(){
-            northWall = true;
-            southWall = true;
-            eastWall = true;
-            westWall = true;
-            visited = false;
-        }
-        void setWall(Dir d, bool set = false){
-            switch(d){
-                case NORTH: 
-                    northWall = set;
-                    break;
-                case SOUTH: 
-                    southWall = set;
-                    break;
-                case EAST: 
-                    eastWall = set;
-                    break;
-                case WEST: 
-                    westWall = set;
-                    break;
-            }
-        }
-        void setDistance(unsigned newDistance){
-            distance = newDistance;
-        }
+// command line options, see the usage in main.
+struct Options {
+    unsigned maze;
+    unsigned size;
+    bool pause;
+    bool verbose;
+    bool demo;
+    bool quiet;
+    bool async;
+    long budgetMicros;
+    const char *tracePath;
+    bool json;
+    unsigned repeat;
+    bool relax;
+    const char *cachePath;
+    const char *replayPath;
+    const char *liveName;
+    unsigned long forkStep;
+    SensorRange sensors;
+    bool sensorReport;
+    bool oracle;
+    unsigned long evaluations;
+    const char *mazePath;
+    unsigned long stepLimit;
+    long timeLimitMillis;
+};
 
-        bool northWall;
-        bool southWall;
-        bool eastWall;
-        bool westWall;
-        bool visited;
-        unsigned distance;
-        unsigned cx, cy;
-    };
+// cut a run off after the step limit (-n, or 16 steps per cell) and the time limit (-u),
+// or as soon as it loops. A run that has not finished by then is going around in circles.
+template <unsigned LEN>
+void setLimits(BasicMouseSession<LEN> &maze, const Options &options) {
+    maze.setStepLimit(options.stepLimit ? options.stepLimit : 16 * MazeDefinitions::Size<LEN>::CELLS);
+    if(options.timeLimitMillis > 0)
+        maze.setRunTimeLimit(std::chrono::milliseconds(options.timeLimitMillis));
+    maze.setLoopDetection(true);
+}
 
-    // initial setup
-    FloodFill(bool shouldPause = false, bool shouldPrint = false, bool shouldDemo = false) : pause(shouldPause), verbose(shouldPrint), demo(shouldDemo) {
-        // define initial heading to be north
-        currHeading = NORTH;
-        // default mode is search mode.
-        mode = MODE_SEARCH;
-        // construct map with Manhatan distances
-        for (int r = 0; r != MazeDefinitions::MAZE_LEN; r++){
-            for (int c = 0; c != MazeDefinitions::MAZE_LEN; c++){
-                map[r][c].distance=getManDistance(r,c);
-                map[r][c].cx = r;
-                map[r][c].cy = c;
-            }
-        }      
+// run the mouse through a LEN x LEN maze.
+template <unsigned LEN>
+int simulate(const Options &options) {
+    if(options.tracePath)
+        Trace::enable();
+#ifdef PERF_COUNTERS
+    PerfCounters::setMaze(options.maze);
+#endif
+
+    // every wall closed unless a maze is loaded.
+    unsigned char encoding[LEN][LEN];
+    memset(encoding, 15, sizeof(encoding));
+    if(options.mazePath && !BasicMazeWorld<LEN>::load(options.mazePath, encoding)) {
+        std::cout << "Cannot load a " << LEN << "x" << LEN << " maze from " << options.mazePath << std::endl;
+        return 1;
     }
-
-
-    // boss function 
-    MouseMovement nextMovement(unsigned x, unsigned y, const Maze &maze) {
-        // get current cell wall status. (using IR sensors)
-        frontWall = maze.wallInFront();
-        leftWall  = maze.wallOnLeft();
-        rightWall = maze.wallOnRight();
-        // obtain the distance of the current cell that the mouse is at.
-        currMDistance = map[x][y].distance;
-
-        // obtain the current heading
-        setHead(currHeading, retval);
-        // currHeading = maze.getHeading();   // North | South | East | West
-
-        const unsigned mid = MazeDefinitions::MAZE_LEN / 2;
-
-        // Pause at each cell if the user requests it.
-        // It allows for better viewing on command line.
-        if(pause) {
-            std::cout << "Hit enter to continue..., (" << x << "," << y << "), M=" << currMDistance << " head " << currHeading << std::endl;
-            std::cin.ignore(10000, '\n');
-            std::cin.clear();
-        }
-
+    const BasicMazeWorld<LEN> loaded(encoding);
+    const BasicMazeWorld<LEN> &world = options.mazePath ? loaded : BasicMazeWorld<LEN>::get(options.maze);
+
+    BasicFloodFill<LEN> floodfill(options.pause, options.verbose, options.demo, options.quiet, options.async, options.relax);
+    BasicMouseSession<LEN> maze(world, &floodfill);
+    maze.setSensorRange(options.sensors);
+    setLimits(maze, options);
+    if(options.budgetMicros > 0)
+        maze.setTimeBudget(std::chrono::microseconds(options.budgetMicros));
+    if(!options.quiet)
         std::cout << maze.draw(5) << std::endl << std::endl;
 
-        // If we somehow miraculously hit the center
-        // of the maze, then:
-        // [1] if it is just for the demo, then we are done.
-        // [2] if it is the search run, then it means we finished searching and we should start heading back home.
-        // [3] if it is the speed run, then we are done done !!!! hoo-ray
-        if(isAtCenter(x, y)) {
-            if(demo){
-                std::cout << "Found center! Good enough for the demo, won't try to get back." << std::endl;
-                return Finish;
-            }
-            if(mode == MODE_FAST){
-                std::cout << "Fast run half way through!" << std::endl;
-                mode = MODE_FAST_BACK_HOME;
-                return TurnAround;
-            }
-            if(mode == MODE_SEARCH){
-                clearVisits();
-                assign_new_dis(&map[x][y]);
-                constructRoute();
-                mode = MODE_BACK_HOME;
-                return TurnAround;
-            }
-        }
-
-        // If we hit the start of the maze a second time, then either
-        // [1] we couldn't find the center and never will...
-        // [2] we've reached end goal of home run.
-        if(x == 0 && y == 0) {
-            if(mode == MODE_BACK_HOME){
-                std::cout << "Back home run finished!" << std::endl;
-                mode = MODE_FAST;
-                return TurnAround;
-            }else if(mode == MODE_SEARCH && visitedStart) {
-                std::cout << "Unable to find center, giving up." << std::endl;
-                return Finish;
-            }else if(mode == MODE_FAST_BACK_HOME){
-                std::cout << "Fast run FINISH!!!!\n";
-                return Finish;
-            } else {
-                visitedStart = true;
-            }
-        }
-
-        // switch to algorithm
-        switch(mode){
-            case MODE_SEARCH:
-                SearchMode(x,y);
-            break;
-            case MODE_BACK_HOME:
-            case MODE_FAST_BACK_HOME:
-                HomeBoundMode(x,y);
-            break;
-            case MODE_FAST:
-                FastMode();
-            break;
-        }
-        return retval;
-            
+    Replay::Writer *replay = NULL;
+    if(options.replayPath) {
+        bool mirrored;
+        const uint64_t hash = maze.getWorld().getCanonicalHash(mirrored);
+        replay = new Replay::Writer(options.replayPath, LEN, maze.getWorld().getName(), hash, mirrored, floodfill.getId(), true);
+        maze.setRecorder(replay);
     }
-
-protected:
-
-    // debugging purpose. When specify -v option, output more stuffs.
-    bool verbose; 
-    // demo. When specify -d option, only run search mode. By default this is false;
-    bool demo;
-
-    Mode mode;
-    // Helps us determine if we've made a loop around the maze without finding the center.
-    bool visitedStart;
-
-    // Indicates we should pause before moving to next cell.
-    // Useful for command line usage.
-    const bool pause;
-
-    // the current Manhattan distance.
-    unsigned currMDistance;
-    // current heading of the mouse. 
-    Dir currHeading;
-
-    unsigned minMDistance;
-    MouseMovement retval;
-
-    // keep track of current neighboring walls status
-    bool frontWall;
-    bool leftWall;
-    bool rightWall;
-
-    // map that holds distances. initially it contains manhatan distances, later on will be modified using floodfill algorithm.
-    Cell map[MazeDefinitions::MAZE_LEN][MazeDefinitions::MAZE_LEN];
-
-    // construct fastest route (stacks) for homebound mode and fast mode
-    // preprocess: construct routeSt1, starting from origin and ending at center
-    // homebound: pop instructions from routeSt1 and push them in routeSt2
-    // fast run: pop instructions from routeSt2 and push them in routeSt1. 
-    std::stack<MouseMovement> routeSt1;
-    std::stack<MouseMovement> routeSt2;
-
-
-    /*******
-     * 
-     * Member Functions Declaration
-     * (Implementation is at the bottom of the file)
-     *
-     **/
-
-    // In the case that we can't have access to the heading in Maze.h, this function helps us keep track of the current heading.
-    // We call this function at the beginning of nextmovement() so we have updated heading. 
-    void setHead(Dir &oldHeading, MouseMovement insn);
-
-    // same as left follower. Check if the mouse is at the center of the maze.
-    bool isAtCenter(unsigned x, unsigned y) const;
-
-    // only used for initial map construction
-    // calculate the Manhattan distances of each cell. (result == the illustration above)
-    unsigned getManDistance(unsigned x, unsigned y);
-
-    // reset visit history of all cells.
-    void clearVisits();
-
-    // for search mode step one. Does two things:
-    // [1] use front, right, left wall status to find min distance.
-    // [2] assign return value.(mouse movement)
-    void find_minDistance_and_nextInsn(unsigned x, unsigned y);
-
-    // Used in constructing route. Very similar to 'find_minDistance_and_nextInsn'.
-    // use front, right, left wall status to find min distance.
-    // The difference is that it only checks the adjacent cells that the mouse has already visited
-    void find_minDistance_and_nextInsn_II(unsigned x, unsigned y, Dir funcHeading);
-
-    // get new values of forwardX and forwardY. 
-    // if current cell is at (x.y)
-    // Cell at the front     ==> (x+forwardX, y+forwardY)
-    // Cell on the right     ==> (x + forwardY, y - forwardX)
-    // Cell on the left      ==> (x - forwardY, y + forwardX)
-    void getForwardXY(unsigned &forwardX, unsigned &forwardY, Dir &heading);
-
-    // use north,south,east,west wall status to find min distance 
-    // when isConstructingRoute is set, check only the cells that the mouse has visited.
-    Cell* findMinDistance(unsigned cx, unsigned cy, bool isConstructingRoute);
-
-    // Call this after the mouse searched the center for the first time.
-    // This function reassign the distance of all cells based on its 'physical' shortest path from the center. (i.e. consider walls)
-    // need to call 'clearVisits' before using this function.
-    void assign_new_dis(Cell* currCell);
-
-    // After the mouse reached the center for the first time and the distances map has been reassigned,
-    // we call this function to construct the 'shortest' route from origin(home) to center.
-    // we have two stacks, routeSt1 and routeSt2. routeSt1 stores the instructions needed to traverse from center to home
-    // routeSt2 will store the same but in reverse order when we run HomeBoundMode because routeSt2 push whatever routeSt1 pop. 
-    void constructRoute();
-
-    // First run searching center
-    void SearchMode(unsigned x, unsigned y);
-
-    // First run going back home and speed run running back home
-    void HomeBoundMode(unsigned x, unsigned y);
-
-    // Speed run running to center
-    void FastMode();
-
-};
-
-
-int main(int argc, char * argv[]) {
-    MazeDefinitions::MazeEncodingName mazeName = MazeDefinitions::MAZE_CAMM_2012;
-    bool pause = false;
-    bool verbose = false;
-    bool demo = false;
-    // Since Windows does not support getopt directly, we will
-    // have to parse the command line arguments ourselves.
-
-    // Skip the program name, start with argument index 1
-    for(int i = 1; i < argc; i++) {
-        if(strcmp(argv[i], "-m") == 0 && i+1 < argc) {
-            int mazeOption = atoi(argv[++i]);
-            if(mazeOption < MazeDefinitions::MAZE_NAME_MAX && mazeOption > 0) {
-                    mazeName = (MazeDefinitions::MazeEncodingName)mazeOption;
-            }
-        } else if(strcmp(argv[i], "-p") == 0) {
-            pause = true;
-        } else if(strcmp(argv[i], "-v") == 0) {
-            verbose = true;
-        } else if(strcmp(argv[i], "-d") == 0) {
-            demo = true;
-        } else {
-            std::cout << "Usage: " << argv[0] << " [-m N] [-p] [-v] [-d]" << std::endl;
-            std::cout << "\t-m N will load the maze corresponding to N, or 0 if invalid N or missing option" << std::endl;
-            std::cout << "\t-p will wait for a newline in between cell traversals" << std::endl;
-            std::cout << "\t-v will output useful debugging info" << std::endl;
-            std::cout << "\t-d will only perform search run" << std::endl;
-            return -1;
-        }
+    LiveView::Publisher *live = NULL;
+    if(options.liveName) {
+        live = new LiveView::Publisher(options.liveName, LEN, maze.getWorld().getName(), true);
+        if(live->good())
+            maze.setPublisher(live);
+        else
+            std::cerr << live->getError() << std::endl;
     }
 
-    FloodFill floodfill(pause, verbose, demo);
-    Maze maze(mazeName, &floodfill);
-    std::cout << maze.draw(5) << std::endl << std::endl;
-
+#ifdef ALLOC_TRACKING
+    // everything from here on is steady state.
+    AllocStats::track(true);
+#endif
     maze.start();
-}
-
-
-/**
- *
- * FloodFill member functions implementation
- *
- */
-
-void FloodFill::setHead(Dir &oldHeading, MouseMovement insn){
-    switch(insn){
-        case TurnAround:
-            oldHeading = opposite(oldHeading);
-            return;
-        case TurnClockwise:
-            oldHeading = clockwise(oldHeading);
-            return;
-        case TurnCounterClockwise:
-            oldHeading = counterClockwise(oldHeading);
-            return;
+    if(options.verbose)
+        Log::flush();
+
+    std::cout << "Steps: " << maze.getStepCount() << " (" << maze.getMovementCount(Wait) << " waiting)" << std::endl;
+    if(maze.getOutcome() == RUN_LOOPED)
+        std::cout << "Cut off: looped, back in the state of step " << maze.getLoopStart() << std::endl;
+    else if(maze.wasCutOff())
+        std::cout << "Cut off: " << runOutcomeName(maze.getOutcome()) << std::endl;
+    if(replay){
+        if(!replay->close())
+            std::cerr << "Could not write replay to " << options.replayPath << std::endl;
+        maze.setRecorder(NULL);
+        delete replay;
+    }
+    if(live){
+        if(live->good())
+            std::cout << "Published " << live->getPublished() << " frames to " << options.liveName << std::endl;
+        maze.setPublisher(NULL);
+        delete live;
+    }
+    if(options.json){
+        maze.writeStats(std::cout);
+        std::cout << std::endl;
     }
-}
 
- bool FloodFill::isAtCenter(unsigned x, unsigned y) const {
-    unsigned midpoint = MazeDefinitions::MAZE_LEN / 2;
+#ifdef PERF_COUNTERS
+    PerfCounters::report(std::cout);
+#endif
+#ifdef ALLOC_TRACKING
+    AllocStats::track(false);
+    AllocStats::report(std::cout, maze.getStepCount());
+    // a headless run must not allocate once it is set up.
+    if(options.quiet && AllocStats::allocations() != 0){
+        std::cout << "FAIL: headless run allocated after initialization" << std::endl;
+        return 1;
+    }
+#endif
 
-    if(MazeDefinitions::MAZE_LEN % 2 != 0) {
-        return x == midpoint && y == midpoint;
+    // stop tracing before the reference run below.
+    if(options.tracePath){
+        Trace::disable();
+        if(!Trace::write(options.tracePath))
+            std::cerr << "Could not write trace to " << options.tracePath << std::endl;
     }
 
-    return  (x == midpoint     && y == midpoint    ) ||
-    (x == midpoint - 1 && y == midpoint    ) ||
-    (x == midpoint     && y == midpoint - 1) ||
-    (x == midpoint - 1 && y == midpoint - 1);
+    if(options.budgetMicros > 0) {
+        // Run again without a budget to see what the deadline cost us. Keep it quiet.
+        BasicFloodFill<LEN> reference(false, false, options.demo, true, false, options.relax);
+        BasicMouseSession<LEN> referenceMaze(world, &reference);
+        referenceMaze.setSensorRange(options.sensors);
+        setLimits(referenceMaze, options);
+        std::streambuf *out = std::cout.rdbuf(NULL);
+        referenceMaze.start();
+        std::cout.rdbuf(out);
+        std::cout.clear();
+
+        const long extraSteps = (long)maze.getStepCount() - (long)referenceMaze.getStepCount();
+        std::cout << "Budget: " << options.budgetMicros << "us, overruns: " << maze.getOverrunCount()
+                  << ", longest move: " << std::chrono::duration_cast<std::chrono::microseconds>(maze.getMaxCallTime()).count() << "us"
+                  << ", suspensions: " << floodfill.getSuspensions() << std::endl;
+        std::cout << "Quality loss: " << extraSteps << " steps over the unbudgeted run ("
+                  << referenceMaze.getStepCount() << " steps)" << std::endl;
+    }
+    return maze.wasCutOff() ? 1 : 0;
 }
 
-
-// only used for initial map construction
-unsigned FloodFill::getManDistance(unsigned x, unsigned y){
-    // error checking
-    if (x >= MazeDefinitions::MAZE_LEN || y >= MazeDefinitions::MAZE_LEN){
-        if(verbose)
-            std::cout << "Error: invalid (x,y) coordinates." << std::endl;
-        return -1;
-    }
-    unsigned mid = MazeDefinitions::MAZE_LEN / 2 ;
-    // lower left section
-    if (x < mid && y < mid)
-        return mid + mid - x - y - 2;
-    // upper left section
-    if (x < mid)
-        return y - x - 1;
-    // lower right section
-    if (y < mid)
-        return x - y - 1;
-    // upper right section
-    return x + y - mid - mid;
-}
-// reset visit history of all cells.
-void FloodFill::clearVisits(){
-    for (int r = 0; r != MazeDefinitions::MAZE_LEN; r++){
-        for (int c = 0; c != MazeDefinitions::MAZE_LEN; c++){
-            map[r][c].visited = false;
+// run every LEN x LEN maze options.repeat times, headless, and print the time per run and per step.
+// Runs cut off by the limits (see setLimits) are counted apart and left out of the steps and times.
+// With a cache directory (-c), a maze already run by the same FloodFill build is not run again,
+// unless it is only to time it: the timings are kept for the simulator build and host that measured them.
+template <unsigned LEN>
+int benchmark(const Options &options) {
+    std::cout << LEN << "x" << LEN << ", " << options.repeat << " runs per maze"
+              << (options.async ? ", background planner" : "")
+              << ", " << (options.relax ? Relax::instructionSet() : "per cell") << " flood kernel" << std::endl;
+
+    ResultCache *cache = options.cachePath ? new ResultCache(options.cachePath) : NULL;
+    const std::string build = cache ? ResultCache::buildId() : "";
+    unsigned cachedMazes = 0, timedAgain = 0;
+    double totalNanos = 0;
+    unsigned long totalSteps = 0, totalRuns = 0, totalCutOff = 0;
+    for(unsigned m = 0; m < MazeDefinitions::Encodings<LEN>::COUNT; m++) {
+        unsigned long steps = 0, cutOff = 0;
+        double nanos = 0;
+        std::string cutOffOutcome;
+        unsigned long refloods = 0, assigns = 0;
+        unsigned long long refloodCycles = 0, assignCycles = 0;
+        ResultCache::Result result;
+        std::string key, timingKey;
+        bool cached = false, timed = false;
+        for(unsigned r = 0; r < options.repeat; r++) {
+            const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            BasicFloodFill<LEN> floodfill(false, false, options.demo, true, options.async, options.relax);
+            BasicMouseSession<LEN> maze(m, &floodfill);
+            maze.setSensorRange(options.sensors);
+            setLimits(maze, options);
+            // the step limit bounds the run already, and hashing the whole map before every step
+            // would take several times longer than the steps being timed.
+            maze.setLoopDetection(false);
+            if(cache && r == 0 && !floodfill.getId().empty()) {
+                bool mirrored;
+                const uint64_t hash = maze.getWorld().getCanonicalHash(mirrored);
+                // the sensor range is the session's rather than FloodFill's, but changes the run all the same.
+                const std::string id = floodfill.getId() + "-sensors" + std::to_string(options.sensors.front) + "x" + std::to_string(options.sensors.side);
+                key = ResultCache::key(LEN, hash, mirrored, id, floodfill.getVersion());
+                timingKey = ResultCache::timingKey(key, build);
+                // a result without timings of this build is run all the same, to time it.
+                if((cached = cache->load(key, result)) && (timed = cache->loadTimings(timingKey, result)))
+                    break;
+            }
+            std::streambuf *out = std::cout.rdbuf(NULL);
+            maze.start();
+            std::cout.rdbuf(out);
+            std::cout.clear();
+            if(maze.wasCutOff()) {
+                // how long it took says how long the limit is, not how long a run takes.
+                cutOff++;
+                cutOffOutcome = runOutcomeName(maze.getOutcome());
+                continue;
+            }
+            nanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+            steps += maze.getStepCount();
+            // with -a most of the flood work is the planner's and is not counted here.
+            refloods += floodfill.getStats().refloods;
+            refloodCycles += floodfill.getStats().refloodCycles;
+            assigns += floodfill.getStats().assigns;
+            assignCycles += floodfill.getStats().assignCycles;
+            result.turns = maze.getMovementCount(TurnClockwise) + maze.getMovementCount(TurnCounterClockwise) + maze.getMovementCount(TurnAround);
+            result.routeLength = floodfill.getStats().routeLength;
+            result.outcome = runOutcomeName(maze.getOutcome());
+        }
+        const unsigned long runs = options.repeat - cutOff;
+        cachedMazes += cached;
+        if(timed) {
+            // as if the runs had been made again, by this build on this machine (see ResultCache::buildId).
+            steps = result.steps * options.repeat;
+            nanos = result.runNanos * options.repeat;
+        } else {
+            timedAgain += cached;
+            result.steps = runs ? steps / runs : 0;
+            result.runNanos = runs ? nanos / runs : 0;
+            result.refloodCycles = refloods ? refloodCycles / refloods : 0;
+            result.assignCycles = assigns ? assignCycles / assigns : 0;
+            if(!runs)
+                result.outcome = cutOffOutcome;
+            // the limits are not in the key, so a maze with a run cut off is not kept.
+            if(!key.empty() && !cutOff) {
+                if(!cached && !cache->store(key, result))
+                    std::cerr << "Could not write " << key << " to the cache in " << options.cachePath << std::endl;
+                if(!cache->storeTimings(timingKey, result))
+                    std::cerr << "Could not write " << timingKey << " to the cache in " << options.cachePath << std::endl;
+            }
         }
+        totalNanos += nanos;
+        totalSteps += steps;
+        totalRuns += runs;
+        totalCutOff += cutOff;
+
+        std::cout << "Maze " << m << ": " << result.steps << " steps, " << result.outcome << ", ";
+        if(cutOff)
+            std::cout << cutOff << " of " << options.repeat << " runs cut off (" << cutOffOutcome << "), ";
+        std::cout << result.runNanos / 1000 << " us per run, "
+                  << (steps ? nanos / steps : 0) << " ns per step, "
+                  << result.refloodCycles << " cycles per reflood, "
+                  << result.assignCycles << " cycles per assign_new_dis"
+                  << (timed ? " (cached, timings from an earlier run of build " + build + ")" : cached ? " (cached, timed again)" : "") << std::endl;
+    }
+    std::cout << "All: " << (totalSteps ? totalNanos / totalSteps : 0) << " ns per step, "
+              << (totalNanos > 0 ? totalRuns / (totalNanos / 1e9) : 0) << " runs per second";
+    if(totalCutOff)
+        std::cout << " (" << totalCutOff << " runs cut off)";
+    if(cachedMazes)
+        std::cout << " (" << cachedMazes << " of " << MazeDefinitions::Encodings<LEN>::COUNT << " mazes cached, "
+                  << timedAgain << " of them timed again)";
+    std::cout << std::endl;
+    if(cache) {
+        std::cout << "Cache: " << cache->getHits() << " hits, " << cache->getMisses() << " misses" << std::endl;
+        delete cache;
     }
+    return totalCutOff ? 1 : 0;
 }
 
-// Call this after the mouse searched the center for the first time.
-// This function reassign the distance of all cells based on its 'physical' shortest path from the center. (i.e. consider walls)
-// need to call 'clearVisits' before using this function.
-void FloodFill::assign_new_dis(Cell* currCell){
-    currCell->distance = 0;
-    std::queue<Cell*> qu;
-    qu.push(currCell);
-    while(qu.front() != &map[0][0]){
-        currCell = qu.front();
-        currCell->visited = true;
-        unsigned newDis = currCell->distance +1;
-        if(verbose){
-            std::cout << "qu.front() = (" << qu.front()->cx << "," << qu.front()->cy << "). newDis = " << currCell->distance << "\n"; 
-        }
-        qu.pop();
-        if(!currCell->northWall && !map[currCell->cx][currCell->cy+1].visited){
-            map[currCell->cx][currCell->cy+1].distance = newDis;
-            qu.push(&map[currCell->cx][currCell->cy+1]);
-        }
-
-        if(!currCell->southWall && !map[currCell->cx][currCell->cy-1].visited){
-            map[currCell->cx][currCell->cy-1].distance = newDis;
-            qu.push(&map[currCell->cx][currCell->cy-1]);
-        }
+// run to step options.forkStep, take a snapshot and continue from it on one thread per what-if:
+// the movement FloodFill chose and, during the search, every other movement it could have made.
+// Then restore the snapshot many times over to time forking against running up to it again.
+template <unsigned LEN>
+int whatIf(const Options &options) {
+    typedef BasicFloodFill<LEN> FloodFill;
+    typedef BasicMouseSession<LEN> Session;
+
+    FloodFill floodfill(false, false, options.demo, true, false, options.relax);
+    Session maze(options.maze, &floodfill);
+    maze.setSensorRange(options.sensors);
+    setLimits(maze, options);
+    std::streambuf *out = std::cout.rdbuf(NULL);
+    while(maze.getStepCount() < options.forkStep && maze.step()) {
+    }
+    std::cout.rdbuf(out);
+    std::cout.clear();
+    if(maze.getStepCount() < options.forkStep) {
+        std::cout << "The run of maze " << options.maze << " ends after " << maze.getStepCount() << " steps" << std::endl;
+        return 1;
+    }
 
-        if(!currCell->eastWall && !map[currCell->cx+1][currCell->cy].visited){
-            map[currCell->cx+1][currCell->cy].distance = newDis;
-            qu.push(&map[currCell->cx+1][currCell->cy]);
+    typename FloodFill::Snapshot snapshot;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    if(!floodfill.snapshot(snapshot)) {
+        std::cout << "Cannot snapshot FloodFill at step " << options.forkStep << std::endl;
+        return 1;
+    }
+    const typename Session::Snapshot pose = maze.snapshot();
+    const typename FloodFill::Mode mode = floodfill.getMode();
+    const double snapshotNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    const char *headings[] = {"NORTH", "SOUTH", "EAST", "WEST", "INVALID"};
+    std::cout << "Fork at step " << options.forkStep << " of maze " << options.maze << ": (" << pose.x << "," << pose.y << ") facing "
+              << headings[pose.heading] << ", " << FloodFill::modeName(mode) << std::endl;
+    std::cout << "Snapshot: " << snapshotNanos / 1000 << " us, " << sizeof(typename FloodFill::Snapshot::State) << " bytes of state per fork, "
+              << sizeof(typename FloodFill::Snapshot::Map) << " bytes of map shared by all" << std::endl;
+
+    // the run without a fork, the first continuation has to match it.
+    out = std::cout.rdbuf(NULL);
+    maze.start();
+    std::cout.rdbuf(out);
+    std::cout.clear();
+    const unsigned long unforked = maze.getOutcome() == RUN_FINISHED ? maze.getStepCount() : 0;
+
+    // steps of the run continued from the snapshot with movement first, none for Finish. 0 if the mouse crashed or was cut off.
+    struct Branch {
+        static unsigned long run(const BasicMazeWorld<LEN> &world, const Options &options, const typename FloodFill::Snapshot &snapshot,
+                                 const typename Session::Snapshot &pose, MouseMovement movement) {
+            FloodFill floodfill(false, false, options.demo, true, false, options.relax);
+            Session maze(world, &floodfill);
+            maze.setSensorRange(options.sensors);
+            setLimits(maze, options);
+            floodfill.restore(snapshot);
+            maze.restore(pose);
+            try {
+                maze.force(movement);
+                maze.start();
+            } catch(const char *) {
+                return 0;
+            }
+            return maze.getOutcome() == RUN_FINISHED ? maze.getStepCount() : 0;
         }
+    };
 
-        if(!currCell->westWall && !map[currCell->cx-1][currCell->cy].visited){
-            map[currCell->cx-1][currCell->cy].distance = newDis;
-            qu.push(&map[currCell->cx-1][currCell->cy]);
-        }
-        
+    // the movement FloodFill makes next is the first branch. The others change the search only.
+    std::vector<MouseMovement> movements(1, Finish);
+    if(mode == FloodFill::MODE_SEARCH) {
+        const MouseMovement others[] = {MoveForward, TurnClockwise, TurnCounterClockwise, TurnAround};
+        movements.insert(movements.end(), others, others + 4);
     }
-    qu.front()->visited = true;
-    if(verbose){
-        std::cout << "qu.front() = (" << qu.front()->cx << "," << qu.front()->cy << "). newDis = " << qu.front()->distance << "\n"; 
-        std::cout << "Done assigning new distances.\n";
+    std::vector<unsigned long> steps(movements.size());
+    const BasicMazeWorld<LEN> &world = maze.getWorld();
+
+    // FloodFill prints when it reaches the center or home, which nobody wants from every thread.
+    out = std::cout.rdbuf(NULL);
+    std::vector<std::thread> threads;
+    for(size_t b = 0; b < movements.size(); b++) {
+        threads.push_back(std::thread([&, b]() {
+            steps[b] = Branch::run(world, options, snapshot, pose, movements[b]);
+        }));
     }
-}
-
-
-// for search mode step one. Does two things:
-// [1] use front, right, left wall status to find min distance.
-// [2] assign return value.(mouse movement)
-void FloodFill::find_minDistance_and_nextInsn(unsigned x, unsigned y){
-
-    // calculate the x y coordinates of the 'front' cell.
-    unsigned forwardX, forwardY;
-    getForwardXY(forwardX,forwardY, currHeading);
-   
-    minMDistance = currMDistance;
-
-    // In the below three if clauses, we check the distance of the adjacent cell and 
-    // set the wall status of the adjacent cell & current cell.
-
-    // check the Mdistance of the grid on the left
-    if(!leftWall){
-        map[x][y].setWall(counterClockwise(currHeading));
-        map[x - forwardY][y + forwardX].setWall(clockwise(currHeading));
-        if( map[x - forwardY][y + forwardX].distance <= minMDistance){
-            minMDistance = map[x - forwardY][y + forwardX].distance;
-            retval = TurnCounterClockwise;
-        }
+    for(size_t b = 0; b < threads.size(); b++) {
+        threads[b].join();
     }
 
-    // check the Mdistance of the grid on the right
-    if(!rightWall){
-        map[x][y].setWall(clockwise(currHeading));
-        map[x + forwardY][y - forwardX].setWall(counterClockwise(currHeading));
-        if(map[x + forwardY][y - forwardX].distance <= minMDistance){
-            minMDistance = map[x + forwardY][y - forwardX].distance;
-            retval = TurnClockwise;
-        }
+    // many continuations of the chosen branch spread over the cores, each restoring the snapshot.
+    const unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned forks = 64;
+    std::atomic<unsigned> mismatches(0);
+    threads.clear();
+    begin = std::chrono::steady_clock::now();
+    for(unsigned w = 0; w < workers; w++) {
+        threads.push_back(std::thread([&, w]() {
+            for(unsigned f = w; f < forks; f += workers) {
+                if(Branch::run(world, options, snapshot, pose, Finish) != unforked)
+                    mismatches++;
+            }
+        }));
     }
-
-    // check the Mdistance of the grid at the front
-    if(!frontWall){
-        // set wall status of the current cell
-        map[x][y].setWall(currHeading);
-        // set wall status of the cell at the front
-        map[x+ forwardX][y+ forwardY].setWall(opposite(currHeading));
-
-        // find min distance
-        if(map[x + forwardX][y + forwardY].distance <= minMDistance){
-            minMDistance = map[x + forwardX][y + forwardY].distance;
-            retval = MoveForward;
-        }
+    for(unsigned w = 0; w < workers; w++) {
+        threads[w].join();
+    }
+    const double forkNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    // the same continuations, each running the first options.forkStep steps again instead.
+    begin = std::chrono::steady_clock::now();
+    for(unsigned f = 0; f < forks; f++) {
+        FloodFill rerun(false, false, options.demo, true, false, options.relax);
+        Session rerunMaze(world, &rerun);
+        rerunMaze.setSensorRange(options.sensors);
+        setLimits(rerunMaze, options);
+        rerunMaze.start();
+    }
+    const double rerunNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    std::cout.rdbuf(out);
+    std::cout.clear();
+
+    for(size_t b = 0; b < movements.size(); b++) {
+        std::cout << (movements[b] == Finish ? "As chosen" : movementName(movements[b])) << ": ";
+        if(steps[b])
+            std::cout << steps[b] << " steps";
+        else
+            std::cout << "crashed or was cut off";
+        if(b == 0)
+            std::cout << " (" << unforked << " without the fork)";
+        else if(steps[b] && steps[0])
+            std::cout << " (" << (long)steps[b] - (long)steps[0] << ")";
+        std::cout << std::endl;
     }
+    std::cout << forks << " forks on " << workers << " threads: " << forkNanos / 1e6 << " ms, " << mismatches << " not matching; "
+              << "running from the start on one thread: " << rerunNanos / 1e6 << " ms" << std::endl;
+    return unforked && steps[0] == unforked && mismatches == 0 ? 0 : 1;
 }
 
-
-// Used in constructing route. Very similar to 'find_minDistance_and_nextInsn'.
-// use front, right, left wall status to find min distance.
-// The difference is that it only checks the adjacent cells that the mouse has already visited
-void FloodFill::find_minDistance_and_nextInsn_II(unsigned x, unsigned y, Dir funcHeading){
-
-    // calculate the x y coordinates of the 'front' cell.
-    unsigned forwardX = 0;
-    unsigned forwardY = 0;
-    bool func_frontWall, func_leftWall, func_rightWall;
-    switch(funcHeading){
-        case NORTH:
-            func_frontWall = map[x][y].northWall;
-            func_rightWall = map[x][y].eastWall;
-            func_leftWall = map[x][y].westWall;
-            forwardY = 1;
-            break;
-        case SOUTH:
-            func_frontWall = map[x][y].southWall;
-            func_rightWall = map[x][y].westWall;
-            func_leftWall = map[x][y].eastWall;
-            forwardY = -1;
-            break;
-        case EAST:
-            func_frontWall = map[x][y].eastWall;
-            func_rightWall = map[x][y].southWall;
-            func_leftWall = map[x][y].northWall;
-            forwardX = 1;
-            break;
-        case WEST:
-            func_frontWall = map[x][y].westWall;
-            func_rightWall = map[x][y].northWall;
-            func_leftWall = map[x][y].southWall;
-            forwardX = -1;
-            break;
-    }
-    
-    minMDistance = map[x][y].distance;
-
-    // In the below three if clauses, we check the distance of the adjacent cell which the mouse has already visited.
-
-    if(verbose){
-        std::cout << "\nII: (" << x << "," << y << "):\n";
-        std::cout << "II: current distance=" <<  map[x][y].distance << "\n";
-        std::cout << "II: func_frontWall=" << func_frontWall << std::endl;
-        std::cout << "II: func_rightWall=" << func_rightWall << std::endl;
-        std::cout << "II: func_leftWall=" << func_leftWall << std::endl;
-    }
-    // check the Mdistance of the grid on the left
-    if(!func_leftWall && map[x - forwardY][y + forwardX].visited){
-        if(verbose){
-            std::cout << "II: (" << x - forwardY << "," << y + forwardX << "):visited\n";
-            std::cout << "II: (" << x - forwardY << "," << y + forwardX << ").distance=" <<  map[x - forwardY][y + forwardX].distance << "\n";
-        }
-        if( map[x - forwardY][y + forwardX].distance <= minMDistance){
-            minMDistance = map[x - forwardY][y + forwardX].distance;
-            retval = TurnCounterClockwise;
+// run every LEN x LEN maze with a few sensor ranges and print how many steps each saves over the classic mouse,
+// in the search run (until the mouse reaches the center) and in the whole run.
+template <unsigned LEN>
+int sensorReport(const Options &options) {
+    const SensorRange ranges[] = {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {1, 1}, {2, 1}, {3, 1}, {3, 2}};
+    const unsigned count = sizeof(ranges) / sizeof(*ranges);
+    const unsigned mazes = MazeDefinitions::Encodings<LEN>::COUNT;
+    std::vector<unsigned long> search(count * mazes), total(count * mazes);
+    std::vector<unsigned long> sensed(count);
+
+    std::streambuf *out = std::cout.rdbuf(NULL);
+    for(unsigned r = 0; r < count; r++) {
+        for(unsigned m = 0; m < mazes; m++) {
+            BasicFloodFill<LEN> floodfill(false, false, options.demo, true, false, options.relax);
+            BasicMouseSession<LEN> maze(m, &floodfill);
+            maze.setSensorRange(ranges[r]);
+            setLimits(maze, options);
+            unsigned long searchSteps = 0;
+            while(maze.step()) {
+                if(!searchSteps && floodfill.getMode() != BasicFloodFill<LEN>::MODE_SEARCH)
+                    searchSteps = maze.getStepCount();
+            }
+            search[r * mazes + m] = searchSteps ? searchSteps : maze.getStepCount();
+            total[r * mazes + m] = maze.getOutcome() == RUN_FINISHED ? maze.getStepCount() : 0;
+            sensed[r] += floodfill.getStats().sensedCells;
         }
     }
+    std::cout.rdbuf(out);
+    std::cout.clear();
+
+    std::cout << LEN << "x" << LEN << ", search steps (whole run) per maze, front,side sensor range in cells ahead" << std::endl;
+    int status = 0;
+    for(unsigned r = 0; r < count; r++) {
+        long searchSaved = 0, totalSaved = 0;
+        std::cout << ranges[r].front << "," << ranges[r].side << ":";
+        for(unsigned m = 0; m < mazes; m++) {
+            const unsigned long i = r * mazes + m;
+            std::cout << " " << search[i] << " (" << total[i] << ")";
+            searchSaved += (long)search[m] - (long)search[i];
+            totalSaved += (long)total[m] - (long)total[i];
+            if(!total[i])
+                status = 1;
+        }
+        std::cout << std::endl << "    saved " << searchSaved << " search steps, " << totalSaved << " steps in all, "
+                  << sensed[r] << " cells known before the mouse got there" << std::endl;
+    }
+    return status;
+}
 
-    // check the Mdistance of the grid on the right
-    if(!func_rightWall && map[x + forwardY][y - forwardX].visited){
-        if(verbose){
-            std::cout << "II: (" << x + forwardY << "," << y - forwardX << "):visited\n";
-            std::cout << "II: (" << x + forwardY << "," << y - forwardX << ").distance=" <<  map[x + forwardY][y - forwardX].distance << "\n";
-        }
-        if(map[x + forwardY][y - forwardX].distance <= minMDistance){
-            minMDistance = map[x + forwardY][y - forwardX].distance;
-            retval = TurnClockwise;
-        }
+// passes the movements of a FloodFill through, noting down those of the search and those of the speed run to the center.
+template <unsigned LEN>
+class Tap : public BasicPathFinder<LEN> {
+public:
+    explicit Tap(BasicFloodFill<LEN> &floodfill) : floodfill(floodfill) {}
+
+    MouseMovement nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze) {
+        const typename BasicFloodFill<LEN>::Mode before = floodfill.getMode();
+        const MouseMovement movement = floodfill.nextMovement(x, y, maze);
+        // the turn around at the center ends the speed run.
+        if(before == BasicFloodFill<LEN>::MODE_FAST && floodfill.getMode() == BasicFloodFill<LEN>::MODE_FAST)
+            fast.push_back(movement);
+        else if(before == BasicFloodFill<LEN>::MODE_SEARCH || before == BasicFloodFill<LEN>::MODE_BACK_HOME)
+            search.push_back(movement);
+        return movement;
     }
 
-    // check the Mdistance of the grid at the front
-    if(!func_frontWall && map[x + forwardX][y + forwardY].visited){
-        if(verbose){
-            std::cout << "II: (" << x + forwardX << "," << y + forwardY << "):visited\n";
-            std::cout << "II: (" << x + forwardX << "," << y + forwardY << ").distance=" <<  map[x + forwardX][y + forwardY].distance << "\n";
-        }
-        // find min distance
-        if(map[x + forwardX][y + forwardY].distance <= minMDistance){
-            minMDistance = map[x + forwardX][y + forwardY].distance;
-            retval = MoveForward;
+    BasicFloodFill<LEN> &floodfill;
+    std::vector<MouseMovement> search;
+    std::vector<MouseMovement> fast;
+};
+
+// run every LEN x LEN maze and compare the speed run (MODE_FAST) and the search with the routes the
+// oracle finds knowing every wall: the fewest cells and the least time under the timing model.
+template <unsigned LEN>
+int oracleReport(const Options &options) {
+    const Oracle::TimingModel model(LEN == MazeDefinitions::MAZE_LEN ? 0.18 : 0.09);
+    std::cout << LEN << "x" << LEN << ", " << model.cellLength << " m cells, " << model.acceleration << " m/s^2, "
+              << model.topSpeed << " m/s, " << model.turnTime << " s per quarter turn, " << model.aroundTime << " s per half turn" << std::endl;
+
+    const unsigned mazes = MazeDefinitions::Encodings<LEN>::COUNT;
+    unsigned optimalCells = 0, optimalTime = 0, compared = 0;
+    long cellGap = 0;
+    double timeGap = 0, fastestTime = 0, searchTime = 0;
+    for(unsigned m = 0; m < mazes; m++) {
+        const BasicMazeWorld<LEN> &world = BasicMazeWorld<LEN>::get(m);
+        const Oracle::Path shortest = Oracle::shortest(world, model);
+        const Oracle::Path fastest = Oracle::fastest(world, model);
+
+        BasicFloodFill<LEN> floodfill(false, false, false, true, false, options.relax);
+        Tap<LEN> tap(floodfill);
+        BasicMouseSession<LEN> maze(world, &tap);
+        maze.setSensorRange(options.sensors);
+        setLimits(maze, options);
+        std::streambuf *out = std::cout.rdbuf(NULL);
+        maze.start();
+        std::cout.rdbuf(out);
+        std::cout.clear();
+
+        std::cout << "Maze " << m << ": ";
+        if(!shortest.found || tap.fast.empty()) {
+            std::cout << (shortest.found ? "no speed run" : "the center cannot be reached") << std::endl;
+            continue;
         }
+        const unsigned cells = Oracle::cellCount(tap.fast);
+        const double time = model.time(tap.fast);
+        const double search = model.time(tap.search);
+        std::cout << "route " << cells << " cells " << time << " s, shortest " << shortest.cells << " cells, fastest "
+                  << fastest.cells << " cells " << fastest.time << " s: gap +" << cells - shortest.cells << " cells, +"
+                  << time - fastest.time << " s (" << 100 * (time - fastest.time) / fastest.time << "%); search "
+                  << tap.search.size() << " steps " << search << " s, " << search / (2 * fastest.time)
+                  << " times the fastest round trip" << std::endl;
+
+        compared++;
+        optimalCells += cells == shortest.cells;
+        optimalTime += time - fastest.time < 1e-9;
+        cellGap += cells - shortest.cells;
+        timeGap += time - fastest.time;
+        fastestTime += fastest.time;
+        searchTime += search;
     }
-
-    if(verbose){
-            std::cout << "II: obtained minMDistance" <<  minMDistance << "\n";
+    if(compared) {
+        std::cout << "All: " << optimalCells << " of " << compared << " routes as short as the shortest, " << optimalTime
+                  << " as fast as the fastest; gap " << cellGap << " cells, " << timeGap << " s ("
+                  << 100 * timeGap / fastestTime << "% over the fastest routes); search "
+                  << searchTime / (2 * fastestTime) << " times the fastest round trips" << std::endl;
     }
+    return compared == mazes ? 0 : 1;
 }
 
-
-// get new values of forwardX and forwardY. 
-// if current cell is at (x.y)
-// Cell at the front     ==> (x+forwardX, y+forwardY)
-// Cell on the right     ==> (x + forwardY, y - forwardX)
-// Cell on the left      ==> (x - forwardY, y + forwardX)
-void FloodFill::getForwardXY(unsigned &forwardX, unsigned &forwardY, Dir &heading){
-    forwardX = 0;
-    forwardY = 0;
-    switch(heading){
-        case NORTH:
-            forwardY = 1;
-            break;
-        case SOUTH:
-            forwardY = -1;
-            break;
-        case EAST:
-            forwardX = 1;
-            break;
-        case WEST:
-            forwardX = -1;
-            break;
+// look for the mazes FloodFill takes the most search steps in (with -o: the mazes with the largest gap between its
+// speed run and the fastest route), hill climbing from every built-in maze on all cores. The worst ones are written
+// out as maze files (run -i), with a replay of their run, and a Chrome trace for the worst.
+template <unsigned LEN>
+int adversary(const Options &options) {
+    // a run that is cut off scores as high as a run can.
+    const unsigned long maxSteps = options.stepLimit ? options.stepLimit : 16 * MazeDefinitions::Size<LEN>::CELLS;
+    const Oracle::TimingModel model(LEN == MazeDefinitions::MAZE_LEN ? 0.18 : 0.09);
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned keep = 3;
+
+    std::vector<Adversary::Maze<LEN> > seeds(MazeDefinitions::Encodings<LEN>::COUNT);
+    for(unsigned m = 0; m < seeds.size(); m++) {
+        BasicMazeWorld<LEN>::get(m).encode(seeds[m].cells);
     }
-}
 
+    // steps until the speed run, or the gap in milliseconds.
+    auto score = [&](const Adversary::Maze<LEN> &candidate) -> unsigned long {
+        const BasicMazeWorld<LEN> world(candidate.cells);
+        BasicFloodFill<LEN> floodfill(false, false, false, true, false, options.relax);
+        Tap<LEN> tap(floodfill);
+        BasicMouseSession<LEN> maze(world, &tap);
+        maze.setSensorRange(options.sensors);
+        setLimits(maze, options);
+        while(maze.step()) {
+            if(!options.oracle && floodfill.getMode() == BasicFloodFill<LEN>::MODE_FAST)
+                break;
+        }
+        if(maze.wasCutOff())
+            return options.oracle ? ~0ul : maxSteps;
+        if(!options.oracle)
+            return tap.search.size();
+        return 1000 * (model.time(tap.fast) - Oracle::fastest(world, model).time);
+    };
 
-// use north,south,east,west wall status to find min distance 
-// when isConstructingRoute is set, check only the cells that the mouse has visited.
-FloodFill::Cell* FloodFill::findMinDistance(unsigned cx, unsigned cy, bool isConstructingRoute = false){
-    minMDistance = INFINITY;
-    Cell* retCell = NULL;
-
-    if(!map[cx][cy].northWall && (map[cx][cy+1].distance <= minMDistance)){
-        if(isConstructingRoute){
-            if(map[cx][cy+1].visited){
-                if(verbose){
-                    std::cout << "findMin: (" << cx  << "," << cy+1 << "):visited\n";
-                    std::cout << "findMin: (" << cx << "," << cy+1 << ").distance=" <<  map[cx][cy+1].distance << "\n";
-                }
-                minMDistance = map[cx][cy+1].distance;
-                retCell = &map[cx][cy+1];
-            }
-        }else{
-            minMDistance = map[cx][cy+1].distance;
-        }
+    std::cout << LEN << "x" << LEN << ", " << options.evaluations << " mazes evaluated on " << threads << " threads, maximizing "
+              << (options.oracle ? "the speed run's gap to the fastest route (ms)" : "the search steps") << std::endl;
+    std::streambuf *out = std::cout.rdbuf(NULL);
+    std::vector<unsigned long> seedScores;
+    for(unsigned m = 0; m < seeds.size(); m++) {
+        seedScores.push_back(score(seeds[m]));
     }
-    // check the distance of the grid in the south
-    if(!map[cx][cy].southWall && (map[cx][cy-1].distance <= minMDistance)){
-        if(isConstructingRoute){
-            if(map[cx][cy-1].visited){
-                if(verbose){
-                    std::cout << "findMin: (" << cx  << "," << cy-1 << "):visited\n";
-                    std::cout << "findMin: (" << cx << "," << cy-1 << ").distance=" <<  map[cx][cy-1].distance << "\n";
-                }
-                minMDistance = map[cx][cy-1].distance;
-                retCell = &map[cx][cy-1];
-            }
-        }else{
-            minMDistance = map[cx][cy-1].distance;
-        }
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const std::vector<Adversary::Found<LEN> > worst = Adversary::search(seeds, score, options.evaluations, threads, keep);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout.rdbuf(out);
+    std::cout.clear();
+    std::cout << seconds << " s, " << options.evaluations / seconds << " mazes per second" << std::endl;
+    std::cout << "Built-in mazes:";
+    for(unsigned m = 0; m < seeds.size(); m++) {
+        std::cout << " " << seedScores[m];
     }
-    // check the distance of the grid in the east
-    if(!map[cx][cy].eastWall && (map[cx+1][cy].distance <= minMDistance)){
-        if(isConstructingRoute){
-            if (map[cx+1][cy].visited){
-                if(verbose){
-                    std::cout << "findMin: (" << cx+1  << "," << cy << "):visited\n";
-                    std::cout << "findMin: (" << cx+1 << "," << cy << ").distance=" <<  map[cx+1][cy].distance << "\n";
-                }
-                minMDistance = map[cx+1][cy].distance;
-                retCell = &map[cx+1][cy];
-            }
-        }else{
-            minMDistance = map[cx+1][cy].distance;
-        }
-    }
-    // check the distance of the grid in the west
-    if(!map[cx][cy].westWall && (map[cx-1][cy].distance < minMDistance)){
-        if(isConstructingRoute){
-            if( map[cx-1][cy].visited){
-                if(verbose){
-                    std::cout << "findMin: (" << cx-1  << "," << cy << "):visited\n";
-                    std::cout << "findMin: (" << cx-1 << "," << cy << ").distance=" <<  map[cx-1][cy].distance << "\n";
-                }
-                minMDistance = map[cx-1][cy].distance;
-                retCell = &map[cx-1][cy];
-            }
-        }else{
-            minMDistance = map[cx-1][cy].distance;
-        }
+    std::cout << std::endl;
+
+    for(size_t k = 0; k < worst.size(); k++) {
+        const BasicMazeWorld<LEN> world(worst[k].maze.cells);
+        std::ostringstream name;
+        name << "worst" << LEN << "-" << k + 1;
+        const std::string mazePath = name.str() + ".maz", replayPath = name.str() + ".replay", tracePath = name.str() + ".json";
+
+        // run it again, recorded.
+        bool mirrored;
+        const uint64_t hash = world.getCanonicalHash(mirrored);
+        BasicFloodFill<LEN> floodfill(false, false, false, true, false, options.relax);
+        BasicMouseSession<LEN> maze(world, &floodfill);
+        maze.setSensorRange(options.sensors);
+        setLimits(maze, options);
+        Replay::Writer replay(replayPath.c_str(), LEN, world.getName(), hash, mirrored, floodfill.getId(), true);
+        maze.setRecorder(&replay);
+        if(k == 0)
+            Trace::enable();
+        out = std::cout.rdbuf(NULL);
+        maze.start();
+        std::cout.rdbuf(out);
+        std::cout.clear();
+        if(k == 0)
+            Trace::disable();
+        const bool written = world.save(mazePath.c_str()) && replay.close() && (k != 0 || Trace::write(tracePath.c_str()));
+
+        std::cout << "Worst " << k + 1 << ": " << worst[k].score << (options.oracle ? " ms" : " search steps")
+                  << ", grown from maze " << worst[k].seed << " by evaluation " << worst[k].evaluation << ", "
+                  << maze.getStepCount() << " steps in all" << (maze.wasCutOff() ? std::string(" (cut off: ") + runOutcomeName(maze.getOutcome()) + ")" : std::string())
+                  << ", written to " << mazePath << " and " << replayPath << (k == 0 ? " and " + tracePath : std::string())
+                  << (written ? "" : " (FAILED)") << std::endl;
     }
-    if(verbose){
-        std::cout << "final minDistance=" <<  minMDistance << "\n";
-        if(retCell != NULL)
-            std::cout << "final retCell= (" <<  retCell->cx << "," << retCell->cy << ")" << "\n";
-    }
-    return retCell;
-
+    return 0;
 }
 
-// After the mouse reached the center for the first time and the distances map has been reassigned,
-// we call this function to construct the 'shortest' route from origin(home) to center.
-// we have two stacks, routeSt1 and routeSt2. routeSt1 stores the instructions needed to traverse from center to home
-// routeSt2 will store the same but in reverse order when we run HomeBoundMode because routeSt2 push whatever routeSt1 pop. 
-void FloodFill::constructRoute(){
-    unsigned forwardX, forwardY;
-    // error checking
-    if(!routeSt1.empty())
-        return;
-
-    Cell* currCell = &map[0][0];
-    Cell* nextCell;
-    Dir funcHeading = NORTH;
-    while(currCell->distance != 0){
-        find_minDistance_and_nextInsn_II(currCell->cx, currCell->cy, funcHeading);
-        routeSt1.push(retval);
-
-        // update Cell and funcHeading 
-        if (retval == MoveForward){
-            getForwardXY(forwardX,forwardY,funcHeading);
-            currCell = &map[currCell->cx+forwardX][currCell->cy+forwardY];
+int main(int argc, char * argv[]) {
+    Options options;
+    options.maze = MazeDefinitions::MAZE_CAMM_2012;
+    options.size = MazeDefinitions::MAZE_LEN;
+    options.pause = false;
+    options.verbose = false;
+    options.demo = false;
+    options.quiet = false;
+    options.async = false;
+    options.budgetMicros = 0;
+    options.tracePath = NULL;
+    options.json = false;
+    options.repeat = 0;
+    options.relax = false;
+    options.cachePath = NULL;
+    options.replayPath = NULL;
+    options.liveName = NULL;
+    options.forkStep = 0;
+    options.sensors.front = 0;
+    options.sensors.side = 0;
+    options.sensorReport = false;
+    options.oracle = false;
+    options.evaluations = 0;
+    options.mazePath = NULL;
+    options.stepLimit = 0;
+    options.timeLimitMillis = 0;
+    // Since Windows does not support getopt directly, we will
+    // have to parse the command line arguments ourselves.
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-m") == 0 && i+1 < argc) {
+            // the maze checks the range, it depends on the size.
+            int mazeOption = atoi(argv[++i]);
+            if(mazeOption > 0) {
+                options.maze = mazeOption;
+            }
+        } else if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            options.size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-p") == 0) {
+            options.pause = true;
+        } else if(strcmp(argv[i], "-v") == 0) {
+            options.verbose = true;
+        } else if(strcmp(argv[i], "-d") == 0) {
+            options.demo = true;
+        } else if(strcmp(argv[i], "-q") == 0) {
+            options.quiet = true;
+        } else if(strcmp(argv[i], "-a") == 0) {
+            options.async = true;
+        } else if(strcmp(argv[i], "-b") == 0 && i+1 < argc) {
+            options.budgetMicros = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            options.tracePath = argv[++i];
+        } else if(strcmp(argv[i], "-j") == 0) {
+            options.json = true;
+        } else if(strcmp(argv[i], "-r") == 0 && i+1 < argc) {
+            options.repeat = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-x") == 0) {
+            options.relax = true;
+        } else if(strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+            options.cachePath = argv[++i];
+        } else if(strcmp(argv[i], "-w") == 0 && i+1 < argc) {
+            options.replayPath = argv[++i];
+        } else if(strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            options.forkStep = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            // front range, and the side range after a comma.
+            const char *range = argv[++i];
+            options.sensors.front = atoi(range);
+            options.sensors.side = strchr(range, ',') ? atoi(strchr(range, ',') + 1) : 0;
+        } else if(strcmp(argv[i], "-e") == 0) {
+            options.sensorReport = true;
+        } else if(strcmp(argv[i], "-o") == 0) {
+            options.oracle = true;
+        } else if(strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+            options.evaluations = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-i") == 0 && i+1 < argc) {
+            options.mazePath = argv[++i];
+        } else if(strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            options.stepLimit = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-u") == 0 && i+1 < argc) {
+            options.timeLimitMillis = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-y") == 0 && i+1 < argc) {
+            options.liveName = argv[++i];
         } else {
-            // take care of Turnaround, TurnCounterClockwise and TurnClockwise.
-            setHead(funcHeading, retval);
+            std::cout << "Usage: " << argv[0] << " [-m N] [-s N] [-p] [-v] [-d] [-q] [-a] [-b N] [-t FILE] [-j] [-r N] [-x] [-c DIR] [-w FILE] [-f N] [-l F,S] [-e] [-o] [-g N] [-i FILE] [-n N] [-u N] [-y NAME]" << std::endl;
+            std::cout << "\t-m N will load the maze corresponding to N, or 0 if invalid N or missing option" << std::endl;
+            std::cout << "\t-s N will use the N x N mazes, 16 (classic, default) or 32 (half-size)" << std::endl;
+            std::cout << "\t-p will wait for a newline in between cell traversals" << std::endl;
+            std::cout << "\t-v will output useful debugging info" << std::endl;
+            std::cout << "\t-d will only perform search run" << std::endl;
+            std::cout << "\t-q will not draw the maze at every move" << std::endl;
+            std::cout << "\t-a will reflood and construct the route on a background planner thread" << std::endl;
+            std::cout << "\t-b N will give every move a time budget of N microseconds (e.g. 1000 for a 1 kHz loop)" << std::endl;
+            std::cout << "\t-t FILE will write a Chrome trace of the run to FILE (open it in ui.perfetto.dev)" << std::endl;
+            std::cout << "\t-j will print the run and algorithm statistics as JSON at the end" << std::endl;
+            std::cout << "\t-r N will time N headless runs of every maze of the size instead" << std::endl;
+            std::cout << "\t-x will reflood and reassign distances with the whole-maze relaxation kernel (SIMD when built for it)" << std::endl;
+            std::cout << "\t-c DIR will keep the results of -r in DIR and not run a maze again with the same FloodFill build (but to time it)" << std::endl;
+            std::cout << "\t-w FILE will write a binary replay of the run to FILE (play it with ReplayRun)" << std::endl;
+            std::cout << "\t-f N will snapshot the run at step N and continue it on threads with each other movement the mouse could make" << std::endl;
+            std::cout << "\t-n N will cut a run off after N steps but Wait (default 16 per cell), or as soon as it loops" << std::endl;
+            std::cout << "\t-u N will cut a run off after N milliseconds" << std::endl;
+            std::cout << "\t-y NAME will publish every step to shared memory NAME without waiting (watch it with ViewRun NAME)" << std::endl;
+            return -1;
         }
     }
-}
-
-// First run searching center
-void FloodFill::SearchMode(unsigned x, unsigned y){
 
-    ////////////////////////////////////////////////////////////////////////////////////////////////////
-    // step 1: Follow Manhattan Distances downwards towards center, noting down any walls as they pass
-    ////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    map[x][y].visited = true;
-    find_minDistance_and_nextInsn(x,y);
-    // if mimMDistance is not changed, then currMDistance is the smallest Mdistance in its neighborhood.
-    if(minMDistance != currMDistance)
-        return;
-
-    if(verbose)
-        std::cout << "Step 1 done...";
-
-    ////////////////////////////////////////////////////////////////////////////////////////////////////
-    // step 2: Apply floodfill algorithm
-    ////////////////////////////////////////////////////////////////////////////////////////////////////
-
-    // new stack //Stack of points to be processed (can also use queue)
-    std::stack<Cell*> st;
-
-    // push current cell onto stack
-    st.push(&map[x][y]);
-    Cell* curr; 
-
-
-    while (!st.empty()){
-        curr = st.top();
-        st.pop();
-        // set current cell to 'being processed'
-        curr->visited = true;
-        // get current cell coordinates.
-        unsigned cx = curr->cx;
-        unsigned cy = curr->cy;
-
-        // for debugging purpose
-        if(verbose){
-            std::cout << "\ncurr=[" << cx << "][" << cy << "],old dis=" <<curr->distance << " ";
-        }
-
-        // don’t want to process the end goal
-        if (curr->distance == 0)
-            continue; 
-
-
-        // for each neighboring cell of curr:
-  
-        // Similar to step one, find the smallest distance arourd the neighborhood.
-        // assign new value to minMDistance.
-        findMinDistance(cx,cy);
-        
-        
-        if(minMDistance == INFINITY) // shouldn't go in here, if for some reason minMDistance is not changed, then just ignore it.
-            continue;
-
-        if(minMDistance +1 == curr->distance) // nothing was updated, move on
-            continue;
-        
-        curr->setDistance(minMDistance + 1); // set new minimum distance
-         
-        
-        if(verbose)
-            std::cout << "{ calcMin=" << minMDistance << ", new dis= " << curr->distance << ", push ";
-
-        // push every visited, connected neighbor onto stack (neighbors the mouse passed by and has no adjacent wall.)
-        if((!map[cx][cy].northWall) && map[cx][cy+1].visited){
-            st.push(&map[cx][cy+1]);
-            if(verbose)
-                std::cout << "[" << cx << "][" << cy+1<< "], ";
-        }
-        if((!map[cx][cy].southWall) && map[cx][cy-1].visited){
-            st.push(&map[cx][cy-1]);
-            if(verbose)
-                std::cout << "[" << cx << "][" << cy-1 << "], ";
-        }
-        if((!map[cx][cy].eastWall)  && map[cx+1][cy].visited){
-            st.push(&map[cx+1][cy]);
-            if(verbose)
-                std::cout << "[" << cx+1 << "][" << cy << "], ";
-        }
-        if((!map[cx][cy].westWall) && map[cx-1][cy].visited){
-            st.push(&map[cx-1][cy]);
-            if(verbose)
-                std::cout << "[" << cx-1 << "][" << cy << "], ";
-        }
-        if(verbose)
-            std::cout << "}";
-    }
-    // IR sensors can't sense the back wall, so let's turn around.
-    // Add additional checks to avoid unnecessary turnarounds.
-    unsigned forwardX, forwardY;
-    getForwardXY(forwardX, forwardY, currHeading);
-    if ( rightWall && leftWall && (frontWall || map[x+forwardX][y+forwardY].distance > map[x][y].distance)){
-        retval = TurnAround;
-    } else {
-        retval = Wait;
-    }
-    
-    return;
-}
-
-// First run going back home and speed run running back home
-void FloodFill::HomeBoundMode(unsigned x, unsigned y){
-    if(routeSt1.empty()){
-        retval = Wait;
-        return;
+    switch(options.size) {
+        case MazeDefinitions::MAZE_LEN:
+            if(options.evaluations)
+                return adversary<MazeDefinitions::MAZE_LEN>(options);
+            if(options.oracle)
+                return oracleReport<MazeDefinitions::MAZE_LEN>(options);
+            if(options.sensorReport)
+                return sensorReport<MazeDefinitions::MAZE_LEN>(options);
+            if(options.forkStep)
+                return whatIf<MazeDefinitions::MAZE_LEN>(options);
+            return options.repeat ? benchmark<MazeDefinitions::MAZE_LEN>(options) : simulate<MazeDefinitions::MAZE_LEN>(options);
+        case MazeDefinitions::HALF_SIZE_MAZE_LEN:
+            if(options.evaluations)
+                return adversary<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+            if(options.oracle)
+                return oracleReport<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+            if(options.sensorReport)
+                return sensorReport<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+            if(options.forkStep)
+                return whatIf<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+            return options.repeat ? benchmark<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options) : simulate<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+        default:
+            std::cout << "Unsupported maze size " << options.size << ", use 16 or 32" << std::endl;
+            return -1;
     }
-    retval = routeSt1.top();
-    routeSt2.push(retval);
-    routeSt1.pop();
-    if(retval == TurnClockwise)
-        retval = TurnCounterClockwise;
-    else if(retval == TurnCounterClockwise)
-        retval = TurnClockwise;
-
-}
-// Speed run running to center
-void FloodFill::FastMode(){
-    if(routeSt2.empty()){
-        retval = Wait;
-        return;
-    }
-    retval = routeSt2.top();
-    routeSt1.push(retval);
-    routeSt2.pop();
 }
@@ -0,0 +1,2077 @@
+#ifndef FloodFill_h
+#define FloodFill_h
+
+#include <stdint.h> // uint8_t, uint64_t
+#include "Dir.h"
+#include "MazeDefinitions.h"
+#include "MouseMovement.h"
+#include "RelaxKernel.h"
+
+#ifdef FLOODFILL_FREESTANDING
+// The firmware build (make embedded): no iostream, threads, clocks, heap, exceptions or RTTI.
+// Tracing, debug logging and the counters of the other builds are compiled out.
+#define TRACE_DISABLED
+#undef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_ERROR
+#define PERF_SCOPE(name)
+#define ALLOC_GROUP(name)
+#define ALLOC_PHASE(name)
+#include <stddef.h> // NULL
+#include "Trace.h"
+#include "Log.h"
+#else
+#include <iostream>
+#include <cassert>
+#include <cstdlib>   // abort
+#include <chrono>
+#include <memory>    // std::shared_ptr
+#include <type_traits> // std::is_trivially_copyable
+#include <algorithm> // std::max, std::copy
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "MouseSession.h"
+#include "PathFinder.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "AllocStats.h"
+#include "Log.h"
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc
+#endif
+
+/**
+ * Our implementation.
+ * Use floodfill algorithm to traverse the maze and to find shortest path.
+ * For clarity, sost class functions implementation is at the bottom of this file.
+ * 
+ * Basic idea:
+ * [1] use flood fill algorithm(see the slides) to search the center
+ * [2] when at the center, reassign distance values of all cells based on 
+ *     the actual distance from the cell to the center.
+ * [3] construct the shortest 'route' between center and origin
+ * [4] use the 'route' to run back home to finish search run
+ * [5] use the 'route' to run to center for speed run
+ * [6] use the 'route' to run back home for speed run 
+ **  
+
+   Initial values:
+   Manhattan Distance = 
+   see ManhattanTable below. (16x16 shown, the same pattern for 32x32)
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 15 |14 |13 |12 |11 |10 | 9 | 8 | 7 | 7 | 8 | 9 |10 |11 |12 |13 |14 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 14 |13 |12 |11 |10 | 9 | 8 | 7 | 6 | 6 | 7 | 8 | 9 |10 |11 |12 |13 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 13 |12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 5 | 6 | 7 | 8 | 9 |10 |11 |12 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 4 | 5 | 6 | 7 | 8 | 9 |10 |11 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |10 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 9  | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 8  | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 | 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 |  
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 7  | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 | 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 6  | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 5  | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 2 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 4  |10 | 9 | 8 | 7 | 6 | 5 | 4 | 3 | 3 | 4 | 5 | 6 | 7 | 8 | 9 |10 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 3  |11 |10 | 9 | 8 | 7 | 6 | 5 | 4 | 4 | 5 | 6 | 7 | 8 | 9 |10 |11 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 2  |12 |11 |10 | 9 | 8 | 7 | 6 | 5 | 5 | 6 | 7 | 8 | 9 |10 |11 |12 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 1  |13 |12 |11 |10 | 9 | 8 | 7 | 6 | 6 | 7 | 8 | 9 |10 |11 |12 |13 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+ 0  |14 |13 |12 |11 |10 | 9 | 8 | 7 | 7 | 8 | 9 |10 |11 |12 |13 |14 |
+    +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
+     0    1   2   3   4   5   6   7   8   9  10  11  12  13  14  15 
+ */
+
+/**
+ * A push onto a full FixedStack or FixedQueue. Their capacities are proven bounds, so this is
+ * a bug, and carrying on would leave a wrong distance field for the mouse to navigate on:
+ * the firmware traps, the simulator asserts.
+ */
+[[noreturn]] inline void fixedOverflow() {
+#ifdef FLOODFILL_FREESTANDING
+    __builtin_trap();
+#else
+    assert(!"FloodFill stack or queue overflow");
+    abort();
+#endif
+}
+
+/**
+ * A stack and a queue of at most N items, stored in the FloodFill itself, so the algorithm
+ * never touches the heap: not in the simulator, not in the firmware (make embedded).
+ * N has to be a bound on what is ever pushed at once, a push onto a full one is fatal.
+ */
+template <typename T, unsigned N>
+class FixedStack {
+public:
+    static const unsigned CAPACITY = N;
+
+    FixedStack() : count(0) {}
+
+    bool empty() const {
+        return count == 0;
+    }
+    unsigned size() const {
+        return count;
+    }
+    const T &top() const {
+        return items[count - 1];
+    }
+    // the item pop takes.
+    const T &next() const {
+        return top();
+    }
+    void push(const T &item) {
+        if(count == N)
+            fixedOverflow();
+        items[count++] = item;
+    }
+    void pop() {
+        count--;
+    }
+    void clear() {
+        count = 0;
+    }
+    // the items, bottom first.
+    const T *contents() const {
+        return items;
+    }
+
+private:
+    T items[N];
+    unsigned count;
+};
+
+template <typename T, unsigned N>
+class FixedQueue {
+public:
+    static const unsigned CAPACITY = N;
+
+    FixedQueue() : head(0), count(0) {}
+
+    bool empty() const {
+        return count == 0;
+    }
+    unsigned size() const {
+        return count;
+    }
+    const T &front() const {
+        return items[head];
+    }
+    // the item pop takes.
+    const T &next() const {
+        return front();
+    }
+    void push(const T &item) {
+        if(count == N)
+            fixedOverflow();
+        items[(head + count++) % N] = item;
+    }
+    void pop() {
+        head = (head + 1) % N;
+        count--;
+    }
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+private:
+    T items[N];
+    unsigned head;
+    unsigned count;
+};
+
+/**
+ * A FixedStack or FixedQueue (Container) of cell numbers below CELLS that holds every cell at
+ * most once: pushing a cell that is in it already does nothing. So it never holds more than
+ * CELLS, which is its capacity.
+ */
+template <typename Container, typename Index, unsigned CELLS>
+class CellSet {
+public:
+    static_assert(Container::CAPACITY >= CELLS, "every cell at once has to fit");
+    static_assert(CELLS - 1 <= (Index)~(Index)0, "every cell number has to fit an Index");
+
+    CellSet() {
+        clearMembers();
+    }
+
+    bool empty() const {
+        return items.empty();
+    }
+    unsigned size() const {
+        return items.size();
+    }
+    const Index &top() const {
+        return items.top();
+    }
+    const Index &front() const {
+        return items.front();
+    }
+    void push(Index cell) {
+        uint32_t &word = members[cell / 32];
+        const uint32_t bit = 1u << (cell % 32);
+        if(word & bit)
+            return;
+        word |= bit;
+        items.push(cell);
+    }
+    void pop() {
+        const Index cell = items.next();
+        members[cell / 32] &= ~(1u << (cell % 32));
+        items.pop();
+    }
+    void clear() {
+        items.clear();
+        clearMembers();
+    }
+
+private:
+    void clearMembers() {
+        for(unsigned w = 0; w != WORDS; w++)
+            members[w] = 0;
+    }
+
+    static const unsigned WORDS = (CELLS + 31) / 32;
+    Container items;
+    uint32_t members[WORDS];
+};
+
+// time stamp counter, to compare the flood kernels in cycles. 0 where there is none.
+static inline uint64_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Initial distances of a LEN x LEN maze (the Manhattan distances illustrated above),
+ * generated at compile time for every maze size FloodFill is instantiated for.
+ */
+template <unsigned LEN>
+struct ManhattanTable {
+    typedef typename MazeDefinitions::Size<LEN>::Distance Distance;
+
+    constexpr ManhattanTable() : distance() {
+        for(unsigned x = 0; x < LEN; x++)
+            for(unsigned y = 0; y < LEN; y++)
+                distance[x][y] = get(x, y);
+    }
+
+    // distance from (x,y) to the closest center cell, ignoring walls.
+    static constexpr Distance get(unsigned x, unsigned y) {
+        return (x < LEN / 2 ? LEN / 2 - 1 - x : x - LEN / 2) +
+               (y < LEN / 2 ? LEN / 2 - 1 - y : y - LEN / 2);
+    }
+
+    Distance distance[LEN][LEN];
+};
+
+template <unsigned LEN>
+constexpr ManhattanTable<LEN> manhattanTable;
+
+static_assert(manhattanTable<16>.distance[0][0] == 14 && manhattanTable<16>.distance[8][7] == 0, "see the illustration above");
+static_assert(manhattanTable<32>.distance[0][0] == 30 && manhattanTable<32>.distance[31][31] == 30, "corners of a half-size maze");
+
+// similar to LeftWallFollower. JK, not really.
+// Instantiated for the classic (FloodFill) and the half-size (HalfSizeFloodFill) maze.
+template <unsigned LEN>
+#ifdef FLOODFILL_FREESTANDING
+class BasicFloodFill {
+#else
+class BasicFloodFill : public BasicPathFinder<LEN> {
+#endif
+public:
+    // cell numbers (x * LEN + y): uint8_t for 16x16, uint16_t for 32x32.
+    typedef typename MazeDefinitions::Size<LEN>::Index Index;
+    typedef typename MazeDefinitions::Size<LEN>::Distance Distance;
+
+    // larger than any distance in the maze. Used as the initial minimum when looking for the smallest neighbor.
+    static const unsigned INFINITY_DISTANCE = MazeDefinitions::Size<LEN>::MAX_DISTANCE;
+
+
+    /*******
+     * 
+     * Helper Structures
+     *
+     **/
+
+    // algorithm mode
+    enum Mode
+    {
+        MODE_SEARCH,        // finding distances. Mouse should be at the center when done searching.
+        MODE_BACK_HOME,     // After we reach center, find a way to go back home.    
+        MODE_FAST,          // second run to center. Speed run.
+        MODE_FAST_BACK_HOME // second run to origin
+    };
+
+    /**
+     * Cell structure contains information of a single cell of the map.
+     * info includes:  
+     * bool northWall, southWall, eastWall, westWall
+     *      4 adjacent wall status.
+     *      When the mouse walks through the cell, it records the adjacent wall status.
+     * unsigned distance:
+     *      initially, 'distance' hold Manhatan distance(see the above illustration). 
+     *      This value will be modified after applying floodfill algorithm (step 2).
+     * bool visited:
+     *      Tells us whether or not the mouse has visited this cell. We need this because 
+     *      only the cell that the mouse has visited has valid wall status. So before we check
+     *      wall status, we need to make sure that the cell is visited.
+     */
+    struct Cell{
+        Cell(){
+            northWall = true;
+            southWall = true;
+            eastWall = true;
+            westWall = true;
+            visited = false;
+            seen = 0;
+        }
+        void setWall(Dir d, bool set = false){
+            switch(d){
+                case NORTH: 
+                    northWall = set;
+                    break;
+                case SOUTH: 
+                    southWall = set;
+                    break;
+                case EAST: 
+                    eastWall = set;
+                    break;
+                case WEST: 
+                    westWall = set;
+                    break;
+            }
+        }
+        void setDistance(unsigned newDistance){
+            distance = newDistance;
+        }
+
+        bool northWall;
+        bool southWall;
+        bool eastWall;
+        bool westWall;
+        bool visited;
+        // 1 << Dir for each wall seen by the long-range sensors (see ingest).
+        uint8_t seen;
+        Distance distance;
+        Index cx, cy;
+    };
+
+    /**
+     * Algorithm counters, written as JSON by writeStats at the end of a run.
+     * Lets algorithm changes be compared on the work done, not only on the number of steps.
+     */
+    struct Stats {
+        Stats(){
+            refloods = 0;
+            refloodCells = 0;
+            maxRefloodCells = 0;
+            currentRefloodCells = 0;
+            peakRefloodStack = 0;
+            assignCells = 0;
+            peakAssignQueue = 0;
+            findMinDistanceCalls = 0;
+            assigns = 0;
+            refloodCycles = 0;
+            assignCycles = 0;
+            relaxSweeps = 0;
+            sensedCells = 0;
+            routeLength = 0;
+            routeCells = 0;
+            for (int m = 0; m != Finish + 1; m++)
+                movements[m] = 0;
+        }
+
+#ifndef FLOODFILL_FREESTANDING
+        // add the counters of another FloodFill (the planner's).
+        void merge(const Stats &other);
+#endif
+
+        // refloods started by SearchMode, and the cells they re-evaluated.
+        unsigned long refloods;
+        unsigned long refloodCells;
+        unsigned long maxRefloodCells;
+        unsigned long currentRefloodCells;
+        unsigned long peakRefloodStack;
+        // cells taken off the queue by assign_new_dis, and the longest the queue got.
+        unsigned long assignCells;
+        unsigned long peakAssignQueue;
+        unsigned long findMinDistanceCalls;
+        // calls to assign_new_dis, and the time stamp counter cycles spent in the two flood kernels.
+        unsigned long assigns;
+        unsigned long long refloodCycles;
+        unsigned long long assignCycles;
+        // passes over the whole maze made by the relaxation kernel (-x).
+        unsigned long relaxSweeps;
+        // cells the long-range sensors saw all four walls of before the mouse got there (-l).
+        unsigned long sensedCells;
+        // instructions in the route, and how many of them move to the next cell.
+        unsigned long routeLength;
+        unsigned long routeCells;
+        // returned by nextMovement, by type.
+        unsigned long movements[Finish + 1];
+        // cells the mouse stood in, per mode.
+        BitVector<LEN> cellsVisited[MODE_FAST_BACK_HOME + 1];
+    };
+
+#ifndef FLOODFILL_FREESTANDING
+    /**
+     * Everything a FloodFill knows between two movements, see snapshot and restore.
+     * state is plain data of a fixed size. The map, the large part, is shared by every copy of
+     * the snapshot and only copied into a FloodFill when it restores it, so forking many
+     * continuations from one snapshot costs a copy of the state each.
+     */
+    struct Snapshot {
+        struct Map {
+            Cell cells[LEN][LEN];
+        };
+        struct State {
+            Mode mode;
+            unsigned currMDistance;
+            Dir currHeading;
+            unsigned minMDistance;
+            MouseMovement retval;
+            bool frontWall;
+            bool leftWall;
+            bool rightWall;
+            unsigned long suspensions;
+            Stats stats;
+            // the route stacks, bottom first.
+            unsigned routeSize1;
+            unsigned routeSize2;
+            uint8_t route1[2 * MazeDefinitions::Size<LEN>::CELLS];
+            uint8_t route2[2 * MazeDefinitions::Size<LEN>::CELLS];
+        };
+        std::shared_ptr<const Map> map;
+        State state;
+    };
+
+    // background planner, see the implementation below FloodFill.
+    class Planner;
+#endif
+
+    // initial setup
+    BasicFloodFill(bool shouldPause = false, bool shouldPrint = false, bool shouldDemo = false, bool shouldQuiet = false, bool shouldPlanAsync = false,
+                   bool shouldRelax = false)
+    : pause(shouldPause), verbose(shouldPrint), demo(shouldDemo), quiet(shouldQuiet), relaxKernel(shouldRelax) {
+        // define initial heading to be north
+        currHeading = NORTH;
+        // default mode is search mode.
+        mode = MODE_SEARCH;
+        retval = Wait;
+        budgeted = false;
+        suspensions = 0;
+        routeCell = NULL;
+        routePending = false;
+        // construct map with Manhatan distances
+        for (int r = 0; r != LEN; r++){
+            for (int c = 0; c != LEN; c++){
+                map[r][c].distance=manhattanTable<LEN>.distance[r][c];
+                map[r][c].cx = r;
+                map[r][c].cy = c;
+            }
+        }      
+#ifdef FLOODFILL_FREESTANDING
+        // the firmware has no threads.
+        (void)shouldPlanAsync;
+#else
+        planner = NULL;
+        postedUpdates = 0;
+        routeRequested = false;
+        if(shouldPlanAsync)
+            startPlanner();
+#endif
+    }
+
+#ifndef FLOODFILL_FREESTANDING
+    ~BasicFloodFill();
+
+    // called by the maze before nextMovement when it has a time budget.
+    void setDeadline(std::chrono::steady_clock::time_point newDeadline) {
+        budgeted = true;
+        deadline = newDeadline;
+    }
+#endif
+
+    // number of times work was suspended because the deadline passed.
+    unsigned long getSuspensions() const {
+        return suspensions;
+    }
+
+
+#ifdef FLOODFILL_FREESTANDING
+    /**
+     * The firmware's entry point, called once the mouse stands in a cell.
+     * @param sensors: anything with wallInFront(), wallOnLeft() and wallOnRight() for the walls of the cell
+     */
+    template <typename Sensors>
+    MouseMovement nextMovement(unsigned x, unsigned y, const Sensors &sensors) {
+        stats.cellsVisited[mode].set(x, y);
+        MouseMovement movement = chooseMovement(x, y, sensors);
+        stats.movements[movement]++;
+        return movement;
+    }
+#else
+    MouseMovement nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze) {
+        ALLOC_GROUP("FloodFill::nextMovement");
+        ALLOC_PHASE(modeName(mode));
+
+        stats.cellsVisited[mode].set(x, y);
+        MouseMovement movement = chooseMovement(x, y, maze);
+        stats.movements[movement]++;
+        return movement;
+    }
+
+    // write the algorithm counters as a JSON object.
+    void writeStats(std::ostream &out) const;
+#endif
+
+    // distance of a cell in the map, recorded in replays (-w).
+    unsigned getDistance(unsigned x, unsigned y) const {
+        return map[x][y].distance;
+    }
+
+    // algorithm counters of this FloodFill, without the planner's.
+    const Stats &getStats() const {
+        return stats;
+    }
+
+    // the algorithm mode, e.g. to know whether a fork can take another turn.
+    Mode getMode() const {
+        return mode;
+    }
+
+    // name of an algorithm mode, e.g. "MODE_SEARCH".
+    static const char *modeName(Mode m);
+
+#ifndef FLOODFILL_FREESTANDING
+    // Take a snapshot between two movements. Fails with the background planner (-a), whose
+    // shadow map is not part of it, and while a reflood or the route construction is suspended.
+    bool snapshot(Snapshot &out) const;
+
+    // continue from a snapshot, of this or of another FloodFill of the same maze. Fails with the background planner.
+    bool restore(const Snapshot &in);
+#endif
+
+    // the maze carried out movement instead of asking us (see BasicMouseSession::force):
+    // account for the movement returned last and take this one as the last instead.
+    void forced(MouseMovement movement) {
+        setHead(currHeading, retval);
+        retval = movement;
+    }
+
+#ifndef FLOODFILL_FREESTANDING
+    // hash of the map, the mode, the heading and the route, for loop detection. Fails with the background
+    // planner (-a) and with a time budget (-b), where the movements depend on timing.
+    bool getStateHash(uint64_t &hash) const;
+#endif
+
+    // bump with every change to the algorithm that can change a run, cached results of older versions are not used.
+    static const unsigned VERSION = 3;
+
+#ifndef FLOODFILL_FREESTANDING
+    // a run with the background planner depends on the timing of the threads and is not cached.
+    std::string getId() const {
+        if(planner)
+            return "";
+        return std::string("floodfill") + (demo ? "-demo" : "") + (relaxKernel ? "-relax" : "");
+    }
+
+    unsigned getVersion() const {
+        return VERSION;
+    }
+#endif
+
+protected:
+
+    // print a message of the run. The firmware has nowhere to print it.
+    static void say(const char *message) {
+#ifdef FLOODFILL_FREESTANDING
+        (void)message;
+#else
+        std::cout << message << std::endl;
+#endif
+    }
+
+    // boss function. maze is the mouse's session, or the firmware's sensors.
+    template <typename Sensors>
+    MouseMovement chooseMovement(unsigned x, unsigned y, const Sensors &maze) {
+        // get current cell wall status. (using IR sensors)
+        frontWall = maze.wallInFront();
+        leftWall  = maze.wallOnLeft();
+        rightWall = maze.wallOnRight();
+        // obtain the distance of the current cell that the mouse is at.
+        currMDistance = map[x][y].distance;
+
+        // obtain the current heading
+        setHead(currHeading, retval);
+        // currHeading = maze.getHeading();   // North | South | East | West
+
+#ifndef FLOODFILL_FREESTANDING
+        // Pause at each cell if the user requests it.
+        // It allows for better viewing on command line.
+        if(pause) {
+            if(verbose)
+                Log::flush();
+            std::cout << "Hit enter to continue..., (" << x << "," << y << "), M=" << currMDistance << " head " << currHeading << std::endl;
+            std::cin.ignore(10000, '\n');
+            std::cin.clear();
+        }
+
+        if(!quiet) {
+            // keep the debug log of the last move above the drawing.
+            if(verbose)
+                Log::flush();
+            std::cout << maze.draw(5) << "\n\n";
+        }
+#endif
+
+        // If we somehow miraculously hit the center
+        // of the maze, then:
+        // [1] if it is just for the demo, then we are done.
+        // [2] if it is the search run, then it means we finished searching and we should start heading back home.
+        // [3] if it is the speed run, then we are done done !!!! hoo-ray
+        if(isAtCenter(x, y)) {
+            if(demo){
+                say("Found center! Good enough for the demo, won't try to get back.");
+                return Finish;
+            }
+            if(mode == MODE_FAST){
+                say("Fast run half way through!");
+                setMode(MODE_FAST_BACK_HOME, x, y);
+                return TurnAround;
+            }
+            if(mode == MODE_SEARCH){
+#ifndef FLOODFILL_FREESTANDING
+                if(planner){
+                    // the planner builds the route while we turn around.
+                    requestRoute(x, y);
+                    setMode(MODE_BACK_HOME, x, y);
+                    return TurnAround;
+                }
+#endif
+                // a suspended reflood does not matter anymore, all distances are reassigned.
+                refloodSt.clear();
+                clearVisits();
+                routePending = !(assign_new_dis(&map[x][y]) && constructRoute());
+                setMode(MODE_BACK_HOME, x, y);
+                return TurnAround;
+            }
+        }
+
+        // If we hit the start of the maze on the way home, we've reached end goal of a home run.
+        // A search that cannot find the center is cut off by the maze's step limit (see BasicMouseSession::setStepLimit).
+        if(x == 0 && y == 0) {
+            if(mode == MODE_BACK_HOME){
+                say("Back home run finished!");
+                setMode(MODE_FAST, x, y);
+                return TurnAround;
+            }else if(mode == MODE_FAST_BACK_HOME){
+                say("Fast run FINISH!!!!");
+                return Finish;
+            }
+        }
+
+#ifndef FLOODFILL_FREESTANDING
+        // walls further ahead, when the sensors see them. The planner's shadow map does not take them.
+        if(mode == MODE_SEARCH && !planner && (maze.getSensorRange().front || maze.getSensorRange().side))
+            ingest(x, y, maze);
+#endif
+
+        // switch to algorithm
+        switch(mode){
+            case MODE_SEARCH:
+#ifndef FLOODFILL_FREESTANDING
+                if(planner){
+                    AsyncSearchMode(x,y);
+                    break;
+                }
+#endif
+                SearchMode(x,y);
+            break;
+            case MODE_BACK_HOME:
+            case MODE_FAST_BACK_HOME:
+                HomeBoundMode(x,y);
+            break;
+            case MODE_FAST:
+                FastMode();
+            break;
+        }
+        return retval;
+            
+    }
+
+    // debugging purpose. When specify -v option, output more stuffs.
+    bool verbose; 
+    // demo. When specify -d option, only run search mode. By default this is false;
+    bool demo;
+    // quiet. When specify -q option, do not draw the maze at every move.
+    bool quiet;
+    // relax. When specify -x option, reflood and assign_new_dis run the whole-maze relaxation kernel (RelaxKernel.h).
+    bool relaxKernel;
+
+    Mode mode;
+
+    // Indicates we should pause before moving to next cell.
+    // Useful for command line usage.
+    const bool pause;
+
+    // the current Manhattan distance.
+    unsigned currMDistance;
+    // current heading of the mouse. 
+    Dir currHeading;
+
+    unsigned minMDistance;
+    MouseMovement retval;
+
+    // keep track of current neighboring walls status
+    bool frontWall;
+    bool leftWall;
+    bool rightWall;
+
+    // map that holds distances. initially it contains manhatan distances, later on will be modified using floodfill algorithm.
+    Cell map[LEN][LEN];
+
+    Cell &cellAt(Index i){
+        return map[i / LEN][i % LEN];
+    }
+    static Index indexOf(const Cell &c){
+        return c.cx * LEN + c.cy;
+    }
+
+    // construct fastest route (stacks) for homebound mode and fast mode
+    // preprocess: construct routeSt1, starting from origin and ending at center
+    // homebound: pop instructions from routeSt1 and push them in routeSt2
+    // fast run: pop instructions from routeSt2 and push them in routeSt1. 
+    // A route only moves forward downhill, into a cell of a smaller distance than the last, so it
+    // visits every cell at most once, with at most a turn before every move. MouseMovements, a byte each.
+    typedef FixedStack<uint8_t, 2 * MazeDefinitions::Size<LEN>::CELLS> RouteStack;
+    static_assert(RouteStack::CAPACITY >= 2 * MazeDefinitions::Size<LEN>::CELLS, "a turn and a move per cell");
+    RouteStack routeSt1;
+    RouteStack routeSt2;
+
+    // algorithm counters.
+    Stats stats;
+
+#ifndef FLOODFILL_FREESTANDING
+    // Background planner. NULL unless constructed with shouldPlanAsync (-a option).
+    // When present, refloods and route construction run on the planner thread and
+    // the search reads the last published distance field instead of reflooding itself.
+    Planner *planner;
+    // number of wall updates handed to the planner so far.
+    unsigned postedUpdates;
+    // the route has been requested from the planner but not picked up yet.
+    bool routeRequested;
+#endif
+
+    // Anytime planning. Set when the maze gives us a deadline (see setDeadline).
+    // Refloods and route construction stop once the deadline has passed and are resumed on the next call.
+    bool budgeted;
+#ifndef FLOODFILL_FREESTANDING
+    std::chrono::steady_clock::time_point deadline;
+#endif
+    // number of times a reflood or the route construction was suspended.
+    unsigned long suspensions;
+    // cells still to be processed by a suspended reflood, and by a suspended assign_new_dis.
+    // A cell is in either at most once, so they never hold more than every cell.
+    typedef CellSet<FixedStack<Index, MazeDefinitions::Size<LEN>::CELLS>, Index, MazeDefinitions::Size<LEN>::CELLS> RefloodStack;
+    typedef CellSet<FixedQueue<Index, MazeDefinitions::Size<LEN>::CELLS>, Index, MazeDefinitions::Size<LEN>::CELLS> AssignQueue;
+    RefloodStack refloodSt;
+    AssignQueue assignQu;
+    // input and output of the relaxation kernel.
+    Relax::Field<LEN> field;
+#ifndef FLOODFILL_FREESTANDING
+    // the walls the long-range sensors see from the current cell.
+    WallObservation observations[BasicMouseSession<LEN>::MAX_OBSERVATIONS];
+#endif
+    // next cell of a suspended constructRoute, NULL when route construction is not in progress.
+    Cell* routeCell;
+    Dir routeHeading;
+    // route construction was started at the center but is not finished yet.
+    bool routePending;
+
+
+    /*******
+     * 
+     * Member Functions Declaration
+     * (Implementation is at the bottom of the file)
+     *
+     **/
+
+    // In the case that we can't have access to the heading in MouseSession.h, this function helps us keep track of the current heading.
+    // We call this function at the beginning of nextmovement() so we have updated heading. 
+    void setHead(Dir &oldHeading, MouseMovement insn);
+
+    // same as left follower. Check if the mouse is at the center of the maze.
+    bool isAtCenter(unsigned x, unsigned y) const;
+
+    // reset visit history of all cells.
+    void clearVisits();
+
+    // switch algorithm mode and record the transition in the trace.
+    void setMode(Mode newMode, unsigned x, unsigned y);
+
+    // for search mode step one. Does two things:
+    // [1] use front, right, left wall status to find min distance.
+    // [2] assign return value.(mouse movement)
+    void find_minDistance_and_nextInsn(unsigned x, unsigned y);
+
+    // Used in constructing route. Very similar to 'find_minDistance_and_nextInsn'.
+    // use front, right, left wall status to find min distance.
+    // The difference is that it only checks the adjacent cells that the mouse has already visited
+    void find_minDistance_and_nextInsn_II(unsigned x, unsigned y, Dir funcHeading);
+
+    // get new values of forwardX and forwardY. 
+    // if current cell is at (x.y)
+    // Cell at the front     ==> (x+forwardX, y+forwardY)
+    // Cell on the right     ==> (x + forwardY, y - forwardX)
+    // Cell on the left      ==> (x - forwardY, y + forwardX)
+    void getForwardXY(unsigned &forwardX, unsigned &forwardY, Dir &heading);
+
+    // use north,south,east,west wall status to find min distance 
+    // when isConstructingRoute is set, check only the cells that the mouse has visited.
+    Cell* findMinDistance(unsigned cx, unsigned cy, bool isConstructingRoute = false);
+
+    // Call this after the mouse searched the center for the first time.
+    // This function reassign the distance of all cells based on its 'physical' shortest path from the center. (i.e. consider walls)
+    // need to call 'clearVisits' before using this function.
+    // returns false if the deadline passed first, call resumeAssign to continue.
+    bool assign_new_dis(Cell* currCell);
+    bool resumeAssign();
+
+    // After the mouse reached the center for the first time and the distances map has been reassigned,
+    // we call this function to construct the 'shortest' route from origin(home) to center.
+    // we have two stacks, routeSt1 and routeSt2. routeSt1 stores the instructions needed to traverse from center to home
+    // routeSt2 will store the same but in reverse order when we run HomeBoundMode because routeSt2 push whatever routeSt1 pop. 
+    // returns false if the deadline passed first, call resumeRoute to continue.
+    bool constructRoute();
+    bool resumeRoute();
+
+    // continue whichever part of a suspended route construction is left. returns true once the route is complete.
+    bool finishRoute();
+
+    // step 2 of search mode. Apply floodfill algorithm starting from cell (x,y):
+    // re-evaluate the distance of every visited, connected cell whose distance is no longer consistent.
+    // returns false if the deadline passed first, call resumeReflood to continue.
+    bool reflood(unsigned x, unsigned y);
+    bool resumeReflood();
+
+    // reflood and assign_new_dis with the relaxation kernel: every visited cell, respectively
+    // every cell, at once. They do not stop at the deadline and always return true.
+    bool relaxReflood(unsigned x, unsigned y);
+    bool relaxAssign(Cell* centerCell);
+    // copy the walls and distances of map into field.
+    void fillField();
+
+    // true if there is a deadline and it has passed. Counts the suspension.
+    bool expired();
+
+#ifndef FLOODFILL_FREESTANDING
+    // take in the walls the long-range sensors see (see BasicMouseSession::sense). A cell whose four
+    // walls are known counts as visited and is reflooded from, so the search turns away from dead
+    // ends it can see instead of driving into them.
+    void ingest(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze);
+#endif
+    // note a wall seen from cell (x, y), and mark the cell visited once all its walls are known.
+    void sawWall(unsigned x, unsigned y, Dir side, bool closed);
+
+    // First run searching center
+    void SearchMode(unsigned x, unsigned y);
+
+#ifndef FLOODFILL_FREESTANDING
+    // Search mode used with the background planner. Same as SearchMode, except that
+    // the reflood is posted to the planner and this only waits when the last published
+    // distance field leaves the mouse without a downhill neighbor.
+    void AsyncSearchMode(unsigned x, unsigned y);
+
+    // start the planner thread. Used by the constructor when shouldPlanAsync is set.
+    void startPlanner();
+
+    // post the wall status of cell (x,y) to the planner.
+    void postWalls(unsigned x, unsigned y);
+
+    // ask the planner to reassign distances from center cell (x,y) and construct the route.
+    void requestRoute(unsigned x, unsigned y);
+#endif
+
+    // First run going back home and speed run running back home
+    void HomeBoundMode(unsigned x, unsigned y);
+
+    // Speed run running to center
+    void FastMode();
+
+};
+
+#ifndef FLOODFILL_FREESTANDING
+/**
+ *
+ * Background planner
+ *
+ * The planner thread owns a shadow FloodFill. Wall updates are handed over through a
+ * single-producer/single-consumer ring. After applying them, the planner refloods its
+ * shadow map and publishes the distances into one of two buffers. Each buffer is guarded
+ * by a sequence counter (odd while being written), so the mouse never takes a lock or
+ * blocks on the planner to read the field.
+ */
+template <unsigned LEN>
+class BasicFloodFill<LEN>::Planner {
+public:
+    // bit set in Update::walls when the corresponding wall is present.
+    enum WallBit { NORTH_BIT = 1, SOUTH_BIT = 2, EAST_BIT = 4, WEST_BIT = 8 };
+
+    // one message to the planner.
+    struct Update {
+        Index x, y;
+        uint8_t walls;
+        // after applying the walls, reassign distances from (x,y) and construct the route.
+        bool route;
+    };
+
+    // every cell is posted once, plus the route request, so this can never fill up.
+    static const unsigned RING_SIZE = 2 * MazeDefinitions::Size<LEN>::CELLS;
+
+    explicit Planner(bool relax);
+    ~Planner();
+
+    // hand an update over to the planner thread. Returns false if the ring is full.
+    bool post(const Update &u);
+
+    // copy the last published distances into map.
+    // @return number of updates reflected in the copied distances.
+    unsigned read(Cell map[][LEN]) const;
+
+    // true once the route requested with Update::route has been constructed.
+    bool routeReady() const {
+        return routeDone.load(std::memory_order_acquire);
+    }
+
+    // planner's copy of the algorithm. Only safe to read once routeReady() is true.
+    const BasicFloodFill &result() const {
+        return shadow;
+    }
+
+private:
+    // planner thread main loop.
+    void run();
+    // apply a single update to the shadow map.
+    void apply(const Update &u);
+    // publish the shadow distances into the back buffer and flip it to the front.
+    void publish();
+
+    BasicFloodFill shadow;
+    unsigned applied;
+
+    Update ring[RING_SIZE];
+    std::atomic<unsigned> head;     // next slot to read, owned by the planner
+    std::atomic<unsigned> tail;     // next slot to write, owned by the mouse
+
+    std::atomic<unsigned> front;
+    std::atomic<unsigned> seq[2];
+    std::atomic<unsigned> version[2];
+    std::atomic<Distance> distance[2][LEN][LEN];
+
+    std::atomic<bool> routeDone;
+    std::atomic<bool> stop;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread worker;
+};
+#endif
+
+typedef BasicFloodFill<MazeDefinitions::MAZE_LEN> FloodFill;
+typedef BasicFloodFill<MazeDefinitions::HALF_SIZE_MAZE_LEN> HalfSizeFloodFill;
+
+/**
+ *
+ * FloodFill member functions implementation
+ *
+ */
+template <unsigned LEN>
+void BasicFloodFill<LEN>::setHead(Dir &oldHeading, MouseMovement insn){
+    switch(insn){
+        case TurnAround:
+            oldHeading = opposite(oldHeading);
+            return;
+        case TurnClockwise:
+            oldHeading = clockwise(oldHeading);
+            return;
+        case TurnCounterClockwise:
+            oldHeading = counterClockwise(oldHeading);
+            return;
+    }
+}
+
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::isAtCenter(unsigned x, unsigned y) const {
+    unsigned midpoint = LEN / 2;
+
+    if(LEN % 2 != 0) {
+        return x == midpoint && y == midpoint;
+    }
+
+    return  (x == midpoint     && y == midpoint    ) ||
+    (x == midpoint - 1 && y == midpoint    ) ||
+    (x == midpoint     && y == midpoint - 1) ||
+    (x == midpoint - 1 && y == midpoint - 1);
+}
+
+// switch algorithm mode and record the transition in the trace.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::setMode(Mode newMode, unsigned x, unsigned y){
+    Trace::instant(modeName(newMode), "mode", x, y);
+    mode = newMode;
+}
+
+// name of an algorithm mode, e.g. "MODE_SEARCH".
+template <unsigned LEN>
+const char *BasicFloodFill<LEN>::modeName(Mode m){
+    static const char *names[] = { "MODE_SEARCH", "MODE_BACK_HOME", "MODE_FAST", "MODE_FAST_BACK_HOME" };
+    return names[m];
+}
+
+#ifndef FLOODFILL_FREESTANDING
+// add the counters of another FloodFill (the planner's).
+template <unsigned LEN>
+void BasicFloodFill<LEN>::Stats::merge(const Stats &other){
+    refloods += other.refloods;
+    refloodCells += other.refloodCells;
+    maxRefloodCells = std::max(maxRefloodCells, other.maxRefloodCells);
+    peakRefloodStack = std::max(peakRefloodStack, other.peakRefloodStack);
+    assignCells += other.assignCells;
+    peakAssignQueue = std::max(peakAssignQueue, other.peakAssignQueue);
+    findMinDistanceCalls += other.findMinDistanceCalls;
+    assigns += other.assigns;
+    refloodCycles += other.refloodCycles;
+    assignCycles += other.assignCycles;
+    relaxSweeps += other.relaxSweeps;
+    sensedCells += other.sensedCells;
+    routeLength += other.routeLength;
+    routeCells += other.routeCells;
+}
+
+// write the algorithm counters as a JSON object.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::writeStats(std::ostream &out) const {
+    Stats all = stats;
+    // with -a the planner did the refloods and built the route. It is idle once the run is over.
+    if(planner)
+        all.merge(planner->result().stats);
+
+    out << "{\"refloods\":" << all.refloods
+        << ",\"refloodCells\":" << all.refloodCells
+        << ",\"cellsPerReflood\":" << (all.refloods ? (double)all.refloodCells / all.refloods : 0.0)
+        << ",\"maxRefloodCells\":" << all.maxRefloodCells
+        << ",\"peakRefloodStack\":" << all.peakRefloodStack
+        << ",\"assignCells\":" << all.assignCells
+        << ",\"peakAssignQueue\":" << all.peakAssignQueue
+        << ",\"findMinDistanceCalls\":" << all.findMinDistanceCalls
+        << ",\"kernel\":\"" << (relaxKernel ? Relax::instructionSet() : "per cell") << "\""
+        << ",\"refloodCycles\":" << all.refloodCycles
+        << ",\"assigns\":" << all.assigns
+        << ",\"assignCycles\":" << all.assignCycles
+        << ",\"relaxSweeps\":" << all.relaxSweeps
+        << ",\"sensedCells\":" << all.sensedCells
+        << ",\"routeLength\":" << all.routeLength
+        << ",\"routeCells\":" << all.routeCells
+        << ",\"movements\":{";
+    for (int m = MoveForward; m <= Finish; m++)
+        out << (m == MoveForward ? "" : ",") << "\"" << movementName((MouseMovement)m) << "\":" << all.movements[m];
+    out << "},\"cellsVisited\":{";
+    for (int m = MODE_SEARCH; m <= MODE_FAST_BACK_HOME; m++)
+        out << (m == MODE_SEARCH ? "" : ",") << "\"" << modeName((Mode)m) << "\":" << all.cellsVisited[m].count();
+    out << "}}";
+}
+
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::getStateHash(uint64_t &hash) const {
+    if(planner || budgeted)
+        return false;
+
+    // FNV-1a over a word per cell and a word per route instruction. The counters are left out.
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned x = 0; x != LEN; x++){
+        for (unsigned y = 0; y != LEN; y++){
+            const Cell &c = map[x][y];
+            const uint64_t word = (uint64_t)c.distance << 16 | (uint64_t)c.seen << 8 | c.visited << 4 |
+                                  c.northWall << 3 | c.southWall << 2 | c.eastWall << 1 | c.westWall;
+            h = (h ^ word) * 1099511628211ull;
+        }
+    }
+    h = (h ^ ((uint64_t)mode << 16 | (uint64_t)currHeading << 8 | retval)) * 1099511628211ull;
+    for (unsigned i = 0; i != routeSt1.size(); i++)
+        h = (h ^ (0x100 | routeSt1.contents()[i])) * 1099511628211ull;
+    for (unsigned i = 0; i != routeSt2.size(); i++)
+        h = (h ^ (0x200 | routeSt2.contents()[i])) * 1099511628211ull;
+    hash = h;
+    return true;
+}
+
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::snapshot(Snapshot &out) const {
+    static_assert(std::is_trivially_copyable<typename Snapshot::State>::value, "the state is copied as plain data");
+    if(planner || routeCell || routePending || !refloodSt.empty() || assignQu.size())
+        return false;
+
+    std::shared_ptr<typename Snapshot::Map> copy = std::make_shared<typename Snapshot::Map>();
+    std::copy(&map[0][0], &map[0][0] + LEN * LEN, &copy->cells[0][0]);
+    out.map = copy;
+
+    typename Snapshot::State &st = out.state;
+    st.mode = mode;
+    st.currMDistance = currMDistance;
+    st.currHeading = currHeading;
+    st.minMDistance = minMDistance;
+    st.retval = retval;
+    st.frontWall = frontWall;
+    st.leftWall = leftWall;
+    st.rightWall = rightWall;
+    st.suspensions = suspensions;
+    st.stats = stats;
+    st.routeSize1 = routeSt1.size();
+    st.routeSize2 = routeSt2.size();
+    std::copy(routeSt1.contents(), routeSt1.contents() + routeSt1.size(), st.route1);
+    std::copy(routeSt2.contents(), routeSt2.contents() + routeSt2.size(), st.route2);
+    return true;
+}
+
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::restore(const Snapshot &in){
+    if(planner || !in.map)
+        return false;
+
+    std::copy(&in.map->cells[0][0], &in.map->cells[0][0] + LEN * LEN, &map[0][0]);
+
+    const typename Snapshot::State &st = in.state;
+    mode = st.mode;
+    currMDistance = st.currMDistance;
+    currHeading = st.currHeading;
+    minMDistance = st.minMDistance;
+    retval = st.retval;
+    frontWall = st.frontWall;
+    leftWall = st.leftWall;
+    rightWall = st.rightWall;
+    suspensions = st.suspensions;
+    stats = st.stats;
+    // the stacks are part of the FloodFill, restoring does not allocate.
+    routeSt1.clear();
+    for (unsigned i = 0; i != st.routeSize1; i++)
+        routeSt1.push((MouseMovement)st.route1[i]);
+    routeSt2.clear();
+    for (unsigned i = 0; i != st.routeSize2; i++)
+        routeSt2.push((MouseMovement)st.route2[i]);
+    // a snapshot is never taken with work suspended.
+    refloodSt.clear();
+    assignQu.clear();
+    routeCell = NULL;
+    routePending = false;
+    return true;
+}
+#endif
+
+// reset visit history of all cells.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::clearVisits(){
+    for (int r = 0; r != LEN; r++){
+        for (int c = 0; c != LEN; c++){
+            map[r][c].visited = false;
+        }
+    }
+}
+
+// Call this after the mouse searched the center for the first time.
+// This function reassign the distance of all cells based on its 'physical' shortest path from the center. (i.e. consider walls)
+// need to call 'clearVisits' before using this function.
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::assign_new_dis(Cell* currCell){
+    stats.assigns++;
+    if(relaxKernel)
+        return relaxAssign(currCell);
+    currCell->distance = 0;
+    assignQu.clear();
+    assignQu.push(indexOf(*currCell));
+    return resumeAssign();
+}
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::resumeAssign(){
+    AssignQueue &qu = assignQu;
+    Trace::Span span("assign_new_dis", "FloodFill", cellAt(qu.front()).cx, cellAt(qu.front()).cy);
+    PERF_SCOPE("assign_new_dis");
+    ALLOC_GROUP("assign_new_dis");
+    const uint64_t begin = cycleCount();
+    Cell* currCell;
+    // always make some progress, even if the deadline already passed.
+    for(unsigned done = 0; qu.front() != indexOf(map[0][0]); done++){
+        if(done && expired()){
+            stats.assignCycles += cycleCount() - begin;
+            return false;
+        }
+        currCell = &cellAt(qu.front());
+        currCell->visited = true;
+        stats.assignCells++;
+        unsigned newDis = currCell->distance +1;
+        LOG_DEBUG(verbose, "qu.front() = ({},{}). newDis = {}", currCell->cx, currCell->cy, currCell->distance);
+        qu.pop();
+        if(!currCell->northWall && !map[currCell->cx][currCell->cy+1].visited){
+            map[currCell->cx][currCell->cy+1].distance = newDis;
+            qu.push(indexOf(map[currCell->cx][currCell->cy+1]));
+        }
+
+        if(!currCell->southWall && !map[currCell->cx][currCell->cy-1].visited){
+            map[currCell->cx][currCell->cy-1].distance = newDis;
+            qu.push(indexOf(map[currCell->cx][currCell->cy-1]));
+        }
+
+        if(!currCell->eastWall && !map[currCell->cx+1][currCell->cy].visited){
+            map[currCell->cx+1][currCell->cy].distance = newDis;
+            qu.push(indexOf(map[currCell->cx+1][currCell->cy]));
+        }
+
+        if(!currCell->westWall && !map[currCell->cx-1][currCell->cy].visited){
+            map[currCell->cx-1][currCell->cy].distance = newDis;
+            qu.push(indexOf(map[currCell->cx-1][currCell->cy]));
+        }
+        if(qu.size() > stats.peakAssignQueue)
+            stats.peakAssignQueue = qu.size();
+        
+    }
+    currCell = &cellAt(qu.front());
+    currCell->visited = true;
+    LOG_DEBUG(verbose, "qu.front() = ({},{}). newDis = {}", currCell->cx, currCell->cy, currCell->distance);
+    LOG_DEBUG(verbose, "Done assigning new distances.");
+    qu.clear();
+    stats.assignCycles += cycleCount() - begin;
+    return true;
+}
+
+
+// for search mode step one. Does two things:
+// [1] use front, right, left wall status to find min distance.
+// [2] assign return value.(mouse movement)
+template <unsigned LEN>
+void BasicFloodFill<LEN>::find_minDistance_and_nextInsn(unsigned x, unsigned y){
+
+    // calculate the x y coordinates of the 'front' cell.
+    unsigned forwardX, forwardY;
+    getForwardXY(forwardX,forwardY, currHeading);
+   
+    minMDistance = currMDistance;
+
+    // In the below three if clauses, we check the distance of the adjacent cell and 
+    // set the wall status of the adjacent cell & current cell.
+
+    // check the Mdistance of the grid on the left
+    if(!leftWall){
+        map[x][y].setWall(counterClockwise(currHeading));
+        map[x - forwardY][y + forwardX].setWall(clockwise(currHeading));
+        if( map[x - forwardY][y + forwardX].distance <= minMDistance){
+            minMDistance = map[x - forwardY][y + forwardX].distance;
+            retval = TurnCounterClockwise;
+        }
+    }
+
+    // check the Mdistance of the grid on the right
+    if(!rightWall){
+        map[x][y].setWall(clockwise(currHeading));
+        map[x + forwardY][y - forwardX].setWall(counterClockwise(currHeading));
+        if(map[x + forwardY][y - forwardX].distance <= minMDistance){
+            minMDistance = map[x + forwardY][y - forwardX].distance;
+            retval = TurnClockwise;
+        }
+    }
+
+    // check the Mdistance of the grid at the front
+    if(!frontWall){
+        // set wall status of the current cell
+        map[x][y].setWall(currHeading);
+        // set wall status of the cell at the front
+        map[x+ forwardX][y+ forwardY].setWall(opposite(currHeading));
+
+        // find min distance
+        if(map[x + forwardX][y + forwardY].distance <= minMDistance){
+            minMDistance = map[x + forwardX][y + forwardY].distance;
+            retval = MoveForward;
+        }
+    }
+}
+
+
+// Used in constructing route. Very similar to 'find_minDistance_and_nextInsn'.
+// use front, right, left wall status to find min distance.
+// The difference is that it only checks the adjacent cells that the mouse has already visited
+template <unsigned LEN>
+void BasicFloodFill<LEN>::find_minDistance_and_nextInsn_II(unsigned x, unsigned y, Dir funcHeading){
+
+    // calculate the x y coordinates of the 'front' cell.
+    unsigned forwardX = 0;
+    unsigned forwardY = 0;
+    bool func_frontWall, func_leftWall, func_rightWall;
+    switch(funcHeading){
+        case NORTH:
+            func_frontWall = map[x][y].northWall;
+            func_rightWall = map[x][y].eastWall;
+            func_leftWall = map[x][y].westWall;
+            forwardY = 1;
+            break;
+        case SOUTH:
+            func_frontWall = map[x][y].southWall;
+            func_rightWall = map[x][y].westWall;
+            func_leftWall = map[x][y].eastWall;
+            forwardY = -1;
+            break;
+        case EAST:
+            func_frontWall = map[x][y].eastWall;
+            func_rightWall = map[x][y].southWall;
+            func_leftWall = map[x][y].northWall;
+            forwardX = 1;
+            break;
+        case WEST:
+            func_frontWall = map[x][y].westWall;
+            func_rightWall = map[x][y].northWall;
+            func_leftWall = map[x][y].southWall;
+            forwardX = -1;
+            break;
+    }
+    
+    minMDistance = map[x][y].distance;
+
+    // In the below three if clauses, we check the distance of the adjacent cell which the mouse has already visited.
+
+    LOG_DEBUG(verbose, "\nII: ({},{}):", x, y);
+    LOG_DEBUG(verbose, "II: current distance={}", map[x][y].distance);
+    LOG_DEBUG(verbose, "II: func_frontWall={}", func_frontWall);
+    LOG_DEBUG(verbose, "II: func_rightWall={}", func_rightWall);
+    LOG_DEBUG(verbose, "II: func_leftWall={}", func_leftWall);
+    // check the Mdistance of the grid on the left
+    if(!func_leftWall && map[x - forwardY][y + forwardX].visited){
+        LOG_DEBUG(verbose, "II: ({},{}):visited", x - forwardY, y + forwardX);
+        LOG_DEBUG(verbose, "II: ({},{}).distance={}", x - forwardY, y + forwardX, map[x - forwardY][y + forwardX].distance);
+        if( map[x - forwardY][y + forwardX].distance <= minMDistance){
+            minMDistance = map[x - forwardY][y + forwardX].distance;
+            retval = TurnCounterClockwise;
+        }
+    }
+
+    // check the Mdistance of the grid on the right
+    if(!func_rightWall && map[x + forwardY][y - forwardX].visited){
+        LOG_DEBUG(verbose, "II: ({},{}):visited", x + forwardY, y - forwardX);
+        LOG_DEBUG(verbose, "II: ({},{}).distance={}", x + forwardY, y - forwardX, map[x + forwardY][y - forwardX].distance);
+        if(map[x + forwardY][y - forwardX].distance <= minMDistance){
+            minMDistance = map[x + forwardY][y - forwardX].distance;
+            retval = TurnClockwise;
+        }
+    }
+
+    // check the Mdistance of the grid at the front
+    if(!func_frontWall && map[x + forwardX][y + forwardY].visited){
+        LOG_DEBUG(verbose, "II: ({},{}):visited", x + forwardX, y + forwardY);
+        LOG_DEBUG(verbose, "II: ({},{}).distance={}", x + forwardX, y + forwardY, map[x + forwardX][y + forwardY].distance);
+        // find min distance
+        if(map[x + forwardX][y + forwardY].distance <= minMDistance){
+            minMDistance = map[x + forwardX][y + forwardY].distance;
+            retval = MoveForward;
+        }
+    }
+
+    LOG_DEBUG(verbose, "II: obtained minMDistance{}", minMDistance);
+}
+
+
+// get new values of forwardX and forwardY. 
+// if current cell is at (x.y)
+// Cell at the front     ==> (x+forwardX, y+forwardY)
+// Cell on the right     ==> (x + forwardY, y - forwardX)
+// Cell on the left      ==> (x - forwardY, y + forwardX)
+template <unsigned LEN>
+void BasicFloodFill<LEN>::getForwardXY(unsigned &forwardX, unsigned &forwardY, Dir &heading){
+    forwardX = 0;
+    forwardY = 0;
+    switch(heading){
+        case NORTH:
+            forwardY = 1;
+            break;
+        case SOUTH:
+            forwardY = -1;
+            break;
+        case EAST:
+            forwardX = 1;
+            break;
+        case WEST:
+            forwardX = -1;
+            break;
+    }
+}
+
+
+// use north,south,east,west wall status to find min distance 
+// when isConstructingRoute is set, check only the cells that the mouse has visited.
+template <unsigned LEN>
+typename BasicFloodFill<LEN>::Cell* BasicFloodFill<LEN>::findMinDistance(unsigned cx, unsigned cy, bool isConstructingRoute){
+    stats.findMinDistanceCalls++;
+    minMDistance = INFINITY_DISTANCE;
+    Cell* retCell = NULL;
+
+    if(!map[cx][cy].northWall && (map[cx][cy+1].distance <= minMDistance)){
+        if(isConstructingRoute){
+            if(map[cx][cy+1].visited){
+                LOG_DEBUG(verbose, "findMin: ({},{}):visited", cx, cy+1);
+                LOG_DEBUG(verbose, "findMin: ({},{}).distance={}", cx, cy+1, map[cx][cy+1].distance);
+                minMDistance = map[cx][cy+1].distance;
+                retCell = &map[cx][cy+1];
+            }
+        }else{
+            minMDistance = map[cx][cy+1].distance;
+        }
+    }
+    // check the distance of the grid in the south
+    if(!map[cx][cy].southWall && (map[cx][cy-1].distance <= minMDistance)){
+        if(isConstructingRoute){
+            if(map[cx][cy-1].visited){
+                LOG_DEBUG(verbose, "findMin: ({},{}):visited", cx, cy-1);
+                LOG_DEBUG(verbose, "findMin: ({},{}).distance={}", cx, cy-1, map[cx][cy-1].distance);
+                minMDistance = map[cx][cy-1].distance;
+                retCell = &map[cx][cy-1];
+            }
+        }else{
+            minMDistance = map[cx][cy-1].distance;
+        }
+    }
+    // check the distance of the grid in the east
+    if(!map[cx][cy].eastWall && (map[cx+1][cy].distance <= minMDistance)){
+        if(isConstructingRoute){
+            if (map[cx+1][cy].visited){
+                LOG_DEBUG(verbose, "findMin: ({},{}):visited", cx+1, cy);
+                LOG_DEBUG(verbose, "findMin: ({},{}).distance={}", cx+1, cy, map[cx+1][cy].distance);
+                minMDistance = map[cx+1][cy].distance;
+                retCell = &map[cx+1][cy];
+            }
+        }else{
+            minMDistance = map[cx+1][cy].distance;
+        }
+    }
+    // check the distance of the grid in the west
+    if(!map[cx][cy].westWall && (map[cx-1][cy].distance < minMDistance)){
+        if(isConstructingRoute){
+            if( map[cx-1][cy].visited){
+                LOG_DEBUG(verbose, "findMin: ({},{}):visited", cx-1, cy);
+                LOG_DEBUG(verbose, "findMin: ({},{}).distance={}", cx-1, cy, map[cx-1][cy].distance);
+                minMDistance = map[cx-1][cy].distance;
+                retCell = &map[cx-1][cy];
+            }
+        }else{
+            minMDistance = map[cx-1][cy].distance;
+        }
+    }
+    LOG_DEBUG(verbose, "final minDistance={}", minMDistance);
+    if(retCell != NULL)
+        LOG_DEBUG(verbose, "final retCell= ({},{})", retCell->cx, retCell->cy);
+    return retCell;
+
+}
+
+// After the mouse reached the center for the first time and the distances map has been reassigned,
+// we call this function to construct the 'shortest' route from origin(home) to center.
+// we have two stacks, routeSt1 and routeSt2. routeSt1 stores the instructions needed to traverse from center to home
+// routeSt2 will store the same but in reverse order when we run HomeBoundMode because routeSt2 push whatever routeSt1 pop. 
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::constructRoute(){
+    // error checking
+    if(!routeSt1.empty())
+        return true;
+
+    routeCell = &map[0][0];
+    routeHeading = NORTH;
+    return resumeRoute();
+}
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::resumeRoute(){
+    Trace::Span span("constructRoute", "FloodFill", routeCell->cx, routeCell->cy);
+    ALLOC_GROUP("constructRoute");
+    unsigned forwardX, forwardY;
+    // always make some progress, even if the deadline already passed.
+    for(unsigned done = 0; routeCell->distance != 0; done++){
+        if(done && expired())
+            return false;
+        find_minDistance_and_nextInsn_II(routeCell->cx, routeCell->cy, routeHeading);
+        routeSt1.push(retval);
+        stats.routeLength++;
+
+        // update Cell and funcHeading 
+        if (retval == MoveForward){
+            stats.routeCells++;
+            getForwardXY(forwardX,forwardY,routeHeading);
+            routeCell = &map[routeCell->cx+forwardX][routeCell->cy+forwardY];
+        } else {
+            // take care of Turnaround, TurnCounterClockwise and TurnClockwise.
+            setHead(routeHeading, retval);
+        }
+    }
+    routeCell = NULL;
+    return true;
+}
+
+// continue whichever part of a suspended route construction is left. returns true once the route is complete.
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::finishRoute(){
+    if(!assignQu.empty() && !resumeAssign())
+        return false;
+    if(routeCell == NULL)
+        return constructRoute();
+    return resumeRoute();
+}
+
+// true if there is a deadline and it has passed. Counts the suspension.
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::expired(){
+#ifdef FLOODFILL_FREESTANDING
+    // the firmware has no clock of ours, see setDeadline.
+    return false;
+#else
+    if(!budgeted || std::chrono::steady_clock::now() < deadline)
+        return false;
+    suspensions++;
+    return true;
+#endif
+}
+
+// step 2 of search mode. Apply floodfill algorithm starting from cell (x,y):
+// re-evaluate the distance of every visited, connected cell whose distance is no longer consistent.
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::reflood(unsigned x, unsigned y){
+    stats.refloods++;
+    if(relaxKernel)
+        return relaxReflood(x, y);
+    stats.currentRefloodCells = 0;
+    // push current cell onto stack
+    refloodSt.push(indexOf(map[x][y]));
+    return resumeReflood();
+}
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::resumeReflood(){
+    // Stack of points to be processed (can also use queue)
+    RefloodStack &st = refloodSt;
+    Trace::Span span("reflood", "FloodFill", cellAt(st.top()).cx, cellAt(st.top()).cy);
+    PERF_SCOPE("reflood");
+    ALLOC_GROUP("reflood");
+    const uint64_t begin = cycleCount();
+    Cell* curr; 
+
+
+    // always make some progress, even if the deadline already passed.
+    for(unsigned done = 0; !st.empty(); done++){
+        if(done && expired()){
+            stats.refloodCycles += cycleCount() - begin;
+            return false;
+        }
+        curr = &cellAt(st.top());
+        st.pop();
+        stats.refloodCells++;
+        if(++stats.currentRefloodCells > stats.maxRefloodCells)
+            stats.maxRefloodCells = stats.currentRefloodCells;
+        // set current cell to 'being processed'
+        curr->visited = true;
+        // get current cell coordinates.
+        unsigned cx = curr->cx;
+        unsigned cy = curr->cy;
+
+        // for debugging purpose
+        LOG_DEBUG(verbose, "curr=[{}][{}],old dis={}", cx, cy, curr->distance);
+
+        // don’t want to process the end goal
+        if (curr->distance == 0)
+            continue; 
+
+
+        // for each neighboring cell of curr:
+  
+        // Similar to step one, find the smallest distance arourd the neighborhood.
+        // assign new value to minMDistance.
+        findMinDistance(cx,cy);
+        
+        
+        if(minMDistance == INFINITY_DISTANCE) // shouldn't go in here, if for some reason minMDistance is not changed, then just ignore it.
+            continue;
+
+        if(minMDistance +1 == curr->distance) // nothing was updated, move on
+            continue;
+        
+        curr->setDistance(minMDistance + 1); // set new minimum distance
+         
+        
+        LOG_DEBUG(verbose, "  calcMin={}, new dis= {}", minMDistance, curr->distance);
+
+        // push every visited, connected neighbor onto stack (neighbors the mouse passed by and has no adjacent wall.)
+        if((!map[cx][cy].northWall) && map[cx][cy+1].visited){
+            st.push(indexOf(map[cx][cy+1]));
+            LOG_DEBUG(verbose, "  push [{}][{}]", cx, cy+1);
+        }
+        if((!map[cx][cy].southWall) && map[cx][cy-1].visited){
+            st.push(indexOf(map[cx][cy-1]));
+            LOG_DEBUG(verbose, "  push [{}][{}]", cx, cy-1);
+        }
+        if((!map[cx][cy].eastWall)  && map[cx+1][cy].visited){
+            st.push(indexOf(map[cx+1][cy]));
+            LOG_DEBUG(verbose, "  push [{}][{}]", cx+1, cy);
+        }
+        if((!map[cx][cy].westWall) && map[cx-1][cy].visited){
+            st.push(indexOf(map[cx-1][cy]));
+            LOG_DEBUG(verbose, "  push [{}][{}]", cx-1, cy);
+        }
+        if(st.size() > stats.peakRefloodStack)
+            stats.peakRefloodStack = st.size();
+    }
+    stats.refloodCycles += cycleCount() - begin;
+    return true;
+}
+
+template <unsigned LEN>
+void BasicFloodFill<LEN>::fillField(){
+    typedef typename Relax::Field<LEN>::Column Column;
+    // every cell and mask is overwritten, the borders of the field never change.
+    for (unsigned x = 0; x != LEN; x++){
+        Column north = 0, south = 0, east = 0, west = 0;
+        for (unsigned y = 0; y != LEN; y++){
+            const Cell &c = map[x][y];
+            field.at(x, y) = c.distance;
+            north |= (Column)!c.northWall << y;
+            south |= (Column)!c.southWall << y;
+            east |= (Column)!c.eastWall << y;
+            west |= (Column)!c.westWall << y;
+        }
+        field.north[x] = north;
+        field.south[x] = south;
+        field.east[x] = east;
+        field.west[x] = west;
+        field.active[x] = 0;
+    }
+}
+
+// Same fixed point as the reflood from (x,y): every visited cell one more than its smallest
+// open neighbor. The whole maze is relaxed, not only the cells connected to (x,y).
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::relaxReflood(unsigned x, unsigned y){
+    Trace::Span span("reflood", "FloodFill", x, y);
+    PERF_SCOPE("reflood");
+    ALLOC_GROUP("reflood");
+    const uint64_t begin = cycleCount();
+    fillField();
+    for (unsigned cx = 0; cx != LEN; cx++){
+        for (unsigned cy = 0; cy != LEN; cy++){
+            // the end goal keeps its distance.
+            if(map[cx][cy].visited && map[cx][cy].distance != 0)
+                field.active[cx] |= (typename Relax::Field<LEN>::Column)1 << cy;
+        }
+    }
+    stats.relaxSweeps += Relax::relax(field);
+    for (unsigned cx = 0; cx != LEN; cx++){
+        for (unsigned cy = 0; cy != LEN; cy++){
+            map[cx][cy].distance = field.at(cx, cy);
+        }
+    }
+    LOG_DEBUG(verbose, "relaxed from [{}][{}], new dis={}", x, y, map[x][y].distance);
+    stats.refloodCycles += cycleCount() - begin;
+    return true;
+}
+
+// Same distances as assign_new_dis, for every cell reachable from the center over known passages
+// rather than up to the origin. Marks them visited, like assign_new_dis does.
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::relaxAssign(Cell* centerCell){
+    Trace::Span span("assign_new_dis", "FloodFill", centerCell->cx, centerCell->cy);
+    PERF_SCOPE("assign_new_dis");
+    ALLOC_GROUP("assign_new_dis");
+    const uint64_t begin = cycleCount();
+    fillField();
+    for (unsigned cx = 0; cx != LEN; cx++){
+        field.active[cx] = ~(typename Relax::Field<LEN>::Column)0;
+        for (unsigned cy = 0; cy != LEN; cy++){
+            field.at(cx, cy) = Relax::UNKNOWN;
+        }
+    }
+    field.at(centerCell->cx, centerCell->cy) = 0;
+    field.active[centerCell->cx] &= ~((typename Relax::Field<LEN>::Column)1 << centerCell->cy);
+    stats.relaxSweeps += Relax::relax(field);
+    for (unsigned cx = 0; cx != LEN; cx++){
+        for (unsigned cy = 0; cy != LEN; cy++){
+            // unreachable cells keep their distance.
+            if(field.at(cx, cy) != Relax::UNKNOWN){
+                map[cx][cy].distance = field.at(cx, cy);
+                map[cx][cy].visited = true;
+            }
+        }
+    }
+    LOG_DEBUG(verbose, "Done assigning new distances.");
+    stats.assignCycles += cycleCount() - begin;
+    return true;
+}
+
+#ifndef FLOODFILL_FREESTANDING
+template <unsigned LEN>
+void BasicFloodFill<LEN>::ingest(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze){
+    // the mouse's own cell is the search's to take in.
+    map[x][y].visited = true;
+    const unsigned n = maze.sense(observations);
+    for (unsigned i = 0; i != n; i++){
+        const WallObservation &o = observations[i];
+        sawWall(o.x, o.y, o.side, o.closed);
+        // the same wall seen from the cell on the other side, unless it is the outer wall.
+        const unsigned nx = o.x + (o.side == EAST ? 1 : o.side == WEST ? -1 : 0);
+        const unsigned ny = o.y + (o.side == NORTH ? 1 : o.side == SOUTH ? -1 : 0);
+        if (nx < LEN && ny < LEN)
+            sawWall(nx, ny, opposite(o.side), o.closed);
+    }
+}
+#endif
+
+template <unsigned LEN>
+void BasicFloodFill<LEN>::sawWall(unsigned x, unsigned y, Dir side, bool closed){
+    Cell &c = map[x][y];
+    c.setWall(side, closed);
+    c.seen |= 1 << side;
+    if (c.seen == 15 && !c.visited){
+        c.visited = true;
+        stats.sensedCells++;
+        // its distance has not been checked against its walls yet.
+        refloodSt.push(indexOf(c));
+        LOG_DEBUG(verbose, "sensed [{}][{}]", x, y);
+    }
+}
+
+// First run searching center
+template <unsigned LEN>
+void BasicFloodFill<LEN>::SearchMode(unsigned x, unsigned y){
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // step 1: Follow Manhattan Distances downwards towards center, noting down any walls as they pass
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    map[x][y].visited = true;
+    // finish a reflood suspended by an earlier deadline, or started by ingest, first: it may change the distances around us.
+    if(!refloodSt.empty() && resumeReflood())
+        currMDistance = map[x][y].distance;
+    find_minDistance_and_nextInsn(x,y);
+    // if mimMDistance is not changed, then currMDistance is the smallest Mdistance in its neighborhood.
+    if(minMDistance != currMDistance)
+        return;
+
+    LOG_DEBUG(verbose, "Step 1 done...");
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // step 2: Apply floodfill algorithm
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    if(!reflood(x, y)){
+        // Out of time. The best we can do without the new distances is to leave a dead end,
+        // otherwise wait and resume the reflood on the next call.
+        LOG_DEBUG(verbose, "Reflood suspended, {} cells left", refloodSt.size());
+        retval = (rightWall && leftWall && frontWall) ? TurnAround : Wait;
+        return;
+    }
+
+    // IR sensors can't sense the back wall, so let's turn around.
+    // Add additional checks to avoid unnecessary turnarounds.
+    // If the reflood left our distance unchanged, the only downhill neighbor is behind us:
+    // waiting would just bring us back here with the same distances.
+    unsigned forwardX, forwardY;
+    getForwardXY(forwardX, forwardY, currHeading);
+    if ( rightWall && leftWall && (frontWall || map[x+forwardX][y+forwardY].distance > map[x][y].distance)){
+        retval = TurnAround;
+    } else if (map[x][y].distance == currMDistance){
+        retval = TurnAround;
+    } else {
+        retval = Wait;
+    }
+    
+    return;
+}
+
+#ifndef FLOODFILL_FREESTANDING
+// Search mode used with the background planner. Same as SearchMode, except that
+// the reflood is posted to the planner and this only waits when the last published
+// distance field leaves the mouse without a downhill neighbor.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::AsyncSearchMode(unsigned x, unsigned y){
+    // pick up whatever the planner has published so far.
+    unsigned version = planner->read(map);
+    currMDistance = map[x][y].distance;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // step 1: same as SearchMode, but against the published distances.
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool firstVisit = !map[x][y].visited;
+    map[x][y].visited = true;
+    find_minDistance_and_nextInsn(x,y);
+    if(firstVisit)
+        postWalls(x, y);
+
+    // a neighbor is downhill, even if the field is stale it is a valid move.
+    if(minMDistance != currMDistance)
+        return;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // step 2: the planner refloods for us.
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // The field does not include our walls yet: unless this is a dead end, try again later.
+    // Once it does, the planner has reflooded from this cell, so if nothing at the front, left or right
+    // is downhill, the cell behind us is.
+    if(rightWall && leftWall && frontWall){
+        // dead end, no need to wait for the field.
+        retval = TurnAround;
+    } else if(version != postedUpdates){
+        LOG_DEBUG(verbose, "Waiting for planner ({}/{})", version, postedUpdates);
+        // give the planner thread a chance to run before we are asked again.
+        std::this_thread::yield();
+        retval = Wait;
+    } else {
+        retval = TurnAround;
+    }
+}
+#endif
+
+// First run going back home and speed run running back home
+template <unsigned LEN>
+void BasicFloodFill<LEN>::HomeBoundMode(unsigned x, unsigned y){
+#ifndef FLOODFILL_FREESTANDING
+    // pick up the route from the planner the first time around.
+    if(routeRequested){
+        if(!planner->routeReady()){
+            // as in AsyncSearchMode, let the planner run before we are asked again.
+            std::this_thread::yield();
+            retval = Wait;
+            return;
+        }
+        const BasicFloodFill &result = planner->result();
+        routeSt1 = result.routeSt1;
+        for (int r = 0; r != LEN; r++){
+            for (int c = 0; c != LEN; c++){
+                map[r][c] = result.map[r][c];
+            }
+        }
+        routeRequested = false;
+    }
+#endif
+    // continue a route construction suspended by the deadline.
+    if(routePending){
+        routePending = !finishRoute();
+        if(routePending){
+            retval = Wait;
+            return;
+        }
+    }
+    if(routeSt1.empty()){
+        retval = Wait;
+        return;
+    }
+    retval = (MouseMovement)routeSt1.top();
+    routeSt2.push(retval);
+    routeSt1.pop();
+    if(retval == TurnClockwise)
+        retval = TurnCounterClockwise;
+    else if(retval == TurnCounterClockwise)
+        retval = TurnClockwise;
+
+}
+// Speed run running to center
+template <unsigned LEN>
+void BasicFloodFill<LEN>::FastMode(){
+    if(routeSt2.empty()){
+        retval = Wait;
+        return;
+    }
+    retval = (MouseMovement)routeSt2.top();
+    routeSt1.push(retval);
+    routeSt2.pop();
+}
+
+
+#ifndef FLOODFILL_FREESTANDING
+/**
+ *
+ * Background planner member functions implementation
+ *
+ */
+
+template <unsigned LEN>
+BasicFloodFill<LEN>::Planner::Planner(bool relax) : shadow(false, false, false, false, false, relax), applied(0), head(0), tail(0), front(0), routeDone(false), stop(false) {
+    for (int b = 0; b != 2; b++){
+        seq[b].store(0);
+        version[b].store(0);
+        for (int r = 0; r != LEN; r++){
+            for (int c = 0; c != LEN; c++){
+                distance[b][r][c].store(shadow.map[r][c].distance);
+            }
+        }
+    }
+    worker = std::thread(&BasicFloodFill<LEN>::Planner::run, this);
+}
+
+template <unsigned LEN>
+BasicFloodFill<LEN>::Planner::~Planner(){
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+template <unsigned LEN>
+bool BasicFloodFill<LEN>::Planner::post(const Update &u){
+    unsigned t = tail.load(std::memory_order_relaxed);
+    if(t - head.load(std::memory_order_acquire) == RING_SIZE)
+        return false;
+    ring[t % RING_SIZE] = u;
+    tail.store(t + 1, std::memory_order_release);
+    // taking the mutex makes sure the planner is either waiting or will see the new tail.
+    { std::lock_guard<std::mutex> lock(mtx); }
+    cv.notify_one();
+    return true;
+}
+template <unsigned LEN>
+unsigned BasicFloodFill<LEN>::Planner::read(Cell map[][LEN]) const {
+    for(;;){
+        unsigned b = front.load(std::memory_order_acquire);
+        unsigned s = seq[b].load(std::memory_order_acquire);
+        if(s & 1)
+            continue;
+        for (int r = 0; r != LEN; r++){
+            for (int c = 0; c != LEN; c++){
+                map[r][c].distance = distance[b][r][c].load(std::memory_order_relaxed);
+            }
+        }
+        unsigned v = version[b].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(seq[b].load(std::memory_order_relaxed) == s)
+            return v;
+    }
+}
+template <unsigned LEN>
+void BasicFloodFill<LEN>::Planner::run(){
+    for(;;){
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]{ return stop || head.load() != tail.load(); });
+            if(stop)
+                return;
+        }
+        // drain everything posted so far, then publish once.
+        unsigned h = head.load(std::memory_order_relaxed);
+        while(h != tail.load(std::memory_order_acquire)){
+            Update u = ring[h % RING_SIZE];
+            head.store(++h, std::memory_order_release);
+            if(u.route){
+                shadow.clearVisits();
+                shadow.assign_new_dis(&shadow.map[u.x][u.y]);
+                shadow.constructRoute();
+                routeDone.store(true, std::memory_order_release);
+            } else {
+                apply(u);
+            }
+        }
+        publish();
+    }
+}
+template <unsigned LEN>
+void BasicFloodFill<LEN>::Planner::apply(const Update &u){
+    Cell &cell = shadow.map[u.x][u.y];
+    cell.visited = true;
+    cell.northWall = (u.walls & NORTH_BIT) != 0;
+    cell.southWall = (u.walls & SOUTH_BIT) != 0;
+    cell.eastWall  = (u.walls & EAST_BIT)  != 0;
+    cell.westWall  = (u.walls & WEST_BIT)  != 0;
+
+    // same as find_minDistance_and_nextInsn, the neighbor shares the open wall.
+    if(!cell.northWall)
+        shadow.map[u.x][u.y+1].setWall(SOUTH);
+    if(!cell.southWall)
+        shadow.map[u.x][u.y-1].setWall(NORTH);
+    if(!cell.eastWall)
+        shadow.map[u.x+1][u.y].setWall(WEST);
+    if(!cell.westWall)
+        shadow.map[u.x-1][u.y].setWall(EAST);
+    applied++;
+
+    // Unlike SearchMode, reflood every time we learn new walls instead of only at a local minimum,
+    // so the field is usually already consistent by the time the mouse needs it.
+    shadow.reflood(u.x, u.y);
+}
+template <unsigned LEN>
+void BasicFloodFill<LEN>::Planner::publish(){
+    unsigned b = front.load(std::memory_order_relaxed) ^ 1;
+    seq[b].fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int r = 0; r != LEN; r++){
+        for (int c = 0; c != LEN; c++){
+            distance[b][r][c].store(shadow.map[r][c].distance, std::memory_order_relaxed);
+        }
+    }
+    version[b].store(applied, std::memory_order_relaxed);
+    seq[b].fetch_add(1, std::memory_order_release);
+    front.store(b, std::memory_order_release);
+}
+
+template <unsigned LEN>
+BasicFloodFill<LEN>::~BasicFloodFill(){
+    delete planner;
+}
+
+// start the planner thread. Used by the constructor when shouldPlanAsync is set.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::startPlanner(){
+    planner = new Planner(relaxKernel);
+}
+
+// post the wall status of cell (x,y) to the planner.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::postWalls(unsigned x, unsigned y){
+    typename Planner::Update u;
+    u.x = x;
+    u.y = y;
+    u.walls = (map[x][y].northWall ? Planner::NORTH_BIT : 0) |
+              (map[x][y].southWall ? Planner::SOUTH_BIT : 0) |
+              (map[x][y].eastWall  ? Planner::EAST_BIT  : 0) |
+              (map[x][y].westWall  ? Planner::WEST_BIT  : 0);
+    u.route = false;
+    if(planner->post(u))
+        postedUpdates++;
+}
+
+// ask the planner to reassign distances from center cell (x,y) and construct the route.
+template <unsigned LEN>
+void BasicFloodFill<LEN>::requestRoute(unsigned x, unsigned y){
+    typename Planner::Update u;
+    u.x = x;
+    u.y = y;
+    u.walls = 0;
+    u.route = true;
+    routeRequested = planner->post(u);
+    if(!routeRequested){
+        // fall back to doing it ourselves.
+        clearVisits();
+        assign_new_dis(&map[x][y]);
+        constructRoute();
+    }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#define FLOODFILL_FREESTANDING
+#include <new> // placement new
+#include "FloodFill.h"
+#include "FloodFillEmbedded.h"
+
+/**
+ * The firmware build of FloodFill, see FloodFillEmbedded.h.
+ * The maze is the classic 16x16 one unless built with e.g. -DFLOODFILL_LEN=32.
+ */
+
+#ifndef FLOODFILL_LEN
+#define FLOODFILL_LEN MazeDefinitions::MAZE_LEN
+#endif
+
+typedef BasicFloodFill<FLOODFILL_LEN> EmbeddedFloodFill;
+
+namespace {
+    // the walls of the current cell, as the firmware's sensors see them.
+    struct Sensors {
+        bool front;
+        bool left;
+        bool right;
+
+        bool wallInFront() const {
+            return front;
+        }
+        bool wallOnLeft() const {
+            return left;
+        }
+        bool wallOnRight() const {
+            return right;
+        }
+    };
+
+    // the FloodFill lives in .bss and is constructed in place, so nothing runs before main
+    // and nothing is left for a static destructor to do.
+    alignas(EmbeddedFloodFill) unsigned char storage[sizeof(EmbeddedFloodFill)];
+    EmbeddedFloodFill *floodFill;
+}
+
+void floodFillReset(void) {
+    // nothing to destroy: the FloodFill has no resources of its own when freestanding.
+    floodFill = new (storage) EmbeddedFloodFill(false, false, false, true);
+}
+
+int floodFillNextMovement(unsigned x, unsigned y, int wallInFront, int wallOnLeft, int wallOnRight) {
+    const Sensors sensors = { wallInFront != 0, wallOnLeft != 0, wallOnRight != 0 };
+    return floodFill->nextMovement(x, y, sensors);
+}
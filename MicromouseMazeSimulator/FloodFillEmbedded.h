@@ -0,0 +1,38 @@
+#ifndef FloodFillEmbedded_h
+#define FloodFillEmbedded_h
+
+/**
+ * FloodFill for the mouse itself (make embedded): FloodFill.h built freestanding, without
+ * iostream, threads, clocks, heap, exceptions or RTTI, behind a C interface the firmware's
+ * control loop can call.
+ *
+ * There is a single FloodFill, in static storage. The firmware keeps track of the pose:
+ * the mouse starts in (0,0) facing north and carries out every movement before the next call.
+ * The background planner (-a), the time budget (-b) and the long-range sensors (-l) of the
+ * simulator are not part of it.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start a new search: forget the walls and the route, back to the Manhattan distances.
+ * Has to be called once before the first floodFillNextMovement.
+ */
+void floodFillReset(void);
+
+/**
+ * The next movement, once the mouse stands in a cell.
+ * @param x: current column of the mouse (0 is the left-most side of the maze)
+ * @param y: current row of the mouse (0 is bottom of the maze)
+ * @param wallInFront, wallOnLeft, wallOnRight: non-zero if the sensors see a wall there
+ * @return a MouseMovement (MouseMovement.h)
+ */
+int floodFillNextMovement(unsigned x, unsigned y, int wallInFront, int wallOnLeft, int wallOnRight);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
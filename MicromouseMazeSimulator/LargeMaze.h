@@ -0,0 +1,335 @@
+#ifndef LargeMaze_h
+#define LargeMaze_h
+
+#include <stdint.h> // uint32_t, uint64_t
+#include <cstddef>  // size_t
+#include <vector>
+#include <algorithm> // std::fill
+
+#include "Dir.h"
+
+/**
+ * Runtime-sized mazes, up to 4096x4096 cells, for stress testing the planning algorithms.
+ *
+ * Unlike BasicMazeWorld, the side is only known at run time and the mouse is not simulated:
+ * a LargeMaze holds the walls and a distance field, and flood() computes the distances
+ * from the center breadth first, like FloodFill::assign_new_dis with every wall known.
+ *
+ * Where a cell lives in memory is decided by the Layout:
+ *     RowMajor    y * side + x, the plain two dimensional array of FloodFill::map and BitVector256
+ *     Tiled       8x8 blocks of cells, blocks in row major order
+ *     Morton      Z-order: the bits of x and y interleaved, so cells close in the maze are close in memory at every scale
+ * Walls (two bits per cell, north and east; south and west are the neighbors') and distances use the same layout.
+ */
+namespace LargeMazeLayout {
+    // largest supported side.
+    const unsigned MAX_SIDE = 4096;
+
+    // smallest power of two >= n.
+    inline unsigned roundUp(unsigned n) {
+        unsigned p = 1;
+        while(p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    struct RowMajor {
+        explicit RowMajor(unsigned side) : side(side) {}
+
+        static const char *name() {
+            return "row-major";
+        }
+
+        // number of slots needed for a side x side maze.
+        size_t slots() const {
+            return (size_t)side * side;
+        }
+
+        inline size_t index(unsigned x, unsigned y) const {
+            return (size_t)y * side + x;
+        }
+
+        // indices of the four neighbors of cell i = index(x, y). Off the maze it is i itself.
+        inline void neighbors(unsigned x, unsigned y, size_t i, size_t &north, size_t &south, size_t &east, size_t &west) const {
+            north = y + 1 < side ? i + side : i;
+            south = y > 0 ? i - side : i;
+            east = x + 1 < side ? i + 1 : i;
+            west = x > 0 ? i - 1 : i;
+        }
+
+        unsigned side;
+    };
+
+    struct Tiled {
+        static const unsigned TILE_BITS = 3;
+        static const unsigned TILE = 1 << TILE_BITS;
+
+        explicit Tiled(unsigned side) : side(side), tilesPerRow((side + TILE - 1) / TILE) {}
+
+        static const char *name() {
+            return "tiled 8x8";
+        }
+
+        size_t slots() const {
+            return (size_t)tilesPerRow * tilesPerRow * TILE * TILE;
+        }
+
+        inline size_t index(unsigned x, unsigned y) const {
+            const size_t tile = (size_t)(y >> TILE_BITS) * tilesPerRow + (x >> TILE_BITS);
+            return (tile << (2 * TILE_BITS)) | ((y & (TILE - 1)) << TILE_BITS) | (x & (TILE - 1));
+        }
+
+        // inside a tile the neighbors are i +- 1 and i +- TILE, across tiles they are worked out again.
+        inline void neighbors(unsigned x, unsigned y, size_t i, size_t &north, size_t &south, size_t &east, size_t &west) const {
+            const unsigned tx = x & (TILE - 1);
+            const unsigned ty = y & (TILE - 1);
+            north = ty != TILE - 1 ? i + TILE : (y + 1 < side ? index(x, y + 1) : i);
+            south = ty != 0 ? i - TILE : (y > 0 ? index(x, y - 1) : i);
+            east = tx != TILE - 1 ? i + 1 : (x + 1 < side ? index(x + 1, y) : i);
+            west = tx != 0 ? i - 1 : (x > 0 ? index(x - 1, y) : i);
+        }
+
+        unsigned side;
+        unsigned tilesPerRow;
+    };
+
+    struct Morton {
+        // the side is rounded up to a power of two, the slots outside the maze are never used.
+        explicit Morton(unsigned side) : side(side), paddedSide(roundUp(side)) {}
+
+        static const char *name() {
+            return "Morton";
+        }
+
+        size_t slots() const {
+            return (size_t)paddedSide * paddedSide;
+        }
+
+        // spread the low 16 bits of v over the even bits.
+        static inline uint32_t spread(uint32_t v) {
+            v &= 0xffff;
+            v = (v | (v << 8)) & 0x00ff00ff;
+            v = (v | (v << 4)) & 0x0f0f0f0f;
+            v = (v | (v << 2)) & 0x33333333;
+            v = (v | (v << 1)) & 0x55555555;
+            return v;
+        }
+
+        inline size_t index(unsigned x, unsigned y) const {
+            return spread(x) | (spread(y) << 1);
+        }
+
+        // Stepping in Z-order without going back to x and y: add or subtract 1 on the bits of one
+        // coordinate only, carrying across the bits of the other one by filling them with ones.
+        inline void neighbors(unsigned x, unsigned y, size_t i, size_t &north, size_t &south, size_t &east, size_t &west) const {
+            const size_t X = 0x55555555;
+            const size_t Y = 0xaaaaaaaa;
+            north = y + 1 < side ? (((i | X) + 2) & Y) | (i & X) : i;
+            south = y > 0 ? (((i & Y) - 2) & Y) | (i & X) : i;
+            east = x + 1 < side ? (((i | Y) + 1) & X) | (i & Y) : i;
+            west = x > 0 ? (((i & X) - 1) & X) | (i & Y) : i;
+        }
+
+        unsigned side;
+        unsigned paddedSide;
+    };
+}
+
+template <typename Layout>
+class LargeMaze {
+public:
+    // distance of a cell the flood did not reach.
+    static const uint32_t UNREACHED = 0xffffffff;
+
+    /**
+     * An empty maze: every wall present.
+     * @param side: cells per row and column, from 2 to LargeMazeLayout::MAX_SIDE
+     */
+    explicit LargeMaze(unsigned side)
+    : side(side), layout(side),
+      northOpen((layout.slots() + 63) / 64, 0), eastOpen((layout.slots() + 63) / 64, 0),
+      distances(layout.slots(), UNREACHED) {
+        // every cell once, plus a slot for the neighbor written past the end (see flood).
+        queue.reserve((size_t)side * side + 1);
+    }
+
+    inline unsigned getSide() const {
+        return side;
+    }
+
+    inline bool isOpen(unsigned x, unsigned y, Dir d) const {
+        switch(d) {
+            case NORTH:
+                return y + 1 < side && get(northOpen, layout.index(x, y));
+            case SOUTH:
+                return y > 0 && get(northOpen, layout.index(x, y - 1));
+            case EAST:
+                return x + 1 < side && get(eastOpen, layout.index(x, y));
+            case WEST:
+                return x > 0 && get(eastOpen, layout.index(x - 1, y));
+            case INVALID:
+            default:
+                return false;
+        }
+    }
+
+    // remove the wall on side d of (x,y). The outer walls stay.
+    void setOpen(unsigned x, unsigned y, Dir d) {
+        switch(d) {
+            case NORTH:
+                if(y + 1 < side)
+                    set(northOpen, layout.index(x, y));
+                break;
+            case SOUTH:
+                if(y > 0)
+                    set(northOpen, layout.index(x, y - 1));
+                break;
+            case EAST:
+                if(x + 1 < side)
+                    set(eastOpen, layout.index(x, y));
+                break;
+            case WEST:
+                if(x > 0)
+                    set(eastOpen, layout.index(x - 1, y));
+                break;
+            case INVALID:
+            default:
+                break;
+        }
+    }
+
+    /**
+     * Carve a maze: a sidewinder maze (every cell reachable, a corridor along the top row),
+     * then roughly loopsPerThousand of every thousand remaining walls removed to make loops,
+     * and the center opened up. The same seed gives the same maze in every layout.
+     */
+    void generate(uint32_t seed, unsigned loopsPerThousand) {
+        uint32_t state = seed ? seed : 1;
+        for(unsigned y = 0; y < side; y++) {
+            unsigned runStart = 0;
+            for(unsigned x = 0; x < side; x++) {
+                const bool lastRow = y + 1 == side;
+                if(lastRow || (x + 1 < side && next(state) % 2)) {
+                    setOpen(x, y, EAST);
+                } else {
+                    // close the run with a passage north from one of its cells.
+                    setOpen(runStart + next(state) % (x - runStart + 1), y, NORTH);
+                    runStart = x + 1;
+                }
+            }
+        }
+        for(unsigned y = 0; y < side; y++) {
+            for(unsigned x = 0; x < side; x++) {
+                if(next(state) % 1000 < loopsPerThousand)
+                    setOpen(x, y, next(state) % 2 ? NORTH : EAST);
+            }
+        }
+        const unsigned mid = side / 2;
+        setOpen(mid - 1, mid - 1, NORTH);
+        setOpen(mid - 1, mid - 1, EAST);
+        setOpen(mid, mid, SOUTH);
+        setOpen(mid, mid, WEST);
+    }
+
+    /**
+     * Breadth first distances from the center cells to every cell.
+     * @return number of cells reached
+     */
+    size_t flood() {
+        std::fill(distances.begin(), distances.end(), UNREACHED);
+        queue.clear();
+
+        const unsigned mid = side / 2;
+        seed(mid - 1, mid - 1);
+        seed(mid - 1, mid);
+        seed(mid, mid - 1);
+        seed(mid, mid);
+
+        // the walls of a maze are as good as random to the branch predictor, so the neighbors are
+        // pushed without branches: always write the queue slot, only advance the tail if it counts.
+        queue.resize(queue.capacity());
+        size_t tail = 4;
+        for(size_t head = 0; head < tail; head++) {
+            const unsigned x = queue[head] & 0xffff;
+            const unsigned y = queue[head] >> 16;
+            const size_t i = layout.index(x, y);
+            const uint32_t d = distances[i] + 1;
+
+            // work out every index once, it is shared by the wall and the distance of the neighbor.
+            // Off the maze the index is the cell itself, which has been reached already.
+            size_t north, south, east, west;
+            layout.neighbors(x, y, i, north, south, east, west);
+
+            tail = visit(tail, get(northOpen, i), north, queue[head] + (1 << 16), d);
+            tail = visit(tail, get(northOpen, south), south, queue[head] - (1 << 16), d);
+            tail = visit(tail, get(eastOpen, i), east, queue[head] + 1, d);
+            tail = visit(tail, get(eastOpen, west), west, queue[head] - 1, d);
+        }
+        queue.resize(tail);
+        return queue.size();
+    }
+
+    inline uint32_t distance(unsigned x, unsigned y) const {
+        return distances[layout.index(x, y)];
+    }
+
+    inline const Layout &getLayout() const {
+        return layout;
+    }
+
+    // walls by slot index, for floods that keep their own distances (see ParallelFlood).
+    inline bool isNorthOpenAt(size_t i) const {
+        return get(northOpen, i);
+    }
+
+    inline bool isEastOpenAt(size_t i) const {
+        return get(eastOpen, i);
+    }
+
+    // bytes used by the walls, the distances and the flood queue.
+    size_t bytes() const {
+        return (northOpen.capacity() + eastOpen.capacity()) * sizeof(uint64_t) +
+               distances.capacity() * sizeof(uint32_t) + queue.capacity() * sizeof(uint32_t);
+    }
+
+protected:
+    static inline bool get(const std::vector<uint64_t> &bits, size_t i) {
+        return (bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    static inline void set(std::vector<uint64_t> &bits, size_t i) {
+        bits[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+
+    // xorshift32, the generator only needs to be fast and repeatable.
+    static inline uint32_t next(uint32_t &state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    inline void seed(unsigned x, unsigned y) {
+        distances[layout.index(x, y)] = 0;
+        queue.push_back(x | (y << 16));
+    }
+
+    // reach cell i (packed as x | y << 16) at distance d if there is no wall on the way and it was not reached yet.
+    inline size_t visit(size_t tail, bool open, size_t i, uint32_t packed, uint32_t d) {
+        const bool first = open & (distances[i] == UNREACHED);
+        distances[i] = first ? d : distances[i];
+        queue[tail] = packed;
+        return tail + first;
+    }
+
+    unsigned side;
+    Layout layout;
+    std::vector<uint64_t> northOpen;
+    std::vector<uint64_t> eastOpen;
+    std::vector<uint32_t> distances;
+    // cells in the order the flood reached them, packed as x | y << 16.
+    std::vector<uint32_t> queue;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <chrono>
+#include <thread>
+#include "LargeMaze.h"
+#include "ParallelFlood.h"
+
+/**
+ * Flood time and memory of LargeMaze by size and storage layout.
+ *
+ * For every side from 64 up to the largest requested, the same generated maze is stored
+ * row-major, in 8x8 tiles and in Morton order, flooded from the center, and timed.
+ * All layouts have to produce the same distance field.
+ *
+ * Then, on the largest maze, ParallelFlood is timed with 1 to N threads (strong scaling)
+ * and has to give every cell the distance of the serial flood.
+ */
+
+// sum and maximum of the distances, to check that all layouts agree.
+struct Checksum {
+    uint64_t sum;
+    uint32_t max;
+    size_t reached;
+
+    bool operator==(const Checksum &other) const {
+        return sum == other.sum && max == other.max && reached == other.reached;
+    }
+};
+
+// best time in nanoseconds of as many calls to flood as fit in minSeconds, at least two.
+template <typename Flood>
+double bestOf(double minSeconds, Flood flood) {
+    double best = 0;
+    double spent = 0;
+    for(unsigned run = 0; run < 2 || spent < minSeconds * 1e9; run++) {
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        flood();
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        spent += nanos;
+        if(run == 0 || nanos < best) {
+            best = nanos;
+        }
+    }
+    return best;
+}
+
+template <typename Layout>
+Checksum measure(unsigned side, unsigned loopsPerThousand, double minSeconds, double &floodNanos, size_t &bytes) {
+    LargeMaze<Layout> maze(side);
+    maze.generate(side, loopsPerThousand);
+
+    Checksum checksum;
+    floodNanos = bestOf(minSeconds, [&]() { checksum.reached = maze.flood(); });
+    bytes = maze.bytes();
+
+    checksum.sum = 0;
+    checksum.max = 0;
+    for(unsigned y = 0; y < side; y++) {
+        for(unsigned x = 0; x < side; x++) {
+            const uint32_t d = maze.distance(x, y);
+            checksum.sum += d;
+            if(d > checksum.max) {
+                checksum.max = d;
+            }
+        }
+    }
+    return checksum;
+}
+
+// print one row of the table. Returns false if the layout disagrees with the reference.
+bool report(const char *layout, unsigned side, double nanos, size_t bytes, double referenceNanos,
+            const Checksum &checksum, const Checksum &reference) {
+    const double cells = (double)side * side;
+    std::cout << std::setw(6) << side << std::setw(11) << (size_t)cells << "  " << std::left << std::setw(10) << layout << std::right
+              << std::fixed << std::setprecision(3) << std::setw(11) << nanos / 1e6
+              << std::setprecision(2) << std::setw(9) << nanos / cells
+              << std::setprecision(1) << std::setw(9) << bytes / (1024.0 * 1024.0)
+              << std::setprecision(2) << std::setw(10) << referenceNanos / nanos << "x"
+              << std::setw(11) << checksum.max;
+    if(!(checksum == reference)) {
+        std::cout << "  MISMATCH";
+    }
+    std::cout << std::endl;
+    return checksum == reference;
+}
+
+// time ParallelFlood on one maze with 1 to maxThreads threads. Returns false if it disagrees with the serial flood.
+template <typename Layout>
+bool scaling(unsigned side, unsigned loopsPerThousand, double minSeconds, unsigned maxThreads) {
+    LargeMaze<Layout> maze(side);
+    maze.generate(side, loopsPerThousand);
+    size_t serialReached = 0;
+    const double serial = bestOf(minSeconds, [&]() { serialReached = maze.flood(); });
+    ParallelFlood<Layout> parallel(maze);
+
+    std::cout << std::endl << "ParallelFlood, " << side << " x " << side << ", " << Layout::name() << " storage, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << "threads  flood (ms)  speedup  efficiency  same as serial" << std::endl;
+    std::cout << " serial" << std::fixed << std::setprecision(3) << std::setw(12) << serial / 1e6 << std::endl;
+    bool same = true;
+    double oneThread = 0;
+    for(unsigned threads = 1; threads <= maxThreads; threads++) {
+        size_t reached = 0;
+        const double best = bestOf(minSeconds, [&]() { reached = parallel.flood(threads); });
+        if(threads == 1) {
+            oneThread = best;
+        }
+
+        // compare every cell, not a checksum: the split of the work changes from run to run.
+        bool match = reached == serialReached;
+        for(unsigned y = 0; y < side && match; y++) {
+            for(unsigned x = 0; x < side && match; x++) {
+                match = parallel.distance(x, y) == maze.distance(x, y);
+            }
+        }
+        same &= match;
+
+        std::cout << std::setw(7) << threads
+                  << std::fixed << std::setprecision(3) << std::setw(12) << best / 1e6
+                  << std::setprecision(2) << std::setw(8) << oneThread / best << "x"
+                  << std::setprecision(0) << std::setw(11) << 100 * oneThread / best / threads << "%"
+                  << std::setw(16) << (match ? "yes" : "MISMATCH") << std::endl;
+    }
+    return same;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned maxSide = LargeMazeLayout::MAX_SIDE;
+    unsigned loopsPerThousand = 50;
+    double minSeconds = 0.2;
+    unsigned maxThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            maxSide = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            loopsPerThousand = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            minSeconds = atof(argv[++i]);
+        } else if(strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            maxThreads = atoi(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-s N] [-l N] [-t SECONDS] [-p N]" << std::endl;
+            std::cout << "\t-s N will stop at N x N cells (64 to 4096, default 4096)" << std::endl;
+            std::cout << "\t-l N will remove about N of every 1000 walls to make loops (default 50)" << std::endl;
+            std::cout << "\t-t SECONDS will repeat each flood for at least this long and keep the best time (default 0.2)" << std::endl;
+            std::cout << "\t-p N will time the parallel flood with 1 to N threads (default: one per hardware thread)" << std::endl;
+            return -1;
+        }
+    }
+    if(maxSide < 64 || maxSide > LargeMazeLayout::MAX_SIDE) {
+        std::cout << "Side must be between 64 and " << LargeMazeLayout::MAX_SIDE << std::endl;
+        return -1;
+    }
+    if(maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::cout << "  side      cells  layout     flood (ms)  ns/cell       MB  vs row-major  max dist" << std::endl;
+    bool same = true;
+    for(unsigned side = 64; side <= maxSide; side *= 2) {
+        double rowNanos, tiledNanos, mortonNanos;
+        size_t rowBytes, tiledBytes, mortonBytes;
+        const Checksum row = measure<LargeMazeLayout::RowMajor>(side, loopsPerThousand, minSeconds, rowNanos, rowBytes);
+        const Checksum tiled = measure<LargeMazeLayout::Tiled>(side, loopsPerThousand, minSeconds, tiledNanos, tiledBytes);
+        const Checksum morton = measure<LargeMazeLayout::Morton>(side, loopsPerThousand, minSeconds, mortonNanos, mortonBytes);
+
+        same &= report(LargeMazeLayout::RowMajor::name(), side, rowNanos, rowBytes, rowNanos, row, row);
+        same &= report(LargeMazeLayout::Tiled::name(), side, tiledNanos, tiledBytes, rowNanos, tiled, row);
+        same &= report(LargeMazeLayout::Morton::name(), side, mortonNanos, mortonBytes, rowNanos, morton, row);
+    }
+
+    if(!same) {
+        std::cout << "FAIL: the layouts disagree on the distances" << std::endl;
+        return 1;
+    }
+
+    unsigned largest = 64;
+    while(largest * 2 <= maxSide) {
+        largest *= 2;
+    }
+    if(!scaling<LargeMazeLayout::Morton>(largest, loopsPerThousand, minSeconds, maxThreads)) {
+        std::cout << "FAIL: the parallel flood disagrees with the serial one" << std::endl;
+        return 1;
+    }
+    return 0;
+}
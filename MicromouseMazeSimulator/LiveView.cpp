@@ -0,0 +1,193 @@
+#include <cstring>  // memset, strerror
+#include <cerrno>
+#include <fcntl.h>    // O_CREAT
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // ftruncate, close
+#include "LiveView.h"
+
+namespace LiveView {
+    namespace {
+        const uint32_t MAGIC = 0x564c4d4d; // "MMLV"
+        const uint32_t VERSION = 1;
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "frames are shared between processes");
+
+        // shared memory names start with a slash.
+        std::string path(const char *name) {
+            return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+        }
+    }
+
+    Publisher::Publisher(const char *name, unsigned len, unsigned maze, bool distances)
+    : name(path(name)), segment(NULL), len(len), withDistances(distances), published(0), distances(MAX_CELLS, Replay::NO_DISTANCE) {
+        memset(boards, 0, sizeof(boards));
+        if(len > MAX_LEN) {
+            error = "Mazes larger than 32x32 cannot be viewed";
+            return;
+        }
+        // a segment left over by a run that did not finish, or that a viewer still holds, is not reused.
+        shm_unlink(this->name.c_str());
+        const int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if(fd < 0) {
+            error = "Cannot create shared memory " + this->name + ": " + strerror(errno);
+            return;
+        }
+        void *memory = MAP_FAILED;
+        if(ftruncate(fd, sizeof(Segment)) == 0)
+            memory = mmap(NULL, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(memory == MAP_FAILED) {
+            error = "Cannot map shared memory " + this->name + ": " + strerror(errno);
+            shm_unlink(this->name.c_str());
+            return;
+        }
+        // the memory is zeroed: no frame is published and every slot is complete.
+        segment = static_cast<Segment *>(memory);
+        segment->version = VERSION;
+        segment->len = len;
+        segment->maze = maze;
+        segment->withDistances = distances;
+        segment->magic.store(MAGIC, std::memory_order_release);
+    }
+
+    Publisher::~Publisher() {
+        if(!segment)
+            return;
+        segment->finished.store(1, std::memory_order_release);
+        munmap(segment, sizeof(Segment));
+        shm_unlink(name.c_str());
+    }
+
+    void Publisher::step(unsigned x, unsigned y, Dir heading, unsigned walls, MouseMovement movement) {
+        if(!segment)
+            return;
+        const unsigned cell = x * len + y;
+        const uint64_t bit = 1ull << (cell % 64);
+        boards[SENSED_BOARD][cell / 64] |= bit;
+        for(unsigned d = NORTH; d <= WEST; d++) {
+            if(walls & (1 << d))
+                boards[1 + d][cell / 64] |= bit;
+        }
+
+        const uint64_t frame = published;
+        Slot &slot = segment->slots[frame % SLOTS];
+        slot.seq.store(2 * frame + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.step.store(frame, std::memory_order_relaxed);
+        slot.pose.store(x | y << 8 | (uint64_t)heading << 16 | (uint64_t)movement << 24, std::memory_order_relaxed);
+        const unsigned cells = len * len;
+        for(unsigned b = 0; b < BOARDS; b++) {
+            for(unsigned w = 0; w < (cells + 63) / 64; w++) {
+                slot.boards[b][w].store(boards[b][w], std::memory_order_relaxed);
+            }
+        }
+        for(unsigned w = 0; withDistances && w < (cells + 3) / 4; w++) {
+            slot.distances[w].store((uint64_t)distances[4 * w] | (uint64_t)distances[4 * w + 1] << 16 |
+                                    (uint64_t)distances[4 * w + 2] << 32 | (uint64_t)distances[4 * w + 3] << 48,
+                                    std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * frame + 2, std::memory_order_release);
+        segment->published.store(++published, std::memory_order_release);
+    }
+
+    Viewer::Viewer(const char *name)
+    : segment(NULL), len(0), maze(0), seen(0), read(0), dropped(0) {
+        const std::string shared = path(name);
+        const int fd = shm_open(shared.c_str(), O_RDONLY, 0);
+        if(fd < 0) {
+            error = "Cannot open shared memory " + shared + ": " + strerror(errno);
+            return;
+        }
+        struct stat st;
+        void *memory = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Segment))
+            memory = mmap(NULL, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(memory == MAP_FAILED) {
+            error = "Shared memory " + shared + " is not a live view (yet)";
+            return;
+        }
+        segment = static_cast<const Segment *>(memory);
+        if(segment->magic.load(std::memory_order_acquire) != MAGIC || segment->version != VERSION || segment->len > MAX_LEN) {
+            error = "Shared memory " + shared + " is not a live view (yet)";
+            munmap(const_cast<Segment *>(segment), sizeof(Segment));
+            segment = NULL;
+            return;
+        }
+        len = segment->len;
+        maze = segment->maze;
+    }
+
+    Viewer::~Viewer() {
+        if(segment)
+            munmap(const_cast<Segment *>(segment), sizeof(Segment));
+    }
+
+    bool Viewer::latest(Replay::Frame &frame) {
+        if(!segment)
+            return false;
+        const unsigned cells = len * len;
+        uint64_t boards[BOARDS][BOARD_WORDS];
+        uint64_t distances[DISTANCE_WORDS];
+        uint64_t newest, step, pose;
+        for(;;) {
+            const uint64_t published = segment->published.load(std::memory_order_acquire);
+            if(published == seen)
+                return false;
+            newest = published - 1;
+            const Slot &slot = segment->slots[newest % SLOTS];
+            const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            // the writer has lapped the ring since: look again.
+            if(seq != 2 * newest + 2)
+                continue;
+            step = slot.step.load(std::memory_order_relaxed);
+            pose = slot.pose.load(std::memory_order_relaxed);
+            for(unsigned b = 0; b < BOARDS; b++) {
+                for(unsigned w = 0; w < (cells + 63) / 64; w++) {
+                    boards[b][w] = slot.boards[b][w].load(std::memory_order_relaxed);
+                }
+            }
+            for(unsigned w = 0; segment->withDistances && w < (cells + 3) / 4; w++) {
+                distances[w] = slot.distances[w].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.seq.load(std::memory_order_relaxed) == seq)
+                break;
+        }
+        dropped += newest - seen;
+        seen = newest + 1;
+        read++;
+
+        frame.step = step;
+        frame.x = pose & 0xff;
+        frame.y = pose >> 8 & 0xff;
+        frame.heading = (Dir)(pose >> 16 & 0xff);
+        frame.movement = (MouseMovement)(pose >> 24 & 0xff);
+        frame.nextRecord = 0;
+        frame.walls.assign(cells, 0);
+        for(unsigned cell = 0; cell < cells; cell++) {
+            const uint64_t bit = 1ull << (cell % 64);
+            if(!(boards[SENSED_BOARD][cell / 64] & bit))
+                continue;
+            frame.walls[cell] = Replay::SENSED;
+            for(unsigned d = NORTH; d <= WEST; d++) {
+                if(boards[1 + d][cell / 64] & bit)
+                    frame.walls[cell] |= 1 << d;
+            }
+        }
+        frame.distances.clear();
+        if(segment->withDistances) {
+            frame.distances.resize(cells);
+            for(unsigned cell = 0; cell < cells; cell++) {
+                frame.distances[cell] = distances[cell / 4] >> (16 * (cell % 4)) & 0xffff;
+            }
+        }
+        return true;
+    }
+
+    bool Viewer::done() const {
+        return !segment || (segment->finished.load(std::memory_order_acquire) &&
+                            segment->published.load(std::memory_order_acquire) == seen);
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef LiveView_h
+#define LiveView_h
+
+#include <stdint.h> // uint16_t, uint32_t, uint64_t
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Dir.h"
+#include "MouseMovement.h"
+#include "Replay.h"
+
+/**
+ * A live view of a run from another process: every step is published into a ring of frames
+ * in POSIX shared memory, and a viewer (ViewRun) draws the latest one at its own rate.
+ *
+ * The run never waits for the viewer. The ring has one writer and never fills up: the writer
+ * overwrites the oldest frame, and a viewer that falls behind skips to the newest, counting
+ * the frames it dropped. Each slot is guarded by a sequence counter (odd while being written)
+ * like the planner's distance buffers, so neither side takes a lock, and the frames are
+ * 64-bit words copied with relaxed atomics, which are lock-free and work across processes.
+ *
+ * A frame is the pose and the movement, the walls sensed so far as bitboards (a bit per cell:
+ * sensed, and closed for each side) and the PathFinder's distances, 16 bits per cell.
+ */
+namespace LiveView {
+    // largest maze side a frame has room for.
+    const unsigned MAX_LEN = 32;
+    const unsigned MAX_CELLS = MAX_LEN * MAX_LEN;
+    const unsigned BOARD_WORDS = MAX_CELLS / 64;
+    const unsigned DISTANCE_WORDS = MAX_CELLS / 4;
+    // bitboards of a frame: the sensed cells, then the closed sides by Dir.
+    const unsigned SENSED_BOARD = 0;
+    const unsigned BOARDS = 5;
+    // frames in the ring.
+    const unsigned SLOTS = 64;
+
+    struct Slot {
+        // 2 * frame + 1 while frame is being written, 2 * frame + 2 once it is complete.
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> step;
+        // x, y, heading and movement, a byte each from the lowest.
+        std::atomic<uint64_t> pose;
+        std::atomic<uint64_t> boards[BOARDS][BOARD_WORDS];
+        // four distances a word, by cell number x * len + y.
+        std::atomic<uint64_t> distances[DISTANCE_WORDS];
+    };
+
+    /**
+     * The shared memory: what the run is, then the ring.
+     */
+    struct Segment {
+        // written last by the publisher, once the rest of the header is.
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint32_t len;
+        uint32_t maze;
+        uint32_t withDistances;
+        // frames published so far, the newest being frame published - 1.
+        std::atomic<uint64_t> published;
+        // set once the run is over and no more frames follow.
+        std::atomic<uint32_t> finished;
+        Slot slots[SLOTS];
+    };
+
+    /**
+     * Publishes the steps of a run. Hand it to BasicMouseSession::setPublisher before start().
+     */
+    class Publisher {
+    public:
+        /**
+         * Create the shared memory, replacing any left over from an earlier run.
+         * @param name: name of the shared memory, e.g. "mouse" for /dev/shm/mouse
+         * @param len: side of the maze, at most MAX_LEN
+         * @param maze: built-in maze number
+         * @param distances: publish the PathFinder's distance field as well
+         */
+        Publisher(const char *name, unsigned len, unsigned maze, bool distances);
+
+        // mark the run finished and remove the shared memory. Viewers attached keep what they mapped.
+        ~Publisher();
+
+        inline bool good() const {
+            return error.empty();
+        }
+
+        // why the shared memory could not be created, empty if it could.
+        inline const std::string &getError() const {
+            return error;
+        }
+
+        inline bool hasDistances() const {
+            return withDistances;
+        }
+
+        /**
+         * Where to put the distance field of the step about to be published, len * len cells by
+         * cell number, when hasDistances.
+         */
+        inline uint16_t *distanceBuffer() {
+            return &distances[0];
+        }
+
+        /**
+         * Publish a nextMovement call. Never waits.
+         * @param x, y, heading: pose of the mouse when the PathFinder was asked
+         * @param walls: 1 << Dir for each closed side of the cell
+         * @param movement: what it returned
+         */
+        void step(unsigned x, unsigned y, Dir heading, unsigned walls, MouseMovement movement);
+
+        inline unsigned long getPublished() const {
+            return published;
+        }
+
+    protected:
+        std::string error;
+        std::string name;
+        Segment *segment;
+        const unsigned len;
+        const bool withDistances;
+        unsigned long published;
+        // the walls sensed so far, and the distances of the step being published.
+        uint64_t boards[BOARDS][BOARD_WORDS];
+        std::vector<uint16_t> distances;
+    };
+
+    /**
+     * Attaches to the shared memory of a run and reads its newest frames.
+     */
+    class Viewer {
+    public:
+        /**
+         * @param name: name the run publishes under. See good and getError.
+         */
+        explicit Viewer(const char *name);
+
+        ~Viewer();
+
+        inline bool good() const {
+            return error.empty();
+        }
+
+        // why the shared memory could not be attached to, empty if it could.
+        inline const std::string &getError() const {
+            return error;
+        }
+
+        inline unsigned getLen() const {
+            return len;
+        }
+
+        inline unsigned getMaze() const {
+            return maze;
+        }
+
+        /**
+         * The newest frame, if there is one newer than the last one read. The frames in between
+         * are dropped.
+         * @param frame: set to the frame, in the form of a replay's (Frame::nextRecord is unused)
+         * @return false if nothing was published since the last call
+         */
+        bool latest(Replay::Frame &frame);
+
+        // true once the run is over and its last frame has been read.
+        bool done() const;
+
+        // frames read, and frames published but never read.
+        inline unsigned long getRead() const {
+            return read;
+        }
+        inline unsigned long getDropped() const {
+            return dropped;
+        }
+
+    protected:
+        std::string error;
+        const Segment *segment;
+        unsigned len;
+        unsigned maze;
+        // frames published as of the last one read.
+        uint64_t seen;
+        unsigned long read;
+        unsigned long dropped;
+    };
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cstdlib>  // atof
+#include <cstring>  // strcmp
+#include <chrono>
+#include <thread>
+#include <memory>   // std::unique_ptr
+#include "Replay.h"
+#include "LiveView.h"
+
+/**
+ * Watches a run published with `run -y NAME` from another process (see LiveView.h).
+ *
+ * It waits for the run to start, then draws the newest step, at most FPS times a second, until
+ * the run is over. Steps published in between are dropped, so the run goes at its own speed
+ * whatever the terminal's.
+ */
+
+int main(int argc, char * argv[]) {
+    const char *name = NULL;
+    double fps = 30;
+    double waitSeconds = 10;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            fps = atof(argv[++i]);
+        } else if(strcmp(argv[i], "-w") == 0 && i+1 < argc) {
+            waitSeconds = atof(argv[++i]);
+        } else if(argv[i][0] != '-' && !name) {
+            name = argv[i];
+        } else {
+            name = NULL;
+            break;
+        }
+    }
+    if(!name || fps <= 0) {
+        std::cout << "Usage: " << argv[0] << " NAME [-f FPS] [-w SECONDS]" << std::endl;
+        std::cout << "\tNAME is the shared memory a run publishes to with run -y NAME" << std::endl;
+        std::cout << "\t-f FPS will draw at most FPS steps a second (default 30)" << std::endl;
+        std::cout << "\t-w SECONDS will wait up to SECONDS for the run to start, or for its next step (default 10)" << std::endl;
+        return -1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration wait = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(waitSeconds));
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / fps));
+
+    // the run creates the shared memory when it starts.
+    std::unique_ptr<LiveView::Viewer> viewer;
+    for(Clock::time_point giveUp = Clock::now() + wait; ; ) {
+        viewer.reset(new LiveView::Viewer(name));
+        if(viewer->good() || Clock::now() > giveUp)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if(!viewer->good()) {
+        std::cerr << viewer->getError() << std::endl;
+        return 1;
+    }
+
+    Replay::Frame frame;
+    Clock::time_point lastFrame = Clock::now();
+    for(Clock::time_point tick = Clock::now(); !viewer->done(); tick += period) {
+        if(viewer->latest(frame)) {
+            lastFrame = Clock::now();
+            // home the cursor and clear the screen, so every step is drawn in the same place.
+            std::cout << "\033[H\033[2J" << "Maze " << viewer->getMaze() << ", step " << frame.step << ": "
+                      << movementName(frame.movement) << " (" << viewer->getDropped() << " steps dropped)\n"
+                      << Replay::draw(frame, viewer->getLen()) << std::endl;
+        } else if(Clock::now() - lastFrame > wait) {
+            std::cerr << "No step for " << waitSeconds << " seconds, the run is gone" << std::endl;
+            return 1;
+        }
+        // a slow terminal does not make up for lost ticks.
+        if(Clock::now() > tick + period)
+            tick = Clock::now();
+        std::this_thread::sleep_until(tick + period);
+    }
+    std::cout << viewer->getRead() + viewer->getDropped() << " steps published, " << viewer->getRead() << " drawn, "
+              << viewer->getDropped() << " dropped" << std::endl;
+    return 0;
+}
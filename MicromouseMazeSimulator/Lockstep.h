@@ -0,0 +1,491 @@
+#ifndef Lockstep_h
+#define Lockstep_h
+
+#include <stdint.h> // uint8_t, int32_t, uint32_t
+#include <cstddef>  // size_t
+#include <vector>
+
+#include "Dir.h"
+#include "MazeWorld.h"
+#include "PathFinder.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Reactive mice by the thousand, in lockstep.
+ *
+ * A reactive policy such as LeftWallFollower decides its next movement from a few bits of
+ * memory and the walls in front, on the left and on the right, nothing else. Such a policy
+ * is a table (Policy) and a mouse is a handful of integers, kept structure of arrays in Mice.
+ * Engine moves them all a movement at a time: with AVX2, 32 mice per step, the walls of their
+ * cells and the policy entries fetched with gathers, no virtual call, no branch per mouse.
+ * A finished mouse gives its lane to the next one waiting.
+ *
+ * Mice start in (0,0) facing north, like in MouseSession, and stop for the same reasons as
+ * LeftWallFollower: in the center, back in the start cell once they have left it, or when
+ * the policy says Finish.
+ */
+namespace Lockstep {
+    // bits of memory a policy can keep between movements.
+    const unsigned STATES = 4;
+    // entries of a policy: every state with every combination of open sides.
+    const unsigned ENTRIES = STATES * 16;
+
+    // how a mouse stopped.
+    enum Outcome {
+        RUNNING,
+        AT_CENTER,
+        BACK_AT_START,  // in the start cell for the second time
+        STOPPED,        // the policy returned Finish
+        CRASHED,        // moved into a wall
+        CUT_OFF         // took more than the step limit
+    };
+
+    inline const char *outcomeName(Outcome o) {
+        switch(o) {
+            case RUNNING:
+                return "running";
+            case AT_CENTER:
+                return "center";
+            case BACK_AT_START:
+                return "start";
+            case STOPPED:
+                return "stopped";
+            case CRASHED:
+                return "crashed";
+            case CUT_OFF:
+                return "cut off";
+            default:
+                return "unknown";
+        }
+    }
+
+    /**
+     * A reactive policy as a table.
+     *
+     * Headings and sides count clockwise from north (0 north, 1 east, 2 south, 3 west). An
+     * entry is indexed by state << 4 | open sides relative to the heading (bit 0 in front,
+     * 1 on the right, 2 behind, 3 on the left) and holds what to do:
+     *     bits 0-1  quarter turns clockwise
+     *     bit  2    move
+     *     bits 3-4  side to move to, relative to the heading after the turn
+     *     bits 5-6  next state
+     *     bit  7    Finish
+     */
+    struct Policy {
+        static const int32_t TURN = 3;
+        static const int32_t MOVE = 1 << 2;
+        static const int32_t SIDE_SHIFT = 3;
+        static const int32_t STATE_SHIFT = 5;
+        static const int32_t FINISH = 1 << 7;
+
+        int32_t entry[ENTRIES];
+
+        /**
+         * Tabulate a rule.
+         * @param rule: MouseMovement rule(unsigned &state, bool frontWall, bool leftWall, bool rightWall),
+         *        state below STATES. Called once per entry, it must not depend on anything else.
+         */
+        template <typename Rule>
+        explicit Policy(Rule rule) {
+            for(unsigned s = 0; s < STATES; s++) {
+                for(unsigned open = 0; open < 16; open++) {
+                    unsigned state = s;
+                    const MouseMovement m = rule(state, !(open & 1), !(open & 8), !(open & 2));
+                    entry[s << 4 | open] = encode(m, state % STATES);
+                }
+            }
+        }
+
+    protected:
+        static int32_t encode(MouseMovement m, unsigned state) {
+            const int32_t next = state << STATE_SHIFT;
+            switch(m) {
+                case MoveForward:
+                    return next | MOVE;
+                case MoveBackward:
+                    return next | MOVE | 2 << SIDE_SHIFT;
+                case TurnClockwise:
+                    return next | 1;
+                case TurnCounterClockwise:
+                    return next | 3;
+                case TurnAround:
+                    return next | 2;
+                case Wait:
+                    return next;
+                case Finish:
+                default:
+                    return FINISH;
+            }
+        }
+    };
+
+    /**
+     * LeftWallFollower's rule (main.cpp), for either hand. State 1 is "just turned toward the
+     * hand, go forward next".
+     */
+    inline MouseMovement wallFollower(bool leftHand, unsigned &state, bool frontWall, bool leftWall, bool rightWall) {
+        const bool handWall = leftHand ? leftWall : rightWall;
+        if(!frontWall && state) {
+            state = 0;
+            return MoveForward;
+        }
+        if(!frontWall && handWall) {
+            state = 0;
+            return MoveForward;
+        }
+        if(frontWall && handWall) {
+            state = 0;
+            return leftHand ? TurnClockwise : TurnCounterClockwise;
+        }
+        if(!handWall) {
+            state = 1;
+            return leftHand ? TurnCounterClockwise : TurnClockwise;
+        }
+        return Finish;
+    }
+
+    inline Policy leftHand() {
+        return Policy([](unsigned &state, bool f, bool l, bool r) { return wallFollower(true, state, f, l, r); });
+    }
+
+    inline Policy rightHand() {
+        return Policy([](unsigned &state, bool f, bool l, bool r) { return wallFollower(false, state, f, l, r); });
+    }
+
+    /**
+     * The mazes the mice run in, a byte per cell: bits 0-3 the open sides clockwise from
+     * north, bit 4 a center cell, bit 5 the start cell. Cell (x,y) of maze m is byte
+     * m * CELLS + x * LEN + y, so a corpus holds up to 2^31 / CELLS mazes.
+     */
+    template <unsigned LEN>
+    class Corpus {
+    public:
+        static const unsigned CELLS = LEN * LEN;
+        static const uint8_t CENTER = 1 << 4;
+        static const uint8_t START = 1 << 5;
+
+        Corpus() : count(0), cells(PADDING, 0) {}
+
+        /**
+         * Add a maze.
+         * @return its index, for Mice::add
+         */
+        size_t add(const BasicMazeWorld<LEN> &world) {
+            const Dir sides[4] = {NORTH, EAST, SOUTH, WEST};
+            const unsigned mid = LEN / 2;
+            const size_t base = count * CELLS;
+            cells.resize(base + CELLS + PADDING, 0);
+            for(unsigned x = 0; x < LEN; x++) {
+                for(unsigned y = 0; y < LEN; y++) {
+                    uint8_t cell = 0;
+                    for(unsigned side = 0; side < 4; side++) {
+                        cell |= world.isOpen(x, y, sides[side]) << side;
+                    }
+                    if((x == mid || x == mid - 1) && (y == mid || y == mid - 1))
+                        cell |= CENTER;
+                    if(x == 0 && y == 0)
+                        cell |= START;
+                    cells[base + x * LEN + y] = cell;
+                }
+            }
+            return count++;
+        }
+
+        inline size_t size() const {
+            return count;
+        }
+
+        inline const uint8_t *data() const {
+            return &cells[0];
+        }
+
+    protected:
+        // a gather reads 4 bytes for every cell, the last cell too.
+        static const size_t PADDING = 3;
+
+        size_t count;
+        std::vector<uint8_t> cells;
+    };
+
+    /**
+     * The mice, structure of arrays: what each one runs, and where and how it ended.
+     */
+    struct Mice {
+        // index into the Corpus and into the policies of the Engine.
+        std::vector<uint32_t> maze;
+        std::vector<uint8_t> policy;
+
+        // filled in by Engine::run.
+        std::vector<uint8_t> x;
+        std::vector<uint8_t> y;
+        std::vector<uint8_t> heading;  // a Dir
+        std::vector<uint32_t> steps;   // movements made, Wait included
+        std::vector<uint8_t> outcome;  // an Outcome
+
+        size_t add(uint32_t mazeIndex, uint8_t policyIndex) {
+            maze.push_back(mazeIndex);
+            policy.push_back(policyIndex);
+            x.push_back(0);
+            y.push_back(0);
+            heading.push_back(NORTH);
+            steps.push_back(0);
+            outcome.push_back(RUNNING);
+            return maze.size() - 1;
+        }
+
+        inline size_t size() const {
+            return maze.size();
+        }
+    };
+
+    /**
+     * Runs mice. run and runScalar only read the engine, so threads can run disjoint ranges
+     * of the same Mice with one engine.
+     */
+    template <unsigned LEN>
+    class Engine {
+    public:
+        static const unsigned CELLS = Corpus<LEN>::CELLS;
+
+        /**
+         * @param corpus: mazes, kept by reference
+         * @param policies: at most 256
+         * @param maxSteps: movements after which a mouse is cut off. 0 for the number of
+         *        (cell, heading, state, start seen) poses, which no run that ends can exceed.
+         */
+        Engine(const Corpus<LEN> &corpus, const std::vector<Policy> &policies, uint32_t maxSteps = 0)
+        : corpus(corpus), maxSteps(maxSteps ? maxSteps : CELLS * 4 * STATES * 2) {
+            for(size_t p = 0; p < policies.size(); p++) {
+                table.insert(table.end(), policies[p].entry, policies[p].entry + ENTRIES);
+            }
+        }
+
+        // "AVX2, 32 lanes" or "scalar", whichever run uses.
+        static const char *instructionSet() {
+#if defined(__AVX2__)
+            return "AVX2, 32 lanes";
+#else
+            return "scalar";
+#endif
+        }
+
+        /**
+         * Run mice [first, first + count) to the end.
+         * @return movements made, by all of them together
+         */
+        unsigned long run(Mice &mice, size_t first, size_t count) const {
+#if defined(__AVX2__)
+            return runVector(mice, first, count);
+#else
+            return runScalar(mice, first, count);
+#endif
+        }
+
+        // run, one mouse after the other.
+        unsigned long runScalar(Mice &mice, size_t first, size_t count) const {
+            const uint8_t *cells = corpus.data();
+            unsigned long total = 0;
+            for(size_t i = first; i < first + count; i++) {
+                const uint32_t base = mice.maze[i] * CELLS;
+                const int32_t *entries = &table[mice.policy[i] * ENTRIES];
+                uint32_t cell = base, heading = 0, state = 0, steps = 0;
+                bool visited = false;
+                Outcome outcome = RUNNING;
+                while(outcome == RUNNING) {
+                    const unsigned m = cells[cell];
+                    if(steps >= maxSteps) {
+                        outcome = CUT_OFF;
+                        break;
+                    }
+                    if(m & Corpus<LEN>::CENTER) {
+                        outcome = AT_CENTER;
+                        break;
+                    }
+                    if(m & Corpus<LEN>::START) {
+                        if(visited) {
+                            outcome = BACK_AT_START;
+                            break;
+                        }
+                        visited = true;
+                    }
+                    const unsigned open = (((m & 15) | (m & 15) << 4) >> heading) & 15;
+                    const int32_t e = entries[state << 4 | open];
+                    if(e & Policy::FINISH) {
+                        outcome = STOPPED;
+                        break;
+                    }
+                    steps++;
+                    heading = (heading + (e & Policy::TURN)) & 3;
+                    state = (e >> Policy::STATE_SHIFT) & 3;
+                    if(e & Policy::MOVE) {
+                        const unsigned side = (heading + (e >> Policy::SIDE_SHIFT)) & 3;
+                        if(!((m >> side) & 1)) {
+                            outcome = CRASHED;
+                            break;
+                        }
+                        cell += DELTA[side];
+                    }
+                }
+                finish(mice, i, cell - base, heading, steps, outcome);
+                total += steps;
+            }
+            return total;
+        }
+
+    protected:
+        // cell index change of a move to each side, clockwise from north.
+        static constexpr int32_t DELTA[4] = {1, (int32_t)LEN, -1, -(int32_t)LEN};
+
+        static void finish(Mice &mice, size_t i, uint32_t offset, uint32_t heading, uint32_t steps, Outcome outcome) {
+            const Dir dirs[4] = {NORTH, EAST, SOUTH, WEST};
+            mice.x[i] = offset / LEN;
+            mice.y[i] = offset % LEN;
+            mice.heading[i] = dirs[heading & 3];
+            mice.steps[i] = steps;
+            mice.outcome[i] = outcome;
+        }
+
+#if defined(__AVX2__)
+        // independent groups of 8 lanes per step, so the gathers of one hide the latency of the others.
+        static const unsigned GROUPS = 4;
+        static const unsigned LANES = 8 * GROUPS;
+
+        unsigned long runVector(Mice &mice, size_t first, size_t count) const {
+            const int *cells = (const int *)corpus.data();
+            const int *entries = &table[0];
+            const size_t end = first + count;
+            size_t next = first;
+
+            // the lanes, between the registers and the mice. A lane without a mouse is inactive in cell 0.
+            alignas(32) int32_t cell[LANES], heading[LANES], state[LANES], visited[LANES];
+            alignas(32) int32_t policy[LANES], steps[LANES], active[LANES], outcome[LANES];
+            size_t mouse[LANES];
+            unsigned running = 0;
+            unsigned long total = 0;
+            for(unsigned lane = 0; lane < LANES; lane++) {
+                running += refill(mice, lane, next, end, cell, heading, state, visited, policy, steps, active, mouse);
+            }
+
+            const __m256i one = _mm256_set1_epi32(1);
+            const __m256i three = _mm256_set1_epi32(3);
+            const __m256i fifteen = _mm256_set1_epi32(15);
+            const __m256i byte = _mm256_set1_epi32(0xff);
+            const __m256i center = _mm256_set1_epi32(Corpus<LEN>::CENTER);
+            const __m256i start = _mm256_set1_epi32(Corpus<LEN>::START);
+            const __m256i move = _mm256_set1_epi32(Policy::MOVE);
+            const __m256i finishBit = _mm256_set1_epi32(Policy::FINISH);
+            const __m256i limit = _mm256_set1_epi32(maxSteps - 1);
+            const __m256i delta = _mm256_setr_epi32(DELTA[0], DELTA[1], DELTA[2], DELTA[3], 0, 0, 0, 0);
+
+            __m256i c[GROUPS], h[GROUPS], s[GROUPS], v[GROUPS], p[GROUPS], n[GROUPS], a[GROUPS];
+            while(running) {
+                for(unsigned g = 0; g < GROUPS; g++) {
+                    c[g] = _mm256_load_si256((const __m256i *)&cell[8 * g]);
+                    h[g] = _mm256_load_si256((const __m256i *)&heading[8 * g]);
+                    s[g] = _mm256_load_si256((const __m256i *)&state[8 * g]);
+                    v[g] = _mm256_load_si256((const __m256i *)&visited[8 * g]);
+                    p[g] = _mm256_load_si256((const __m256i *)&policy[8 * g]);
+                    n[g] = _mm256_load_si256((const __m256i *)&steps[8 * g]);
+                    a[g] = _mm256_load_si256((const __m256i *)&active[8 * g]);
+                }
+
+                // step until a mouse stops.
+                for(unsigned stopped = 0; !stopped; ) {
+                    for(unsigned g = 0; g < GROUPS; g++) {
+                        const __m256i m = _mm256_and_si256(_mm256_i32gather_epi32(cells, c[g], 1), byte);
+                        const __m256i cut = _mm256_cmpgt_epi32(n[g], limit);
+                        const __m256i atCenter = _mm256_cmpeq_epi32(_mm256_and_si256(m, center), center);
+                        const __m256i atStart = _mm256_cmpeq_epi32(_mm256_and_si256(m, start), start);
+                        const __m256i backAtStart = _mm256_and_si256(atStart, v[g]);
+                        v[g] = _mm256_or_si256(v[g], atStart);
+
+                        // the open sides turned so that the heading is bit 0.
+                        const __m256i sides = _mm256_and_si256(m, fifteen);
+                        const __m256i open = _mm256_and_si256(_mm256_srlv_epi32(_mm256_or_si256(sides, _mm256_slli_epi32(sides, 4)), h[g]), fifteen);
+                        const __m256i e = _mm256_i32gather_epi32(entries, _mm256_add_epi32(p[g], _mm256_or_si256(_mm256_slli_epi32(s[g], 4), open)), 4);
+                        const __m256i finished = _mm256_cmpeq_epi32(_mm256_and_si256(e, finishBit), finishBit);
+
+                        const __m256i stop = _mm256_or_si256(_mm256_or_si256(cut, atCenter), _mm256_or_si256(backAtStart, finished));
+                        const __m256i go = _mm256_andnot_si256(stop, a[g]);
+
+                        const __m256i turned = _mm256_and_si256(_mm256_add_epi32(h[g], e), three);
+                        const __m256i side = _mm256_and_si256(_mm256_add_epi32(turned, _mm256_srli_epi32(e, Policy::SIDE_SHIFT)), three);
+                        const __m256i moves = _mm256_and_si256(go, _mm256_cmpeq_epi32(_mm256_and_si256(e, move), move));
+                        const __m256i sideOpen = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(m, side), one), one);
+                        const __m256i crash = _mm256_andnot_si256(sideOpen, moves);
+
+                        c[g] = _mm256_add_epi32(c[g], _mm256_and_si256(_mm256_and_si256(moves, sideOpen), _mm256_permutevar8x32_epi32(delta, side)));
+                        h[g] = _mm256_blendv_epi8(h[g], turned, go);
+                        s[g] = _mm256_blendv_epi8(s[g], _mm256_and_si256(_mm256_srli_epi32(e, Policy::STATE_SHIFT), three), go);
+                        n[g] = _mm256_sub_epi32(n[g], go);
+
+                        const __m256i done = _mm256_or_si256(_mm256_and_si256(stop, a[g]), crash);
+                        if(!_mm256_testz_si256(done, done)) {
+                            // rare: how they stopped, the first reason that applies.
+                            __m256i o = _mm256_set1_epi32(CRASHED);
+                            o = _mm256_blendv_epi8(o, _mm256_set1_epi32(STOPPED), finished);
+                            o = _mm256_blendv_epi8(o, _mm256_set1_epi32(BACK_AT_START), backAtStart);
+                            o = _mm256_blendv_epi8(o, _mm256_set1_epi32(AT_CENTER), atCenter);
+                            o = _mm256_blendv_epi8(o, _mm256_set1_epi32(CUT_OFF), cut);
+                            _mm256_store_si256((__m256i *)&outcome[8 * g], _mm256_and_si256(o, done));
+                            a[g] = _mm256_andnot_si256(done, a[g]);
+                            stopped |= _mm256_movemask_ps(_mm256_castsi256_ps(done)) << (8 * g);
+                        }
+                    }
+                }
+
+                for(unsigned g = 0; g < GROUPS; g++) {
+                    _mm256_store_si256((__m256i *)&cell[8 * g], c[g]);
+                    _mm256_store_si256((__m256i *)&heading[8 * g], h[g]);
+                    _mm256_store_si256((__m256i *)&state[8 * g], s[g]);
+                    _mm256_store_si256((__m256i *)&visited[8 * g], v[g]);
+                    _mm256_store_si256((__m256i *)&steps[8 * g], n[g]);
+                    _mm256_store_si256((__m256i *)&active[8 * g], a[g]);
+                }
+                for(unsigned lane = 0; lane < LANES; lane++) {
+                    if(mouse[lane] != NONE && !active[lane]) {
+                        const uint32_t base = mice.maze[mouse[lane]] * CELLS;
+                        finish(mice, mouse[lane], cell[lane] - base, heading[lane], steps[lane], (Outcome)outcome[lane]);
+                        total += steps[lane];
+                        running--;
+                        running += refill(mice, lane, next, end, cell, heading, state, visited, policy, steps, active, mouse);
+                    }
+                }
+            }
+            return total;
+        }
+
+        static const size_t NONE = (size_t)-1;
+
+        // put the next mouse waiting, if any, in lane. @return whether there was one
+        static bool refill(const Mice &mice, unsigned lane, size_t &next, size_t end, int32_t *cell, int32_t *heading,
+                           int32_t *state, int32_t *visited, int32_t *policy, int32_t *steps, int32_t *active, size_t *mouse) {
+            heading[lane] = 0;
+            state[lane] = 0;
+            visited[lane] = 0;
+            steps[lane] = 0;
+            if(next >= end) {
+                cell[lane] = 0;
+                policy[lane] = 0;
+                active[lane] = 0;
+                mouse[lane] = NONE;
+                return false;
+            }
+            cell[lane] = mice.maze[next] * CELLS;
+            policy[lane] = mice.policy[next] * ENTRIES;
+            active[lane] = -1;
+            mouse[lane] = next++;
+            return true;
+        }
+#endif
+
+        const Corpus<LEN> &corpus;
+        const uint32_t maxSteps;
+        std::vector<int32_t> table;
+    };
+}
+
+#endif
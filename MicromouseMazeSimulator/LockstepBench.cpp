@@ -0,0 +1,250 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>  // atoi, atof
+#include <cstring>  // strcmp
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "MouseSession.h"
+#include "BatchFlood.h"
+#include "Lockstep.h"
+
+/**
+ * Wall followers across a whole corpus of mazes, three ways.
+ *
+ * The corpus is every built-in maze of the size followed by generated ones (BatchFlood::Walls),
+ * and every maze gets a left-hand and a right-hand wall follower. They run once through
+ * MouseSession and a PathFinder, the way the simulator runs LeftWallFollower, then as
+ * Lockstep::Engine tables one mouse at a time, then in lockstep on as many threads as asked.
+ * All three have to agree on the steps, the outcome and the cell every mouse ends in.
+ */
+
+// a generated maze as a world.
+template <unsigned LEN>
+class GeneratedWorld : public BasicMazeWorld<LEN> {
+public:
+    explicit GeneratedWorld(const BatchFlood::Walls<LEN> &walls) : BasicMazeWorld<LEN>(0u) {
+        this->wallNS.clearAll();
+        this->wallEW.clearAll();
+        for(unsigned x = 0; x < LEN; x++) {
+            for(unsigned y = 0; y < LEN; y++) {
+                if(walls.isNorthOpen(x, y))
+                    this->setOpen(x, y, NORTH);
+                if(walls.isEastOpen(x, y))
+                    this->setOpen(x, y, EAST);
+            }
+        }
+    }
+};
+
+// the rule of Lockstep::wallFollower as a PathFinder, stopping where LeftWallFollower stops.
+template <unsigned LEN>
+class RuleFinder : public BasicPathFinder<LEN> {
+public:
+    explicit RuleFinder(bool leftHand)
+    : leftHand(leftHand), state(0), visitedStart(false), x(0), y(0), outcome(Lockstep::RUNNING) {}
+
+    MouseMovement nextMovement(unsigned mouseX, unsigned mouseY, const BasicMouseSession<LEN> &maze) {
+        const unsigned mid = LEN / 2;
+        x = mouseX;
+        y = mouseY;
+        if((x == mid || x == mid - 1) && (y == mid || y == mid - 1)) {
+            outcome = Lockstep::AT_CENTER;
+            return Finish;
+        }
+        if(x == 0 && y == 0) {
+            if(visitedStart) {
+                outcome = Lockstep::BACK_AT_START;
+                return Finish;
+            }
+            visitedStart = true;
+        }
+        const MouseMovement m = Lockstep::wallFollower(leftHand, state, maze.wallInFront(), maze.wallOnLeft(), maze.wallOnRight());
+        if(m == Finish)
+            outcome = Lockstep::STOPPED;
+        return m;
+    }
+
+    const bool leftHand;
+    unsigned state;
+    bool visitedStart;
+    unsigned x;
+    unsigned y;
+    Lockstep::Outcome outcome;
+};
+
+// best time in nanoseconds of as many calls to work as fit in minSeconds, at least two.
+template <typename Work>
+double bestOf(double minSeconds, Work work) {
+    double best = 0;
+    double spent = 0;
+    for(unsigned run = 0; run < 2 || spent < minSeconds * 1e9; run++) {
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        work();
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        spent += nanos;
+        if(run == 0 || nanos < best) {
+            best = nanos;
+        }
+    }
+    return best;
+}
+
+template <unsigned LEN>
+int run(unsigned generated, unsigned loops, double minSeconds, unsigned threads) {
+    const unsigned builtIn = MazeDefinitions::Encodings<LEN>::COUNT;
+    std::vector<GeneratedWorld<LEN> > worlds;
+    worlds.reserve(generated);
+    for(unsigned i = 0; i < generated; i++) {
+        BatchFlood::Walls<LEN> walls;
+        walls.generate(i + 1, loops);
+        worlds.push_back(GeneratedWorld<LEN>(walls));
+    }
+
+    Lockstep::Corpus<LEN> corpus;
+    Lockstep::Mice mice;
+    for(unsigned m = 0; m < builtIn + generated; m++) {
+        const size_t maze = corpus.add(m < builtIn ? BasicMazeWorld<LEN>::get(m) : worlds[m - builtIn]);
+        mice.add(maze, 0);
+        mice.add(maze, 1);
+    }
+    std::vector<Lockstep::Policy> policies;
+    policies.push_back(Lockstep::leftHand());
+    policies.push_back(Lockstep::rightHand());
+    const Lockstep::Engine<LEN> engine(corpus, policies);
+
+    // through MouseSession, once: it is the reference.
+    std::vector<unsigned long> steps(mice.size());
+    std::vector<unsigned> outcomes(mice.size()), xs(mice.size()), ys(mice.size());
+    unsigned long movements = 0;
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < mice.size(); i++) {
+        const unsigned m = mice.maze[i];
+        RuleFinder<LEN> finder(mice.policy[i] == 0);
+        BasicMouseSession<LEN> session(m < builtIn ? BasicMazeWorld<LEN>::get(m) : worlds[m - builtIn], &finder);
+        try {
+            session.start();
+        } catch(const char *) {
+            finder.outcome = Lockstep::CRASHED;
+        }
+        steps[i] = session.getStepCount();
+        outcomes[i] = finder.outcome;
+        xs[i] = finder.x;
+        ys[i] = finder.y;
+        movements += steps[i];
+    }
+    const double session = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    unsigned long scalarMovements = 0;
+    const double scalar = bestOf(minSeconds, [&]() { scalarMovements = engine.runScalar(mice, 0, mice.size()); });
+    size_t mismatches = 0;
+    for(size_t i = 0; i < mice.size(); i++) {
+        mismatches += mice.steps[i] != steps[i] || mice.outcome[i] != outcomes[i];
+    }
+
+    // the same mice split between the threads.
+    std::vector<unsigned long> threadMovements(threads);
+    const double lockstep = bestOf(minSeconds, [&]() {
+        std::vector<std::thread> workers;
+        const size_t share = (mice.size() + threads - 1) / threads;
+        for(unsigned t = 0; t < threads; t++) {
+            const size_t first = t * share < mice.size() ? t * share : mice.size();
+            const size_t count = first + share < mice.size() ? share : mice.size() - first;
+            workers.push_back(std::thread([&, t, first, count]() { threadMovements[t] = engine.run(mice, first, count); }));
+        }
+        for(size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+    });
+    unsigned long lockstepMovements = 0;
+    for(unsigned t = 0; t < threads; t++) {
+        lockstepMovements += threadMovements[t];
+    }
+    for(size_t i = 0; i < mice.size(); i++) {
+        mismatches += mice.steps[i] != steps[i] || mice.outcome[i] != outcomes[i]
+                      || (outcomes[i] != Lockstep::CRASHED && (mice.x[i] != xs[i] || mice.y[i] != ys[i]));
+    }
+    mismatches += scalarMovements != movements || lockstepMovements != movements;
+
+    std::cout << LEN << "x" << LEN << ": " << mice.size() << " wall followers in " << builtIn << " built-in and "
+              << generated << " generated mazes (" << loops << " loops each), " << Lockstep::Engine<LEN>::instructionSet()
+              << ", " << threads << " thread" << (threads == 1 ? "" : "s") << std::endl;
+    std::cout << "maze  left hand        right hand" << std::endl;
+    for(unsigned m = 0; m < builtIn; m++) {
+        std::cout << std::setw(4) << m;
+        for(unsigned hand = 0; hand < 2; hand++) {
+            const size_t i = 2 * m + hand;
+            std::cout << std::setw(6) << mice.steps[i] << " " << std::left << std::setw(11)
+                      << Lockstep::outcomeName((Lockstep::Outcome)mice.outcome[i]) << std::right;
+        }
+        std::cout << std::endl;
+    }
+    unsigned long reached = 0;
+    for(size_t i = 2 * builtIn; i < mice.size(); i++) {
+        reached += mice.outcome[i] == Lockstep::AT_CENTER;
+    }
+    if(generated) {
+        std::cout << "generated: " << reached << " of " << 2 * generated << " followers reached the center, "
+                  << std::fixed << std::setprecision(1) << (double)movements / mice.size() << " movements per mouse" << std::endl;
+    }
+
+    std::cout << "              total (ms)  mouse-steps/s" << std::endl;
+    std::cout << "MouseSession " << std::fixed << std::setprecision(3) << std::setw(11) << session / 1e6
+              << std::setprecision(0) << std::setw(15) << movements / (session / 1e9) << std::endl;
+    std::cout << "table        " << std::fixed << std::setprecision(3) << std::setw(11) << scalar / 1e6
+              << std::setprecision(0) << std::setw(15) << movements / (scalar / 1e9)
+              << std::setprecision(2) << "  (" << session / scalar << "x)" << std::endl;
+    std::cout << "lockstep     " << std::fixed << std::setprecision(3) << std::setw(11) << lockstep / 1e6
+              << std::setprecision(0) << std::setw(15) << movements / (lockstep / 1e9)
+              << std::setprecision(2) << "  (" << session / lockstep << "x)" << std::endl;
+
+    if(mismatches) {
+        std::cout << "FAIL: " << mismatches << " mice ran differently in lockstep and through MouseSession" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned size = 16;
+    unsigned generated = 10000;
+    int loops = -1;
+    double minSeconds = 0.2;
+    unsigned threads = std::thread::hardware_concurrency();
+    threads = threads ? threads : 1;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            generated = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            minSeconds = atof(argv[++i]);
+        } else if(strcmp(argv[i], "-j") == 0 && i+1 < argc && atoi(argv[i+1]) > 0) {
+            threads = atoi(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-s 16|32] [-n N] [-l N] [-t SECONDS] [-j N]" << std::endl;
+            std::cout << "\t-s 16|32 will run the mice in mazes of this size (default 16)" << std::endl;
+            std::cout << "\t-n N will add N generated mazes to the built-in ones (default 10000)" << std::endl;
+            std::cout << "\t-l N will remove N extra walls of each generated maze to make loops (default 32 for 16x16, 128 for 32x32)" << std::endl;
+            std::cout << "\t-t SECONDS will repeat each run of the mice for at least this long and keep the best time (default 0.2)" << std::endl;
+            std::cout << "\t-j N will run the lockstep mice on N threads (default: one per hardware thread)" << std::endl;
+            return -1;
+        }
+    }
+
+    switch(size) {
+        case MazeDefinitions::MAZE_LEN:
+            return run<MazeDefinitions::MAZE_LEN>(generated, loops < 0 ? 2 * MazeDefinitions::MAZE_LEN : loops, minSeconds, threads);
+        case MazeDefinitions::HALF_SIZE_MAZE_LEN:
+            return run<MazeDefinitions::HALF_SIZE_MAZE_LEN>(generated, loops < 0 ? 4 * MazeDefinitions::HALF_SIZE_MAZE_LEN : loops, minSeconds, threads);
+        default:
+            std::cout << "Size must be " << MazeDefinitions::MAZE_LEN << " or " << MazeDefinitions::HALF_SIZE_MAZE_LEN << std::endl;
+            return -1;
+    }
+}
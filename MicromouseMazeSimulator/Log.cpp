@@ -0,0 +1,222 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Log.h"
+
+namespace Log {
+    namespace {
+        const unsigned RING_SIZE = 4096; // power of two
+        // the writer is woken once this many records are waiting, or after IDLE_WAIT.
+        const unsigned BATCH = RING_SIZE / 4;
+        const std::chrono::milliseconds IDLE_WAIT(10);
+        // longest line written, longer ones are cut.
+        const size_t MAX_LINE = 512;
+
+        struct Record {
+            std::atomic<uint64_t> sequence;
+            Level level;
+            const char *format;
+            unsigned argc;
+            Arg args[MAX_ARGS];
+        };
+
+        /**
+         * Bounded multi-producer, single-consumer ring. A slot is free for the producer that
+         * claimed position p when its sequence is p, and ready for the consumer when it is p+1.
+         */
+        class Sink {
+        public:
+            Sink() : head(0), tail(0), sleeping(false), stop(false) {
+                for(unsigned i = 0; i < RING_SIZE; i++) {
+                    ring[i].sequence.store(i, std::memory_order_relaxed);
+                }
+                worker = std::thread(&Sink::run, this);
+            }
+
+            ~Sink() {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    stop = true;
+                }
+                wake.notify_one();
+                worker.join();
+            }
+
+            void push(Level level, const char *format, const Arg *args, unsigned argc) {
+                uint64_t pos = tail.load(std::memory_order_relaxed);
+                Record *record;
+                for(;;) {
+                    record = &ring[pos % RING_SIZE];
+                    const uint64_t seq = record->sequence.load(std::memory_order_acquire);
+                    if(seq == pos) {
+                        if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if(seq < pos) {
+                        // full, let the writer catch up.
+                        notify();
+                        std::this_thread::yield();
+                        pos = tail.load(std::memory_order_relaxed);
+                    } else {
+                        pos = tail.load(std::memory_order_relaxed);
+                    }
+                }
+
+                record->level = level;
+                record->format = format;
+                record->argc = argc;
+                for(unsigned i = 0; i < argc; i++) {
+                    record->args[i] = args[i];
+                }
+                record->sequence.store(pos + 1, std::memory_order_release);
+
+                // wake the writer for whole batches only, a context switch per message is what made logging slow.
+                if(pos + 1 - head.load(std::memory_order_relaxed) >= BATCH) {
+                    notify();
+                }
+            }
+
+            void flush() {
+                const uint64_t target = tail.load(std::memory_order_acquire);
+                while(head.load(std::memory_order_acquire) < target) {
+                    notify();
+                    std::this_thread::yield();
+                }
+                fflush(stdout);
+            }
+
+        private:
+            void notify() {
+                if(sleeping.load(std::memory_order_acquire)) {
+                    { std::lock_guard<std::mutex> lock(mtx); }
+                    wake.notify_one();
+                }
+            }
+
+            bool ready() const {
+                const uint64_t pos = head.load(std::memory_order_relaxed);
+                return ring[pos % RING_SIZE].sequence.load(std::memory_order_acquire) == pos + 1;
+            }
+
+            void run() {
+                for(;;) {
+                    {
+                        std::unique_lock<std::mutex> lock(mtx);
+                        sleeping.store(true);
+                        if(!stop) {
+                            wake.wait_for(lock, IDLE_WAIT);
+                        }
+                        sleeping.store(false);
+                    }
+
+                    // format a whole batch into one buffer, a single write per batch.
+                    size_t n = 0;
+                    while(ready()) {
+                        const uint64_t pos = head.load(std::memory_order_relaxed);
+                        Record &record = ring[pos % RING_SIZE];
+                        if(n + MAX_LINE > sizeof(buffer)) {
+                            fwrite(buffer, 1, n, stdout);
+                            n = 0;
+                        }
+                        n += format(record, buffer + n);
+                        record.sequence.store(pos + RING_SIZE, std::memory_order_release);
+                        head.store(pos + 1, std::memory_order_release);
+                    }
+                    if(n) {
+                        fwrite(buffer, 1, n, stdout);
+                        fflush(stdout);
+                    }
+
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if(stop && !ready()) {
+                        return;
+                    }
+                }
+            }
+
+            static size_t append(char *out, size_t n, uint64_t value) {
+                char digits[20];
+                unsigned d = 0;
+                do {
+                    digits[d++] = '0' + value % 10;
+                    value /= 10;
+                } while(value);
+                while(d && n < MAX_LINE - 1) {
+                    out[n++] = digits[--d];
+                }
+                return n;
+            }
+
+            // replace each {} in the format with the next argument and end the line.
+            // Writes at most MAX_LINE characters, returns how many.
+            static size_t format(const Record &record, char *out) {
+                size_t n = 0;
+                unsigned next = 0;
+                for(const char *f = record.format; *f && n < MAX_LINE - 1; f++) {
+                    if(f[0] == '{' && f[1] == '}' && next < record.argc) {
+                        const Arg &a = record.args[next++];
+                        switch(a.type) {
+                            case Arg::SIGNED:
+                                if(a.i < 0) {
+                                    out[n++] = '-';
+                                    n = append(out, n, -(uint64_t)a.i);
+                                } else {
+                                    n = append(out, n, a.i);
+                                }
+                                break;
+                            case Arg::UNSIGNED:
+                                n = append(out, n, a.u);
+                                break;
+                            case Arg::DOUBLE: {
+                                const int len = snprintf(out + n, MAX_LINE - n, "%g", a.d);
+                                n = len > 0 && n + len < MAX_LINE ? n + len : MAX_LINE - 1;
+                                break;
+                            }
+                            case Arg::STRING:
+                                for(const char *c = a.s; *c && n < MAX_LINE - 1; c++) {
+                                    out[n++] = *c;
+                                }
+                                break;
+                            case Arg::NONE:
+                            default:
+                                break;
+                        }
+                        f++;
+                    } else {
+                        out[n++] = *f;
+                    }
+                }
+                out[n++] = '\n';
+                return n;
+            }
+
+            Record ring[RING_SIZE];
+            std::atomic<uint64_t> head;     // next record to write, owned by the writer thread
+            std::atomic<uint64_t> tail;     // next position to claim
+            std::atomic<bool> sleeping;     // the writer is waiting for the next batch
+            char buffer[1 << 16];           // formatted output of the writer thread
+            bool stop;
+            std::mutex mtx;
+            std::condition_variable wake;
+            std::thread worker;
+        };
+
+        // started on first use, flushed and joined at exit.
+        Sink &sink() {
+            static Sink instance;
+            return instance;
+        }
+    }
+
+    void push(Level level, const char *format, const Arg *args, unsigned argc) {
+        sink().push(level, format, args, argc);
+    }
+
+    void flush() {
+        sink().flush();
+    }
+}
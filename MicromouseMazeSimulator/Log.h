@@ -0,0 +1,94 @@
+#ifndef Log_h
+#define Log_h
+
+#include <stdint.h> // int64_t, uint64_t
+
+/**
+ * Debug logging that stays out of the way of the simulation.
+ *
+ * Levels are compile-time policies: anything above LOG_LEVEL (default LOG_LEVEL_DEBUG)
+ * is removed by the compiler, including the evaluation of its arguments.
+ * Build with e.g. -DLOG_LEVEL=LOG_LEVEL_INFO to drop all debug logging from the hot loops.
+ *
+ * Enabled messages are not formatted by the caller. The format string and up to
+ * MAX_ARGS arguments are copied into a lock-free ring buffer, and a background thread
+ * formats them and writes them to stdout. Placeholders are written as {}:
+ *
+ *     LOG_DEBUG(verbose, "curr=[{}][{}], old dis={}", cx, cy, curr->distance);
+ *
+ * The first macro argument is a runtime switch (e.g. the -v option) checked before anything else.
+ */
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_DEBUG 2
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+namespace Log {
+    enum Level {
+        ERROR = LOG_LEVEL_ERROR,
+        INFO = LOG_LEVEL_INFO,
+        DEBUG = LOG_LEVEL_DEBUG
+    };
+
+    // compile-time policy: is level L compiled in?
+    template <Level L>
+    struct Policy {
+        static const bool enabled = L <= LOG_LEVEL;
+    };
+
+    static const unsigned MAX_ARGS = 6;
+
+    // a single argument, copied as is and formatted by the background thread.
+    struct Arg {
+        enum Type { NONE, SIGNED, UNSIGNED, DOUBLE, STRING } type;
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+            const char *s;  // must outlive the log, i.e. string literals
+        };
+    };
+
+    inline Arg arg(int v)                { Arg a; a.type = Arg::SIGNED;   a.i = v; return a; }
+    inline Arg arg(long v)               { Arg a; a.type = Arg::SIGNED;   a.i = v; return a; }
+    inline Arg arg(long long v)          { Arg a; a.type = Arg::SIGNED;   a.i = v; return a; }
+    inline Arg arg(unsigned v)           { Arg a; a.type = Arg::UNSIGNED; a.u = v; return a; }
+    inline Arg arg(unsigned long v)      { Arg a; a.type = Arg::UNSIGNED; a.u = v; return a; }
+    inline Arg arg(unsigned long long v) { Arg a; a.type = Arg::UNSIGNED; a.u = v; return a; }
+    inline Arg arg(bool v)               { Arg a; a.type = Arg::UNSIGNED; a.u = v; return a; }
+    inline Arg arg(double v)             { Arg a; a.type = Arg::DOUBLE;   a.d = v; return a; }
+    inline Arg arg(const char *v)        { Arg a; a.type = Arg::STRING;   a.s = v; return a; }
+
+    // queue a message for the background thread. Waits (never drops) if the ring is full.
+    void push(Level level, const char *format, const Arg *args, unsigned argc);
+
+    // wait until everything queued so far has been written.
+    void flush();
+
+    inline void write(Level level, const char *format) {
+        push(level, format, 0, 0);
+    }
+
+    template <typename... Args>
+    inline void write(Level level, const char *format, Args... values) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+        const Arg args[] = { arg(values)... };
+        push(level, format, args, sizeof...(Args));
+    }
+}
+
+#define LOG_AT(level, on, ...) \
+    do { \
+        if(Log::Policy<level>::enabled && (on)) \
+            Log::write(level, __VA_ARGS__); \
+    } while(0)
+
+#define LOG_ERROR(on, ...) LOG_AT(Log::ERROR, on, __VA_ARGS__)
+#define LOG_INFO(on, ...)  LOG_AT(Log::INFO, on, __VA_ARGS__)
+#define LOG_DEBUG(on, ...) LOG_AT(Log::DEBUG, on, __VA_ARGS__)
+
+#endif
@@ -1,8 +1,30 @@
 #ifndef MazeDefinitions_h
 #define MazeDefinitions_h
 
+#include <stdint.h> // uint8_t, uint16_t
+#include <type_traits> // std::conditional
+
 namespace MazeDefinitions {
+    // classic maze
     const unsigned MAZE_LEN = 16;
+    // half-size maze
+    const unsigned HALF_SIZE_MAZE_LEN = 32;
+
+    /**
+     * Types and constants of a LEN x LEN maze.
+     * Index numbers the cells (x * LEN + y) and is the smallest type that fits: uint8_t for 16x16, uint16_t for 32x32.
+     * Distance holds any path length in the maze, a walk through every cell plus a Manhattan distance.
+     */
+    template <unsigned LEN>
+    struct Size {
+        static_assert(LEN >= 2 && LEN <= 32, "walls are stored in one 32 bit word per column");
+
+        static const unsigned CELLS = LEN * LEN;
+        static const unsigned MAX_DISTANCE = CELLS + 2 * LEN;
+
+        typedef typename std::conditional<CELLS <= 256, uint8_t, uint16_t>::type Index;
+        typedef uint16_t Distance;
+    };
 
     enum MazeEncodingName {
         MAZE_CAMM_2012 = 0,
@@ -19,6 +41,14 @@ namespace MazeDefinitions {
         MAZE_NAME_MAX
     };
 
+    enum HalfSizeMazeEncodingName {
+        HALF_SIZE_GENERATED_0 = 0,
+        HALF_SIZE_GENERATED_1,
+        HALF_SIZE_GENERATED_2,
+
+        HALF_SIZE_MAZE_NAME_MAX
+    };
+
     /**
      * Encodings of various old mazes
      * Each entry is a cell and what walls surround it,
@@ -226,6 +256,146 @@ namespace MazeDefinitions {
             {6,10,10,10,10,10,10,10,10,10,10,10,10,10,2,3}
         },
     };
+
+    /**
+     * Half-size mazes, same encoding as above.
+     * Generated (depth first, with a few walls removed afterwards to make loops) since
+     * there are no half-size contest mazes in this format yet. Each has a single entrance
+     * into the center and the usual start cell, open to the north only.
+     */
+    static const unsigned char halfSizeMazes[][HALF_SIZE_MAZE_LEN][HALF_SIZE_MAZE_LEN] = {
+        // Generated 0 (seed 1, 20 loops)
+        {
+            {14,10,9,14,9,12,9,12,10,8,10,9,12,10,10,9,14,8,10,8,10,10,10,10,9,14,8,9,14,8,9,13},
+            {12,11,6,9,5,5,6,3,12,3,13,6,3,12,9,6,9,4,11,6,8,10,10,9,6,10,3,5,12,3,5,5},
+            {6,9,12,3,5,5,12,10,3,12,0,10,10,3,6,11,6,1,12,9,5,12,9,6,10,10,9,5,5,13,4,1},
+            {12,3,5,12,3,5,5,14,10,1,6,10,10,10,10,8,11,6,3,5,6,3,6,8,8,9,5,6,3,5,5,5},
+            {4,10,3,4,10,3,5,12,9,6,10,10,9,12,10,3,12,10,9,6,10,10,9,5,5,5,6,9,12,2,3,5},
+            {5,14,9,6,9,13,5,5,6,8,9,12,3,6,8,10,2,11,4,9,14,9,5,5,5,6,10,3,6,10,10,1},
+            {6,9,5,12,3,5,6,3,12,1,4,3,12,9,6,10,11,12,3,6,10,3,6,3,5,12,9,12,10,10,9,5},
+            {12,3,4,3,12,2,10,9,5,6,1,12,3,5,12,10,9,5,12,9,12,10,10,9,4,3,5,6,9,12,3,5},
+            {5,14,2,9,5,12,9,7,4,9,7,5,13,5,5,13,5,4,3,5,5,12,10,3,5,13,6,10,3,6,10,3},
+            {5,12,9,6,3,5,6,9,7,6,10,2,3,5,5,5,5,7,12,3,4,2,10,9,5,4,10,9,12,10,8,9},
+            {6,3,6,10,10,3,13,5,12,9,12,10,10,3,6,1,5,12,3,12,3,12,9,6,3,5,13,6,3,12,3,7},
+            {12,10,9,12,8,10,3,6,3,5,5,12,9,12,10,3,5,6,10,2,9,5,6,10,9,6,3,12,10,3,12,9},
+            {5,13,6,3,6,10,8,9,13,5,6,3,6,1,12,9,6,10,9,13,6,3,12,9,6,10,9,6,8,10,3,5},
+            {6,2,8,8,10,9,5,6,3,6,9,12,9,5,5,5,12,9,5,5,12,10,3,4,9,13,6,9,7,12,9,5},
+            {12,10,3,5,12,3,6,8,10,9,6,3,5,7,5,6,3,6,3,5,5,12,9,5,5,4,11,6,9,5,5,5},
+            {5,12,9,5,5,12,10,2,9,6,8,9,6,9,4,8,9,12,11,4,2,1,6,3,6,3,12,8,0,3,6,1},
+            {5,5,6,3,4,3,12,9,5,12,3,6,11,5,5,6,3,4,10,3,13,6,10,9,12,10,3,6,2,10,9,5},
+            {5,7,12,9,6,9,4,2,1,5,12,10,9,5,6,9,13,5,12,10,2,10,9,6,3,12,11,12,10,9,5,5},
+            {5,12,3,6,9,5,5,12,3,6,3,13,5,6,10,3,4,3,6,8,11,12,0,11,12,2,10,3,12,1,6,3},
+            {6,3,12,11,5,7,5,6,10,9,12,1,4,10,10,9,5,14,10,1,12,3,7,12,3,12,10,11,5,6,9,13},
+            {12,10,2,9,6,10,3,13,12,3,5,5,6,9,14,3,6,10,9,5,6,10,10,3,12,3,12,10,3,12,3,5},
+            {7,12,10,1,13,12,8,3,5,12,3,6,11,6,10,8,9,12,3,5,12,10,10,9,5,12,3,12,10,2,10,1},
+            {12,3,13,5,5,5,6,10,3,4,10,10,8,8,9,4,3,5,13,6,3,12,11,4,3,6,9,7,12,9,13,5},
+            {5,13,4,3,5,6,10,9,14,1,13,12,3,5,5,6,10,3,5,12,10,2,9,5,12,9,5,12,3,5,5,5},
+            {5,5,5,14,0,8,11,6,9,6,3,5,13,6,1,12,8,9,4,2,11,12,3,5,5,6,3,5,13,5,4,3},
+            {5,5,6,9,5,7,12,9,6,10,10,3,6,9,5,7,5,5,7,12,9,5,12,3,5,12,8,3,5,5,5,13},
+            {5,6,8,3,4,8,1,5,12,8,10,10,10,1,4,8,3,6,10,3,5,5,5,13,6,3,4,10,3,5,6,3},
+            {4,9,6,9,7,6,3,5,5,5,12,10,9,7,5,6,10,9,14,9,5,4,3,4,10,8,3,12,9,4,10,9},
+            {5,6,9,6,10,10,10,1,5,5,4,11,6,9,5,12,9,6,9,4,3,6,9,6,9,5,12,3,5,6,11,5},
+            {5,12,3,12,10,9,12,1,5,4,3,12,9,5,5,5,6,9,5,5,14,10,2,10,3,7,5,13,5,12,10,1},
+            {5,6,10,3,13,6,1,7,6,2,9,5,6,3,5,5,13,5,5,5,12,9,12,9,12,10,3,4,3,5,12,3},
+            {6,10,10,10,2,11,6,10,10,10,3,6,10,10,2,3,6,2,3,6,3,6,3,6,3,14,10,2,10,3,6,11}
+        },
+
+        // Generated 1 (seed 2, 60 loops)
+        {
+            {14,10,10,9,12,9,12,10,9,13,12,8,9,14,10,8,10,9,14,8,8,9,14,8,10,10,10,10,10,10,9,13},
+            {12,8,11,6,3,6,3,13,5,6,3,4,2,9,12,3,14,2,9,5,5,6,10,3,12,10,10,9,14,8,3,5},
+            {5,6,8,11,12,10,9,4,3,12,9,5,12,3,4,10,9,13,5,5,6,9,12,9,5,14,9,6,8,0,10,3},
+            {4,10,3,12,3,13,5,5,12,1,6,3,4,10,2,11,5,6,0,2,11,5,5,6,3,12,1,13,6,2,10,9},
+            {6,9,12,3,14,1,6,3,7,4,9,13,5,12,10,9,6,9,4,10,10,3,5,12,10,1,6,2,10,9,12,3},
+            {12,1,5,12,10,2,10,10,9,7,5,4,3,4,9,5,12,1,7,12,8,9,5,4,11,5,12,9,13,5,6,9},
+            {5,5,6,3,12,9,12,9,6,10,3,5,12,3,5,6,3,5,12,3,4,1,6,1,12,3,5,5,5,4,11,5},
+            {5,6,10,9,5,5,5,5,13,12,10,3,5,12,2,10,10,2,1,14,1,4,10,3,6,10,1,5,4,3,12,3},
+            {5,12,9,4,3,6,3,6,1,5,12,8,1,5,12,8,8,9,5,12,1,6,8,8,8,9,6,1,6,9,6,9},
+            {5,5,5,6,8,10,10,9,7,6,1,5,4,3,5,6,3,6,3,5,6,10,1,5,4,2,8,3,13,5,13,5},
+            {5,5,6,8,2,11,12,1,12,9,4,3,5,12,3,14,8,10,10,3,12,10,1,5,6,10,1,14,2,2,3,5},
+            {4,3,12,2,10,8,1,5,5,6,3,12,2,3,14,8,3,14,8,9,4,9,5,6,9,12,3,12,10,10,9,5},
+            {5,13,6,9,13,6,1,5,4,8,9,6,8,10,10,3,12,9,7,6,3,4,3,12,3,5,13,5,14,10,2,1},
+            {6,2,9,5,4,10,1,5,5,7,4,11,5,12,9,12,3,6,10,10,9,6,9,4,8,3,5,6,10,9,12,1},
+            {12,9,7,5,6,11,6,3,6,9,4,10,3,5,6,1,14,8,10,11,5,14,2,1,6,8,2,10,11,4,1,5},
+            {5,6,9,5,12,10,10,8,11,4,3,12,10,3,13,4,9,4,10,9,6,10,9,5,12,3,12,10,9,6,3,5},
+            {6,9,4,1,6,10,9,6,9,6,10,3,12,10,1,6,3,6,8,2,10,10,1,4,2,11,5,12,3,12,10,1},
+            {12,3,5,4,10,9,6,9,5,12,10,10,3,13,5,12,10,9,6,10,9,13,4,3,12,10,2,2,9,5,12,3},
+            {5,14,0,3,14,2,11,5,5,5,12,10,10,3,5,5,13,6,10,10,1,5,4,9,5,14,10,9,6,2,2,9},
+            {4,9,7,12,10,10,10,1,6,2,3,12,10,10,1,6,2,10,8,10,1,5,4,2,1,12,9,4,8,8,11,5},
+            {7,6,9,4,9,12,10,0,8,10,10,3,12,8,2,9,14,9,4,9,5,5,5,12,3,5,5,5,5,5,12,3},
+            {12,10,2,3,5,5,14,3,4,8,10,9,5,5,13,6,9,6,3,5,5,5,5,5,12,3,5,5,5,7,6,9},
+            {6,8,8,10,3,4,10,10,3,4,9,6,3,5,4,8,2,10,10,1,5,5,5,6,2,11,5,5,6,10,9,5},
+            {12,3,6,10,9,6,8,10,9,5,4,11,12,3,5,4,8,11,12,2,1,6,2,8,9,12,3,6,10,9,6,3},
+            {4,10,9,12,3,12,3,13,6,1,7,12,3,13,4,1,7,12,3,13,6,9,13,5,5,5,13,12,9,6,10,9},
+            {5,12,3,6,9,5,12,2,9,5,12,3,14,2,3,6,8,2,10,1,12,3,5,6,0,1,5,5,6,10,10,3},
+            {5,5,12,10,2,1,5,14,3,5,6,9,12,10,10,9,4,10,10,2,2,9,6,10,1,5,6,2,10,10,10,9},
+            {5,5,6,10,10,3,4,10,9,5,12,1,6,9,13,5,5,12,9,12,10,3,12,9,5,5,12,10,10,8,9,5},
+            {5,4,11,12,10,9,6,9,5,5,5,7,12,3,5,6,2,1,6,3,12,10,1,5,7,6,2,10,9,5,4,3},
+            {5,6,10,3,13,4,11,5,6,3,6,9,6,9,6,10,10,2,8,9,7,12,3,6,10,10,10,9,5,5,5,13},
+            {6,9,12,8,1,6,10,3,12,10,10,3,12,3,12,10,10,9,5,6,10,3,12,9,12,9,12,3,7,5,4,1},
+            {14,2,2,3,6,10,10,11,6,10,10,10,2,10,3,14,10,2,3,14,10,10,3,6,3,6,2,10,10,3,6,3}
+        },
+
+        // Generated 2 (seed 3, 120 loops)
+        {
+            {14,10,9,12,10,10,8,10,8,8,11,12,8,10,10,8,10,10,8,8,10,8,8,9,12,10,10,8,8,10,10,9},
+            {12,9,5,5,12,10,2,9,7,4,10,3,5,12,10,2,9,13,4,2,10,2,1,5,4,9,14,0,2,10,10,3},
+            {5,6,3,7,4,10,9,6,8,1,12,8,2,2,11,12,3,5,6,9,12,10,3,6,1,6,9,5,14,8,10,9},
+            {5,14,8,9,7,12,2,8,3,7,5,6,10,8,8,3,12,0,9,5,4,8,9,14,2,9,5,6,10,3,13,5},
+            {6,10,2,2,10,3,13,5,14,8,3,12,11,6,3,14,1,4,3,4,1,4,3,12,9,4,3,12,10,8,2,1},
+            {14,10,10,8,10,9,4,1,12,1,12,0,10,8,10,10,1,5,14,1,5,4,10,2,1,5,12,3,12,2,9,5},
+            {12,10,10,3,13,5,5,6,1,4,1,6,9,6,9,12,1,6,10,1,5,6,9,13,5,5,6,9,6,9,5,7},
+            {4,10,9,12,2,3,5,12,2,2,1,12,3,13,5,5,4,10,10,1,5,13,6,1,5,4,11,5,12,1,6,9},
+            {5,12,0,3,12,8,3,6,8,9,5,4,8,2,1,5,7,12,10,3,4,0,9,5,5,7,12,1,4,0,8,1},
+            {6,1,6,9,6,2,10,9,7,4,0,2,3,12,3,6,10,2,10,9,5,5,6,1,6,10,3,6,3,4,3,5},
+            {12,3,12,0,9,12,11,6,9,5,4,8,10,0,8,8,10,10,9,7,5,5,14,0,10,10,10,10,8,3,12,1},
+            {6,11,4,0,2,2,8,9,5,5,7,4,10,1,5,4,8,9,6,10,3,6,9,6,10,10,8,10,3,12,3,7},
+            {12,10,3,7,12,9,5,6,3,6,9,4,8,2,1,7,5,6,9,12,10,8,2,10,10,9,6,9,12,1,12,9},
+            {6,10,9,12,3,5,5,12,10,10,2,1,6,9,6,10,3,13,6,3,13,5,12,8,9,4,9,5,5,4,3,5},
+            {12,8,1,5,13,6,2,0,8,10,10,2,9,5,14,10,10,2,9,12,2,3,5,5,6,3,5,5,5,5,12,3},
+            {5,6,1,5,4,10,8,1,6,10,10,10,1,6,9,12,8,8,3,5,12,10,2,3,12,10,1,5,6,3,6,9},
+            {5,12,3,5,5,12,3,6,8,10,10,9,5,12,3,6,3,5,12,2,0,9,12,8,2,10,0,1,12,8,8,3},
+            {5,5,13,6,2,2,9,12,1,12,8,1,4,1,12,8,9,4,3,12,1,5,5,6,10,9,5,4,3,5,6,9},
+            {5,6,2,8,10,11,5,5,7,5,6,2,3,6,1,5,5,6,10,3,5,5,5,12,9,6,3,6,9,6,10,1},
+            {5,14,8,0,8,10,3,5,12,2,8,9,12,10,2,1,6,8,8,9,5,4,2,3,7,12,10,9,6,9,13,5},
+            {5,12,0,3,6,9,14,0,2,8,3,7,4,10,9,4,8,3,5,4,3,4,8,9,12,3,12,3,12,2,2,3},
+            {4,3,6,10,9,6,8,1,14,3,12,9,4,11,5,5,4,10,3,4,8,3,5,6,2,9,6,9,5,12,10,9},
+            {6,10,8,8,1,13,4,3,12,9,5,5,7,12,1,6,1,12,9,6,1,12,3,13,12,1,12,3,6,3,12,1},
+            {13,12,3,5,6,1,6,10,3,5,5,6,10,3,4,11,5,5,5,12,3,5,14,1,5,6,3,14,8,8,1,5},
+            {4,2,11,5,13,5,12,8,9,5,4,8,8,11,4,10,1,5,7,6,8,2,8,1,6,10,10,10,2,2,1,5},
+            {5,12,10,3,4,3,6,1,6,3,5,5,4,8,3,14,0,1,12,10,3,12,3,4,10,10,9,12,10,8,1,5},
+            {5,6,9,13,6,8,9,6,10,10,1,5,6,2,10,8,3,6,1,12,10,3,12,1,12,8,3,6,8,1,6,3},
+            {7,12,1,4,10,3,4,8,9,12,3,6,9,12,9,6,10,9,7,5,12,10,3,4,3,5,12,10,0,3,14,9},
+            {12,3,5,4,9,12,3,5,5,6,10,8,0,3,5,12,9,5,12,3,6,9,14,0,8,1,5,14,0,10,10,1},
+            {4,9,7,5,5,5,12,1,4,11,12,3,7,12,3,5,5,4,3,12,10,0,10,3,5,5,4,9,4,9,14,1},
+            {5,5,12,1,4,3,5,5,6,8,2,9,12,3,13,5,4,3,12,3,12,0,10,10,1,7,4,1,7,6,9,5},
+            {6,2,2,2,2,10,3,6,11,6,10,2,2,10,2,3,6,10,2,10,3,6,10,10,2,10,2,2,10,10,3,7}
+        }
+    };
+
+    /**
+     * The mazes of a size: Encodings<LEN>::COUNT of them, Encodings<LEN>::get(i)[col][row].
+     */
+    template <unsigned LEN>
+    struct Encodings;
+
+    template <>
+    struct Encodings<MAZE_LEN> {
+        static const unsigned COUNT = MAZE_NAME_MAX;
+
+        static const unsigned char (*get(unsigned index))[MAZE_LEN] {
+            return mazes[index];
+        }
+    };
+
+    template <>
+    struct Encodings<HALF_SIZE_MAZE_LEN> {
+        static const unsigned COUNT = HALF_SIZE_MAZE_NAME_MAX;
+
+        static const unsigned char (*get(unsigned index))[HALF_SIZE_MAZE_LEN] {
+            return halfSizeMazes[index];
+        }
+    };
 }
 
 #endif
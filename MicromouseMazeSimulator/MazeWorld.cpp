@@ -0,0 +1,148 @@
+#include <vector>
+#include <fstream>
+#include "MazeWorld.h"
+#include "PerfCounters.h"
+
+template <unsigned LEN>
+BasicMazeWorld<LEN>::BasicMazeWorld(unsigned name) {
+    const unsigned mazeIndex = (name < MazeDefinitions::Encodings<LEN>::COUNT) ? name : 0;
+    mazeName = mazeIndex;
+    decode(MazeDefinitions::Encodings<LEN>::get(mazeIndex));
+}
+
+template <unsigned LEN>
+BasicMazeWorld<LEN>::BasicMazeWorld(const unsigned char (*encoding)[LEN], unsigned name) {
+    mazeName = name;
+    decode(encoding);
+}
+
+template <unsigned LEN>
+void BasicMazeWorld<LEN>::decode(const unsigned char (*encoding)[LEN]) {
+    wallNS.clearAll();
+    wallEW.clearAll();
+
+    // Encoding stores wall/no wall in WSEN in the least significant bits
+    // Data is stored in column major order
+    const unsigned westMask  = 1 << 3;
+    const unsigned southMask = 1 << 2;
+    const unsigned eastMask  = 1 << 1;
+    const unsigned northMask = 1 << 0;
+
+    for(unsigned col = 0; col < LEN; col++) {
+        for(unsigned row = 0; row < LEN; row++) {
+            const unsigned char cell = encoding[col][row];
+
+            if((cell & northMask) == 0 && row != LEN - 1) {
+                setOpen(col, row, NORTH);
+            }
+
+            if((cell & southMask) == 0 && row != 0) {
+                setOpen(col, row, SOUTH);
+            }
+
+            if((cell & westMask) == 0 && col != 0) {
+                setOpen(col, row, WEST);
+            }
+
+            if((cell & eastMask) == 0 && col != LEN - 1) {
+                setOpen(col, row, EAST);
+            }
+        }
+    }
+}
+
+template <unsigned LEN>
+const BasicMazeWorld<LEN> &BasicMazeWorld<LEN>::get(unsigned name) {
+    // the initialization of a local static runs once, the first caller decodes and the others wait.
+    static const std::vector<BasicMazeWorld> worlds = []() {
+        std::vector<BasicMazeWorld> all;
+        for(unsigned i = 0; i < MazeDefinitions::Encodings<LEN>::COUNT; i++) {
+            all.push_back(BasicMazeWorld(i));
+        }
+        return all;
+    }();
+    return worlds[name < worlds.size() ? name : 0];
+}
+
+template <unsigned LEN>
+bool BasicMazeWorld<LEN>::isOpen(unsigned x, unsigned y, Dir d) const {
+    PERF_SCOPE("MazeWorld::isOpen");
+
+    switch(d) {
+        case NORTH:
+            return wallNS.get(x, y+1);
+        case SOUTH:
+            return wallNS.get(x, y);
+        case EAST:
+            return wallEW.get(x+1, y);
+        case WEST:
+            return wallEW.get(x, y);
+        case INVALID:
+        default:
+            return false;
+    }
+}
+
+template <unsigned LEN>
+void BasicMazeWorld<LEN>::setOpen(unsigned x, unsigned y, Dir d) {
+    switch(d) {
+        case NORTH:
+            return wallNS.set(x, y+1);
+        case SOUTH:
+            return wallNS.set(x, y);
+        case EAST:
+            return wallEW.set(x+1, y);
+        case WEST:
+            return wallEW.set(x, y);
+        case INVALID:
+        default:
+            return;
+    }
+}
+
+template <unsigned LEN>
+void BasicMazeWorld<LEN>::encode(unsigned char (*encoding)[LEN]) const {
+    for(unsigned col = 0; col < LEN; col++) {
+        for(unsigned row = 0; row < LEN; row++) {
+            encoding[col][row] = (!isOpen(col, row, NORTH)) | (!isOpen(col, row, EAST) << 1) |
+                                 (!isOpen(col, row, SOUTH) << 2) | (!isOpen(col, row, WEST) << 3);
+        }
+    }
+}
+
+template <unsigned LEN>
+bool BasicMazeWorld<LEN>::load(const char *path, unsigned char (*encoding)[LEN]) {
+    std::ifstream in(path, std::ios::binary);
+    in.read((char *)&encoding[0][0], LEN * LEN);
+    // exactly LEN x LEN bytes.
+    return in.gcount() == LEN * LEN && in.peek() == std::ifstream::traits_type::eof();
+}
+
+template <unsigned LEN>
+bool BasicMazeWorld<LEN>::save(const char *path) const {
+    unsigned char encoding[LEN][LEN];
+    encode(encoding);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&encoding[0][0], LEN * LEN);
+    return out.good();
+}
+
+template <unsigned LEN>
+uint64_t BasicMazeWorld<LEN>::getCanonicalHash(bool &mirrored) const {
+    // FNV-1a over the north and east walls of every cell, column by column. In the mirror
+    // image cell (x,y) is cell (y,x) with its north and east walls swapped.
+    const uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull ^ LEN;
+    uint64_t mirror = hash;
+    for(unsigned x = 0; x < LEN; x++) {
+        for(unsigned y = 0; y < LEN; y++) {
+            hash = (hash ^ (isOpen(x, y, NORTH) | isOpen(x, y, EAST) << 1)) * prime;
+            mirror = (mirror ^ (isOpen(y, x, EAST) | isOpen(y, x, NORTH) << 1)) * prime;
+        }
+    }
+    mirrored = mirror < hash;
+    return mirrored ? mirror : hash;
+}
+
+template class BasicMazeWorld<MazeDefinitions::MAZE_LEN>;
+template class BasicMazeWorld<MazeDefinitions::HALF_SIZE_MAZE_LEN>;
@@ -0,0 +1,88 @@
+#ifndef MazeWorld_h
+#define MazeWorld_h
+
+#include <stdint.h> // uint64_t
+
+#include "BitVector256.h"
+#include "MazeDefinitions.h"
+#include "Dir.h"
+
+/**
+ * The walls of a LEN x LEN maze, and nothing else.
+ *
+ * A world never changes once constructed, so any number of mouse sessions (see MouseSession.h),
+ * on any number of threads, can run against the same one without copying or locking.
+ * The member functions are instantiated for 16x16 (MazeWorld) and 32x32 (HalfSizeMazeWorld) in MazeWorld.cpp.
+ */
+template <unsigned LEN>
+class BasicMazeWorld {
+public:
+    /**
+     * Decode a built-in maze. Prefer get, which decodes each maze once.
+     * @param name: maze to load, see MazeDefinitions::Encodings<LEN>. The first one if out of range.
+     */
+    explicit BasicMazeWorld(unsigned name);
+
+    /**
+     * A maze that is not built in, e.g. loaded from a file (see load) or generated.
+     * @param encoding: walls of every cell, column major, in the format of MazeDefinitions (1 north, 2 east, 4 south, 8 west)
+     * @param name: number to report the maze by. LOADED by default, past the built-in mazes.
+     */
+    explicit BasicMazeWorld(const unsigned char (*encoding)[LEN], unsigned name = LOADED);
+
+    // name of mazes that are not built in.
+    static const unsigned LOADED = MazeDefinitions::Encodings<LEN>::COUNT;
+
+    /**
+     * Read a maze file: LEN x LEN bytes in the order and format of the encodings, which is the
+     * .maz format of the classic 16x16 mazes.
+     * @param path: file to read
+     * @param encoding: set to the walls read
+     * @return false if the file cannot be read or is not LEN x LEN bytes
+     */
+    static bool load(const char *path, unsigned char (*encoding)[LEN]);
+
+    /**
+     * Write the maze to a file that load reads back.
+     * @return false if the file cannot be written
+     */
+    bool save(const char *path) const;
+
+    // the walls of every cell in the format of MazeDefinitions.
+    void encode(unsigned char (*encoding)[LEN]) const;
+
+    /**
+     * The built-in maze name, decoded the first time it is asked for and shared from then on.
+     * Safe to call from any thread.
+     * @param name: maze to load, see MazeDefinitions::Encodings<LEN>. The first one if out of range.
+     */
+    static const BasicMazeWorld &get(unsigned name);
+
+    // index into MazeDefinitions::Encodings<LEN>
+    inline unsigned getName() const {
+        return mazeName;
+    }
+
+    bool isOpen(unsigned x, unsigned y, Dir d) const;
+
+    /**
+     * Hash of the walls that is the same for the maze and for its mirror image across the
+     * start diagonal (x and y swapped): the smaller of the hashes of the two.
+     * @param mirrored: set when the hash is the one of the mirror image
+     * @return canonical hash of the walls
+     */
+    uint64_t getCanonicalHash(bool &mirrored) const;
+
+protected:
+    void setOpen(unsigned x, unsigned y, Dir d);
+    void decode(const unsigned char (*encoding)[LEN]);
+
+    unsigned mazeName;
+    BitVector<LEN> wallNS;
+    BitVector<LEN> wallEW;
+};
+
+typedef BasicMazeWorld<MazeDefinitions::MAZE_LEN> MazeWorld;
+typedef BasicMazeWorld<MazeDefinitions::HALF_SIZE_MAZE_LEN> HalfSizeMazeWorld;
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MouseMovement_h
+#define MouseMovement_h
+
+/**
+ * What a PathFinder tells the mouse to do. On its own so the freestanding FloodFill
+ * (make embedded) can use it without the rest of the simulator.
+ */
+enum MouseMovement {
+    MoveForward,            // Move in the direction mouse is facing
+    MoveBackward,           // Move opposite of the direction mouse is facing
+    TurnClockwise,          // Self explanatory
+    TurnCounterClockwise,   // Self explanatory
+    TurnAround,             // Face the opposite direction currently facing
+    Wait,                   // Do nothing this time, do some computation, then try again later
+    Finish                  // Mouse has achieved goals and is ending the simulation
+};
+
+inline const char *movementName(MouseMovement m) {
+    switch(m) {
+        case MoveForward:
+            return "MoveForward";
+        case MoveBackward:
+            return "MoveBackward";
+        case TurnClockwise:
+            return "TurnClockwise";
+        case TurnCounterClockwise:
+            return "TurnCounterClockwise";
+        case TurnAround:
+            return "TurnAround";
+        case Wait:
+            return "Wait";
+        case Finish:
+        default:
+            return "Finish";
+    }
+}
+
+#endif
@@ -0,0 +1,459 @@
+#include <iostream>
+#include <algorithm> // std::fill
+#include "MouseSession.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "AllocStats.h"
+#include "Replay.h"
+#include "LiveView.h"
+
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof(*a))
+
+template <unsigned LEN>
+BasicMouseSession<LEN>::BasicMouseSession(const BasicMazeWorld<LEN> &world, BasicPathFinder<LEN> *pathFinder)
+: world(world), heading(NORTH), pathFinder(pathFinder), mouseX(0), mouseY(0),
+  timeBudget(0), overrunCount(0), maxCallTime(0), recorder(NULL), publisher(NULL), outcome(RUN_IN_PROGRESS), stepLimit(0), runTimeLimit(0),
+  runStarted(false), seenCount(0), loopStart(0) {
+    sensorRange.front = 0;
+    sensorRange.side = 0;
+    for(unsigned m = 0; m < ARRAY_SIZE(movementCount); m++) {
+        movementCount[m] = 0;
+    }
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::moveForward() {
+    if(! isOpen(mouseX, mouseY, heading)) {
+        throw "Mouse crashed!";
+    }
+
+    switch(heading) {
+        case NORTH:
+            mouseY++;
+            break;
+        case SOUTH:
+            mouseY--;
+            break;
+        case EAST:
+            mouseX++;
+            break;
+        case WEST:
+            mouseX--;
+            break;
+        case INVALID:
+        default:
+            break;
+    }
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::moveBackward() {
+    Dir oldHeading = heading;
+    heading = opposite(heading);
+    moveForward();
+    heading = oldHeading;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::setSensorRange(SensorRange range) {
+    sensorRange.front = range.front < LEN ? range.front : LEN - 1;
+    sensorRange.side = range.side < LEN ? range.side : LEN - 1;
+}
+
+template <unsigned LEN>
+unsigned BasicMouseSession<LEN>::sense(WallObservation *out) const {
+    const Dir left = counterClockwise(heading);
+    const Dir right = clockwise(heading);
+    const unsigned reach = sensorRange.front > sensorRange.side ? sensorRange.front : sensorRange.side;
+    unsigned x = mouseX;
+    unsigned y = mouseY;
+    unsigned n = 0;
+    for(unsigned k = 0; ; k++) {
+        const bool open = isOpen(x, y, heading);
+        if(k <= sensorRange.front) {
+            const WallObservation front = {x, y, heading, !open};
+            out[n++] = front;
+        }
+        if(k <= sensorRange.side) {
+            const WallObservation onLeft = {x, y, left, !isOpen(x, y, left)};
+            const WallObservation onRight = {x, y, right, !isOpen(x, y, right)};
+            out[n++] = onLeft;
+            out[n++] = onRight;
+        }
+        if(k == reach || !open) {
+            break;
+        }
+        x += heading == EAST ? 1 : heading == WEST ? -1 : 0;
+        y += heading == NORTH ? 1 : heading == SOUTH ? -1 : 0;
+    }
+    return n;
+}
+
+template <unsigned LEN>
+MouseMovement BasicMouseSession<LEN>::callPathFinder() {
+    Trace::Span span("nextMovement", "Maze", mouseX, mouseY);
+
+    if(timeBudget.count() == 0) {
+        return pathFinder->nextMovement(mouseX, mouseY, *this);
+    }
+
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    pathFinder->setDeadline(begin + timeBudget);
+    const MouseMovement movement = pathFinder->nextMovement(mouseX, mouseY, *this);
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - begin;
+
+    if(elapsed > timeBudget) {
+        overrunCount++;
+    }
+    if(elapsed > maxCallTime) {
+        maxCallTime = elapsed;
+    }
+
+    return movement;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::start() {
+    if(!pathFinder) {
+        return;
+    }
+
+    ALLOC_GROUP("Maze::start");
+
+    while(step()) {
+    }
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::setLoopDetection(bool on) {
+    seenStates.clear();
+    seenCount = 0;
+    if(!on) {
+        seenStates.shrink_to_fit();
+        return;
+    }
+    // twice the states that can be noted, so probes stay short.
+    const unsigned long states = stepLimit ? stepLimit : 64ul * LEN * LEN;
+    size_t size = 64;
+    while(size < 2 * states) {
+        size *= 2;
+    }
+    const SeenState free = {0, 0};
+    seenStates.assign(size, free);
+}
+
+template <unsigned LEN>
+bool BasicMouseSession<LEN>::visit(uint64_t hash) {
+    if(seenCount >= seenStates.size() / 2) {
+        return true;
+    }
+    // zero marks a free slot.
+    hash = hash ? hash : 1;
+    const size_t mask = seenStates.size() - 1;
+    for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+        if(seenStates[i].hash == hash) {
+            loopStart = seenStates[i].step;
+            return false;
+        }
+        if(seenStates[i].hash == 0) {
+            seenStates[i].hash = hash;
+            seenStates[i].step = getStepCount();
+            seenCount++;
+            return true;
+        }
+    }
+}
+
+template <unsigned LEN>
+bool BasicMouseSession<LEN>::mayStep() {
+    if(outcome != RUN_IN_PROGRESS) {
+        return false;
+    }
+    if(stepLimit && getMoveCount() >= stepLimit) {
+        outcome = RUN_STEP_LIMIT;
+        return false;
+    }
+    if(runTimeLimit.count() > 0) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(!runStarted) {
+            runStart = now;
+            runStarted = true;
+        } else if(now - runStart > runTimeLimit) {
+            outcome = RUN_TIME_LIMIT;
+            return false;
+        }
+    }
+    uint64_t state;
+    if(!seenStates.empty() && pathFinder->getStateHash(state)) {
+        // the pose, spread over the whole word before it is mixed with the PathFinder's state.
+        uint64_t h = state ^ (((uint64_t)(mouseX * LEN + mouseY) * 4 + heading + 1) * 0x9E3779B97F4A7C15ull);
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        if(!visit(h ^ (h >> 31))) {
+            outcome = RUN_LOOPED;
+            return false;
+        }
+    }
+    return true;
+}
+
+template <unsigned LEN>
+bool BasicMouseSession<LEN>::step() {
+    if(!pathFinder || !mayStep()) {
+        return false;
+    }
+
+    Trace::Span span("step", "Maze", mouseX, mouseY);
+
+    const MouseMovement nextMovement = callPathFinder();
+    if(recorder) {
+        record(nextMovement);
+    }
+    if(publisher) {
+        publish(nextMovement);
+    }
+
+    if(Finish == nextMovement) {
+        movementCount[Finish]++;
+        outcome = RUN_FINISHED;
+        return false;
+    }
+
+    perform(nextMovement);
+    return true;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::perform(MouseMovement movement) {
+    movementCount[movement]++;
+    try {
+        switch(movement) {
+            case MoveForward:
+                moveForward();
+                break;
+            case MoveBackward:
+                moveBackward();
+                break;
+            case TurnClockwise:
+                turnClockwise();
+                break;
+            case TurnCounterClockwise:
+                turnCounterClockwise();
+                break;
+            case TurnAround:
+                turnAround();
+                break;
+            case Wait:
+                // Do nothing, try again
+                break;
+            case Finish:
+            default:
+                break;
+        }
+    } catch (std::string str) {
+        std::cerr << str << std::endl;
+    }
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::force(MouseMovement movement) {
+    if(!pathFinder || outcome != RUN_IN_PROGRESS || Finish == movement) {
+        return;
+    }
+
+    Trace::Span span("force", "Maze", mouseX, mouseY);
+
+    if(recorder) {
+        record(movement);
+    }
+    if(publisher) {
+        publish(movement);
+    }
+    pathFinder->forced(movement);
+    perform(movement);
+}
+
+template <unsigned LEN>
+typename BasicMouseSession<LEN>::Snapshot BasicMouseSession<LEN>::snapshot() const {
+    Snapshot s;
+    s.x = mouseX;
+    s.y = mouseY;
+    s.heading = heading;
+    for(unsigned m = 0; m < ARRAY_SIZE(movementCount); m++) {
+        s.movementCount[m] = movementCount[m];
+    }
+    s.overrunCount = overrunCount;
+    s.maxCallTime = maxCallTime;
+    return s;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::restore(const Snapshot &s) {
+    mouseX = s.x;
+    mouseY = s.y;
+    heading = s.heading;
+    for(unsigned m = 0; m < ARRAY_SIZE(movementCount); m++) {
+        movementCount[m] = s.movementCount[m];
+    }
+    overrunCount = s.overrunCount;
+    maxCallTime = s.maxCallTime;
+    outcome = movementCount[Finish] ? RUN_FINISHED : RUN_IN_PROGRESS;
+    loopStart = 0;
+    if(!seenStates.empty()) {
+        const SeenState free = {0, 0};
+        std::fill(seenStates.begin(), seenStates.end(), free);
+        seenCount = 0;
+    }
+}
+
+template <unsigned LEN>
+unsigned BasicMouseSession<LEN>::cellWalls() const {
+    unsigned walls = 0;
+    const Dir sides[] = {NORTH, SOUTH, EAST, WEST};
+    for(unsigned i = 0; i < ARRAY_SIZE(sides); i++) {
+        if(!isOpen(mouseX, mouseY, sides[i])) {
+            walls |= 1 << sides[i];
+        }
+    }
+    return walls;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::record(MouseMovement movement) {
+    if(recorder->hasDistances()) {
+        uint16_t *distances = recorder->distanceBuffer();
+        for(unsigned x = 0; x < LEN; x++) {
+            for(unsigned y = 0; y < LEN; y++) {
+                const unsigned d = pathFinder->getDistance(x, y);
+                distances[x * LEN + y] = d < Replay::NO_DISTANCE ? d : Replay::NO_DISTANCE;
+            }
+        }
+    }
+    recorder->step(mouseX, mouseY, heading, cellWalls(), movement);
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::publish(MouseMovement movement) {
+    if(publisher->hasDistances()) {
+        uint16_t *distances = publisher->distanceBuffer();
+        for(unsigned x = 0; x < LEN; x++) {
+            for(unsigned y = 0; y < LEN; y++) {
+                const unsigned d = pathFinder->getDistance(x, y);
+                distances[x * LEN + y] = d < Replay::NO_DISTANCE ? d : Replay::NO_DISTANCE;
+            }
+        }
+    }
+    publisher->step(mouseX, mouseY, heading, cellWalls(), movement);
+}
+
+template <unsigned LEN>
+std::string BasicMouseSession<LEN>::draw(const size_t infoLen) const {
+    Trace::Span span("draw", "Maze", mouseX, mouseY);
+    ALLOC_GROUP("Maze::draw");
+    std::string out("");
+    std::string upDown, leftRight;
+
+    const size_t cellWidth = infoLen + 1;
+    const char dot = '*';
+    const char vertWall = '|';
+    const char vertWallEmpty = ' ';
+    const std::string horizWall = std::string("").append(cellWidth, '-');
+    const std::string horizWallEmpty = std::string("").append(cellWidth, ' ');
+
+    for(unsigned row = 0; row < LEN; row++) {
+        const unsigned y = LEN - row - 1;
+
+        upDown = dot;
+        leftRight = "";
+
+        // Draw most of the maze
+        for(unsigned x = 0; x < LEN; x++) {
+            std::string cellInfo;
+
+            if(pathFinder) {
+                ALLOC_GROUP("PathFinder::getInfo");
+                cellInfo = pathFinder->getInfo(x, y, infoLen).substr(0, infoLen);
+            }
+
+            if("" == cellInfo) {
+                cellInfo.append(cellWidth / 2, vertWallEmpty);
+            }
+
+            if(x == mouseX && y == mouseY) {
+                switch(heading) {
+                    case NORTH:
+                        cellInfo += '^';
+                        break;
+                    case SOUTH:
+                        cellInfo += 'V';
+                        break;
+                    case EAST:
+                        cellInfo += '>';
+                        break;
+                    case WEST:
+                        cellInfo += '<';
+                        break;
+                    case INVALID:
+                    default:
+                        break;
+                }
+            }
+
+            if(cellInfo.length() < cellWidth) {
+                cellInfo.append(cellWidth - cellInfo.length(), ' ');
+            }
+
+            upDown    += isOpen(x, y, NORTH) ? horizWallEmpty : horizWall;
+            leftRight += isOpen(x, y, WEST)  ? vertWallEmpty  : vertWall;
+
+            upDown    += dot;
+            leftRight += cellInfo;
+        }
+
+        // Get the last column of walls
+        leftRight += isOpen(LEN-1, y, EAST) ? vertWallEmpty : vertWall;
+
+        out += upDown + '\n' + leftRight + '\n';
+    }
+
+    // Draw out the bottom most row
+    out += dot;
+    for(unsigned x = 0; x < LEN; x++) {
+        out += isOpen(x, 0, SOUTH) ? horizWallEmpty : horizWall;
+        out += dot;
+    }
+
+    return out;
+}
+
+template <unsigned LEN>
+void BasicMouseSession<LEN>::writeStats(std::ostream &out) const {
+    out << "{\"maze\":" << world.getName()
+        << ",\"steps\":" << getStepCount()
+        << ",\"outcome\":\"" << runOutcomeName(outcome) << "\"";
+    if(outcome == RUN_LOOPED) {
+        out << ",\"loopStart\":" << loopStart;
+    }
+    out << ",\"movements\":{";
+    for(unsigned m = MoveForward; m <= Finish; m++) {
+        out << (m == MoveForward ? "" : ",") << "\"" << movementName((MouseMovement)m) << "\":" << movementCount[m];
+    }
+    out << "}";
+
+    if(timeBudget.count() > 0) {
+        out << ",\"budgetNanos\":" << timeBudget.count()
+            << ",\"overruns\":" << overrunCount
+            << ",\"maxCallNanos\":" << maxCallTime.count();
+    }
+
+    out << ",\"pathFinder\":";
+    if(pathFinder) {
+        pathFinder->writeStats(out);
+    } else {
+        out << "null";
+    }
+    out << "}";
+}
+
+template class BasicMouseSession<MazeDefinitions::MAZE_LEN>;
+template class BasicMouseSession<MazeDefinitions::HALF_SIZE_MAZE_LEN>;
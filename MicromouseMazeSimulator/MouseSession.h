@@ -0,0 +1,413 @@
+#ifndef MouseSession_h
+#define MouseSession_h
+
+#include <string>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include <stdint.h> // uint64_t
+
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "Dir.h"
+#include "PathFinder.h"
+
+namespace Replay {
+    class Writer;
+}
+
+namespace LiveView {
+    class Publisher;
+}
+
+/**
+ * A wall seen by the sensors: the side of cell (x, y), and whether it is closed.
+ */
+struct WallObservation {
+    unsigned x;
+    unsigned y;
+    Dir side;
+    bool closed;
+};
+
+/**
+ * Range of the sensors, in cells ahead of the one the mouse stands in.
+ * The classic mouse, {0, 0}, only sees the walls of its own cell (wallInFront, wallOnLeft, wallOnRight).
+ */
+struct SensorRange {
+    // cells ahead whose front wall the front sensors see, as long as no wall blocks the view.
+    unsigned front;
+    // cells ahead whose left and right walls the side sensors see.
+    unsigned side;
+};
+
+/**
+ * How a run ended, see BasicMouseSession::getOutcome.
+ */
+enum RunOutcome {
+    RUN_IN_PROGRESS,    // the mouse is still going
+    RUN_FINISHED,       // the PathFinder returned Finish
+    RUN_STEP_LIMIT,     // cut off after the step limit
+    RUN_TIME_LIMIT,     // cut off after the time limit
+    RUN_LOOPED          // the mouse came back to a pose with the PathFinder in a state it had been in before
+};
+
+inline const char *runOutcomeName(RunOutcome outcome) {
+    switch(outcome) {
+        case RUN_IN_PROGRESS:
+            return "inProgress";
+        case RUN_FINISHED:
+            return "finished";
+        case RUN_STEP_LIMIT:
+            return "stepLimit";
+        case RUN_TIME_LIMIT:
+            return "timeLimit";
+        case RUN_LOOPED:
+        default:
+            return "looped";
+    }
+}
+
+/**
+ * A mouse running through a LEN x LEN maze: its pose, its PathFinder and the counters of the run.
+ * The walls are the world's, which is only read, so many sessions can share one world
+ * (see MazeWorld.h), each on its own thread.
+ * MouseSession runs in the classic 16x16 maze, HalfSizeMouseSession in the 32x32 one.
+ * The member functions are instantiated for these two sizes in MouseSession.cpp.
+ */
+template <unsigned LEN>
+class BasicMouseSession {
+protected:
+    const BasicMazeWorld<LEN> &world;
+    Dir heading;
+    BasicPathFinder<LEN> *pathFinder;
+    unsigned mouseX;
+    unsigned mouseY;
+
+    // number of times each MouseMovement was returned by the PathFinder during start()
+    unsigned long movementCount[Finish + 1];
+
+    // time allowed per nextMovement call, zero when there is no budget
+    std::chrono::nanoseconds timeBudget;
+    // number of nextMovement calls that took longer than timeBudget
+    unsigned long overrunCount;
+    // longest nextMovement call while there was a budget
+    std::chrono::nanoseconds maxCallTime;
+
+    // replay being written, NULL when the run is not recorded.
+    Replay::Writer *recorder;
+    // live view the steps are published to, NULL when there is none.
+    LiveView::Publisher *publisher;
+
+    // how far the sensors see, see sense().
+    SensorRange sensorRange;
+
+    // how the run ended, RUN_IN_PROGRESS until it does.
+    RunOutcome outcome;
+    // steps and time after which the run is cut off, zero for no limit.
+    unsigned long stepLimit;
+    std::chrono::nanoseconds runTimeLimit;
+    // when the first step was made, see setRunTimeLimit.
+    std::chrono::steady_clock::time_point runStart;
+    bool runStarted;
+
+    // a state of the run seen before a step: hash of the pose and the PathFinder's state, and the step.
+    struct SeenState {
+        uint64_t hash;
+        unsigned long step;
+    };
+    // open addressing table of the states seen so far, empty when loop detection is off.
+    // Its size is a power of two, a zero hash marks a free slot.
+    std::vector<SeenState> seenStates;
+    unsigned long seenCount;
+    // the step a looped run first was in the state it came back to.
+    unsigned long loopStart;
+
+    // check the limits and the state before a step, setting the outcome when the run has to be cut off.
+    bool mayStep();
+
+    // note the state the run is in, false if it has been in it before.
+    bool visit(uint64_t hash);
+
+    // ask the PathFinder for the next movement, telling it the deadline and timing it when there is a budget.
+    MouseMovement callPathFinder();
+
+    // 1 << Dir for each closed side of the mouse's cell.
+    unsigned cellWalls() const;
+
+    // write the movement, the walls around the mouse and the PathFinder's distances to the replay.
+    void record(MouseMovement movement);
+
+    // the same, to the live view.
+    void publish(MouseMovement movement);
+
+    // count a movement other than Finish and carry it out.
+    void perform(MouseMovement movement);
+
+    inline bool isOpen(unsigned x, unsigned y, Dir d) const {
+        return world.isOpen(x, y, d);
+    }
+
+    void moveForward();
+    void moveBackward();
+
+    inline void turnClockwise() {
+        heading = clockwise(heading);
+    }
+
+    inline void turnCounterClockwise() {
+        heading = counterClockwise(heading);
+    }
+
+    inline void turnAround() {
+        heading = opposite(heading);
+    }
+
+public:
+    /**
+     * Pose and counters of a session between two steps, see snapshot and restore.
+     * Plain data of a fixed size, so it can be copied to every thread that continues from it.
+     */
+    struct Snapshot {
+        unsigned x;
+        unsigned y;
+        Dir heading;
+        unsigned long movementCount[Finish + 1];
+        unsigned long overrunCount;
+        std::chrono::nanoseconds maxCallTime;
+    };
+
+    /**
+     * @param world: maze to run in. It has to outlive the session.
+     * @param pathFinder: PathFinder that moves the mouse
+     */
+    BasicMouseSession(const BasicMazeWorld<LEN> &world, BasicPathFinder<LEN> *pathFinder);
+
+    /**
+     * @param name: built-in maze to run in, see MazeDefinitions::Encodings<LEN>. The first one if out of range.
+     * @param pathFinder: PathFinder that moves the mouse
+     */
+    BasicMouseSession(unsigned name, BasicPathFinder<LEN> *pathFinder)
+    : BasicMouseSession(BasicMazeWorld<LEN>::get(name), pathFinder) {}
+
+    inline const BasicMazeWorld<LEN> &getWorld() const {
+        return world;
+    }
+
+    inline bool wallInFront() const {
+        return !isOpen(mouseX, mouseY, heading);
+    }
+
+    inline bool wallOnLeft() const {
+        return !isOpen(mouseX, mouseY, counterClockwise(heading));
+    }
+
+    inline bool wallOnRight() const {
+        return !isOpen(mouseX, mouseY, clockwise(heading));
+    }
+
+    /**
+     * Most observations sense() can make: a front and two side walls per cell in a line of the maze.
+     */
+    static const unsigned MAX_OBSERVATIONS = 3 * LEN;
+
+    /**
+     * Let the sensors see further than the mouse's own cell. Ranges are capped at LEN - 1.
+     * @param range: cells ahead seen by the front and by the side sensors. {0, 0} (the default) is the classic mouse.
+     */
+    void setSensorRange(SensorRange range);
+
+    inline SensorRange getSensorRange() const {
+        return sensorRange;
+    }
+
+    /**
+     * Every wall the sensors see from where the mouse stands: the front wall of each cell ahead
+     * within the front range and the side walls of each cell within the side range, up to the
+     * first closed front wall. The walls of the mouse's own cell (but its back) come first.
+     * @param out: room for MAX_OBSERVATIONS observations
+     * @return number of observations written to out
+     */
+    unsigned sense(WallObservation *out) const;
+
+    // // // for floodfill detection:
+    // inline Dir getHeading() const {
+    //     return heading;
+    // }
+    /**
+     * Start running the mouse through the maze.
+     * Terminates when the PathFinder's nextMovement method returns MouseMovement::Finish,
+     * or when the run is cut off (see getOutcome).
+     */
+    void start();
+
+    /**
+     * Make a single movement: ask the PathFinder for the next one and carry it out.
+     * start() is step() until it returns false, so a caller can interleave many sessions.
+     * @return false once the PathFinder has returned MouseMovement::Finish or the run is cut off
+     */
+    bool step();
+
+    /**
+     * Cut the run off after a number of steps (movements, and forced ones). Wait is not counted:
+     * how often a PathFinder waits for its planner depends on the scheduler, not on the maze.
+     * A PathFinder that only ever waits is cut off by the time limit.
+     * @param steps: steps allowed. Zero (the default) for no limit.
+     */
+    inline void setStepLimit(unsigned long steps) {
+        stepLimit = steps;
+    }
+
+    /**
+     * Cut the run off once it has taken longer than a time limit, counted from its first step
+     * and checked before every step.
+     * @param limit: time allowed for the whole run. Zero (the default) for no limit.
+     */
+    inline void setRunTimeLimit(std::chrono::nanoseconds limit) {
+        runTimeLimit = limit;
+    }
+
+    /**
+     * Cut the run off as soon as it loops: before every step the pose of the mouse and the state
+     * of the PathFinder (see BasicPathFinder::getStateHash) are hashed, and a run that comes back
+     * to a state it has been in would do the same over and over again.
+     *
+     * The table of states is allocated here, with room for the step limit (or 64 steps per cell
+     * when there is none), so detecting loops does not allocate during the run. Once it is half
+     * full no more states are noted, the step limit has to catch longer loops. Steps the
+     * PathFinder cannot hash its state for are not checked.
+     * @param on: true to detect loops, false (the default) to free the table
+     */
+    void setLoopDetection(bool on);
+
+    /**
+     * @return how the run ended, RUN_IN_PROGRESS while it goes on
+     */
+    inline RunOutcome getOutcome() const {
+        return outcome;
+    }
+
+    /**
+     * @return true if the run was cut off before the PathFinder finished it
+     */
+    inline bool wasCutOff() const {
+        return outcome != RUN_IN_PROGRESS && outcome != RUN_FINISHED;
+    }
+
+    /**
+     * @return for a looped run, the step at which it was first in the state it came back to
+     */
+    inline unsigned long getLoopStart() const {
+        return loopStart;
+    }
+
+    /**
+     * Carry out a movement the PathFinder did not choose, e.g. to try another one from a snapshot.
+     * It counts as a step, and the PathFinder is told about it (see BasicPathFinder::forced).
+     * @param movement: movement to make instead of asking the PathFinder. Finish is ignored.
+     */
+    void force(MouseMovement movement);
+
+    /**
+     * @return the pose and counters as of now. The PathFinder has to be snapshotted on its own.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * Continue from a snapshot of a session in the same world, usually with a PathFinder
+     * restored from the same point (see BasicFloodFill::restore). The states seen for loop
+     * detection are forgotten, the limits are kept.
+     * @param snapshot: taken by snapshot() of any session in this world
+     */
+    void restore(const Snapshot &snapshot);
+
+    /**
+     * Give the PathFinder a time budget for every nextMovement call.
+     *
+     * Before each call the PathFinder is told its deadline (see PathFinder::setDeadline),
+     * and calls that take longer than the budget are counted as overruns.
+     * @param budget: time allowed per call. Zero (the default) disables the budget.
+     */
+    inline void setTimeBudget(std::chrono::nanoseconds budget) {
+        timeBudget = budget;
+    }
+
+    /**
+     * Record every step into a replay (see Replay.h): the movement, the walls around the mouse and,
+     * if the writer asks for them, the distances of the PathFinder (see BasicPathFinder::getDistance).
+     * @param writer: replay to write, NULL to stop recording. It has to outlive the run.
+     */
+    inline void setRecorder(Replay::Writer *writer) {
+        recorder = writer;
+    }
+
+    /**
+     * Publish every step to a live view in shared memory (see LiveView.h): the same as a replay
+     * records, for a viewer in another process. Publishing never waits for the viewer.
+     * @param live: publisher to write to, NULL to stop publishing. It has to outlive the run.
+     */
+    inline void setPublisher(LiveView::Publisher *live) {
+        publisher = live;
+    }
+
+    /**
+     * @return number of nextMovement calls that exceeded the time budget during start()
+     */
+    inline unsigned long getOverrunCount() const {
+        return overrunCount;
+    }
+
+    /**
+     * @return duration of the longest nextMovement call, only measured when there is a time budget
+     */
+    inline std::chrono::nanoseconds getMaxCallTime() const {
+        return maxCallTime;
+    }
+
+    /**
+     * @return number of times the PathFinder returned movement m during start()
+     */
+    inline unsigned long getMovementCount(MouseMovement m) const {
+        return movementCount[m];
+    }
+
+    /**
+     * @return number of movements (including Wait) performed during start()
+     */
+    inline unsigned long getStepCount() const {
+        unsigned long steps = 0;
+        for(unsigned m = MoveForward; m < Finish; m++) {
+            steps += movementCount[m];
+        }
+        return steps;
+    }
+
+    /**
+     * @return number of movements but Wait performed during start(), what the step limit counts
+     */
+    inline unsigned long getMoveCount() const {
+        return getStepCount() - movementCount[Wait];
+    }
+
+    /**
+     * This function draws the maze using ASCII characters.
+     *
+     * Queries the underlying PathFinder for additional maze info
+     * and incorporates it in the maze rendering.
+     * @param infoLen: specifies the max characters of info to be drawn. If no info is supplied, blank spaces will be inserted.
+     * @return string of rendered maze
+     */
+    std::string draw(const size_t infoLen = 4) const;
+
+    /**
+     * Write the statistics of the last start() as a JSON object:
+     * the maze, steps, how the run ended, movements by type, budget overruns and the PathFinder's own statistics.
+     * @param out: stream to write the JSON object to
+     */
+    void writeStats(std::ostream &out) const;
+};
+
+typedef BasicMouseSession<MazeDefinitions::MAZE_LEN> MouseSession;
+typedef BasicMouseSession<MazeDefinitions::HALF_SIZE_MAZE_LEN> HalfSizeMouseSession;
+
+#endif
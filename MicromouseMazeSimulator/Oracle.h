@@ -0,0 +1,266 @@
+#ifndef Oracle_h
+#define Oracle_h
+
+#include <cmath>   // std::sqrt
+#include <vector>
+#include <queue>
+#include <functional> // std::greater
+#include <utility>    // std::pair
+
+#include "Dir.h"
+#include "MazeWorld.h"
+#include "PathFinder.h"
+
+/**
+ * The best a mouse could do in a maze it knew completely, to measure a PathFinder against.
+ *
+ * shortest is the route from the start to the center through the fewest cells, fastest the
+ * one that takes the least time under a TimingModel. Both look at every wall of the world,
+ * a built-in maze or any other BasicMazeWorld, so they are bounds no search can beat.
+ */
+namespace Oracle {
+    /**
+     * Time a mouse takes for its movements. It turns in place, so it starts and stops every
+     * straight run: a run accelerates to top speed, cruises and brakes, or only accelerates and
+     * brakes when it is too short to reach top speed. Turns and waits take fixed times.
+     */
+    struct TimingModel {
+        // m, the classic maze. The same model is used for the half-size mazes, with their cell length.
+        double cellLength;
+        // m/s^2, to speed up and to brake.
+        double acceleration;
+        // m/s
+        double topSpeed;
+        // s, a quarter turn in place.
+        double turnTime;
+        // s, a half turn in place.
+        double aroundTime;
+        // s, a Wait (time spent planning instead of moving).
+        double waitTime;
+
+        explicit TimingModel(double cellLength = 0.18)
+        : cellLength(cellLength), acceleration(4.0), topSpeed(2.0), turnTime(0.2), aroundTime(0.35), waitTime(0.01) {}
+
+        // time of a straight run through cells cells, from standstill to standstill.
+        double straight(unsigned cells) const {
+            const double d = cells * cellLength;
+            // distance needed to reach top speed and brake again.
+            const double full = topSpeed * topSpeed / acceleration;
+            if(d < full)
+                return 2 * std::sqrt(d / acceleration);
+            return d / topSpeed + topSpeed / acceleration;
+        }
+
+        // time of a sequence of movements, consecutive MoveForwards making one straight run.
+        double time(const std::vector<MouseMovement> &movements) const {
+            double t = 0;
+            unsigned run = 0;
+            for(size_t i = 0; i < movements.size(); i++) {
+                if(movements[i] == MoveForward || movements[i] == MoveBackward) {
+                    run++;
+                    continue;
+                }
+                t += straight(run);
+                run = 0;
+                if(movements[i] == TurnClockwise || movements[i] == TurnCounterClockwise)
+                    t += turnTime;
+                else if(movements[i] == TurnAround)
+                    t += aroundTime;
+                else if(movements[i] == Wait)
+                    t += waitTime;
+            }
+            return t + straight(run);
+        }
+    };
+
+    /**
+     * A route from the start, (0,0) facing north, to the first center cell it reaches.
+     */
+    struct Path {
+        bool found;
+        // cells moved through, and the time under the timing model.
+        unsigned cells;
+        double time;
+        std::vector<MouseMovement> movements;
+    };
+
+    // cells moved through by movements.
+    inline unsigned cellCount(const std::vector<MouseMovement> &movements) {
+        unsigned cells = 0;
+        for(size_t i = 0; i < movements.size(); i++) {
+            cells += movements[i] == MoveForward || movements[i] == MoveBackward;
+        }
+        return cells;
+    }
+
+    template <unsigned LEN>
+    inline bool isCenter(unsigned x, unsigned y) {
+        return (x == LEN / 2 - 1 || x == LEN / 2) && (y == LEN / 2 - 1 || y == LEN / 2);
+    }
+
+    inline void step(unsigned &x, unsigned &y, Dir d) {
+        x += d == EAST ? 1 : d == WEST ? -1 : 0;
+        y += d == NORTH ? 1 : d == SOUTH ? -1 : 0;
+    }
+
+    // the turn that changes heading from into to, Wait if there is none.
+    inline MouseMovement turn(Dir from, Dir to) {
+        if(to == from)
+            return Wait;
+        if(to == clockwise(from))
+            return TurnClockwise;
+        if(to == counterClockwise(from))
+            return TurnCounterClockwise;
+        return TurnAround;
+    }
+
+    /**
+     * The route through the fewest cells, breadth first. Of the routes as short as it, the one
+     * found first, whatever its turns.
+     */
+    template <unsigned LEN>
+    Path shortest(const BasicMazeWorld<LEN> &world, const TimingModel &model) {
+        const unsigned CELLS = LEN * LEN;
+        std::vector<unsigned> parent(CELLS, CELLS);
+        std::queue<unsigned> queue;
+        parent[0] = 0;
+        queue.push(0);
+        unsigned goal = CELLS;
+        const Dir sides[] = {NORTH, EAST, SOUTH, WEST};
+        while(!queue.empty() && goal == CELLS) {
+            const unsigned cell = queue.front();
+            queue.pop();
+            const unsigned x = cell / LEN, y = cell % LEN;
+            if(isCenter<LEN>(x, y)) {
+                goal = cell;
+                break;
+            }
+            for(unsigned s = 0; s < 4; s++) {
+                if(!world.isOpen(x, y, sides[s]))
+                    continue;
+                unsigned nx = x, ny = y;
+                step(nx, ny, sides[s]);
+                const unsigned next = nx * LEN + ny;
+                if(parent[next] == CELLS) {
+                    parent[next] = cell;
+                    queue.push(next);
+                }
+            }
+        }
+
+        Path path;
+        path.found = goal != CELLS;
+        path.cells = 0;
+        path.time = 0;
+        if(!path.found)
+            return path;
+        std::vector<unsigned> cells;
+        for(unsigned cell = goal; cell != 0; cell = parent[cell]) {
+            cells.push_back(cell);
+        }
+        cells.push_back(0);
+        Dir heading = NORTH;
+        for(size_t i = cells.size() - 1; i > 0; i--) {
+            const unsigned from = cells[i], to = cells[i - 1];
+            const Dir d = to == from + LEN ? EAST : to + LEN == from ? WEST : to == from + 1 ? NORTH : SOUTH;
+            if(d != heading)
+                path.movements.push_back(turn(heading, d));
+            heading = d;
+            path.movements.push_back(MoveForward);
+        }
+        path.cells = cellCount(path.movements);
+        path.time = model.time(path.movements);
+        return path;
+    }
+
+    /**
+     * The route that takes the least time: Dijkstra over (cell, heading), where a state is left
+     * by turning in place or by a straight run of any length.
+     */
+    template <unsigned LEN>
+    Path fastest(const BasicMazeWorld<LEN> &world, const TimingModel &model) {
+        const unsigned STATES = LEN * LEN * 4;
+        const double UNREACHED = 1e300;
+        // the headings in the order of Dir.
+        const Dir headings[] = {NORTH, SOUTH, EAST, WEST};
+        std::vector<double> best(STATES, UNREACHED);
+        // state it was reached from, and the movements of that edge (a turn, or a run of MoveForwards).
+        std::vector<unsigned> parent(STATES, STATES);
+        std::vector<MouseMovement> how(STATES, Wait);
+        std::vector<unsigned> runs(STATES, 0);
+        std::vector<double> straight(LEN);
+        for(unsigned k = 1; k < LEN; k++) {
+            straight[k] = model.straight(k);
+        }
+
+        typedef std::pair<double, unsigned> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+        // state = cell * 4 + heading, the start faces north.
+        best[NORTH] = 0;
+        queue.push(Entry(0, NORTH));
+        unsigned goal = STATES;
+        while(!queue.empty()) {
+            const Entry e = queue.top();
+            queue.pop();
+            const unsigned state = e.second;
+            if(e.first > best[state])
+                continue;
+            const unsigned cell = state / 4;
+            const unsigned x = cell / LEN, y = cell % LEN;
+            const Dir heading = headings[state % 4];
+            if(isCenter<LEN>(x, y)) {
+                goal = state;
+                break;
+            }
+            // turns in place.
+            for(unsigned h = 0; h < 4; h++) {
+                const MouseMovement t = turn(heading, headings[h]);
+                if(t == Wait)
+                    continue;
+                const double time = e.first + (t == TurnAround ? model.aroundTime : model.turnTime);
+                const unsigned next = cell * 4 + h;
+                if(time < best[next]) {
+                    best[next] = time;
+                    parent[next] = state;
+                    how[next] = t;
+                    runs[next] = 0;
+                    queue.push(Entry(time, next));
+                }
+            }
+            // straight runs, as far as the walls allow.
+            unsigned nx = x, ny = y;
+            for(unsigned k = 1; world.isOpen(nx, ny, heading); k++) {
+                step(nx, ny, heading);
+                const double time = e.first + straight[k];
+                const unsigned next = (nx * LEN + ny) * 4 + state % 4;
+                if(time < best[next]) {
+                    best[next] = time;
+                    parent[next] = state;
+                    how[next] = MoveForward;
+                    runs[next] = k;
+                    queue.push(Entry(time, next));
+                }
+            }
+        }
+
+        Path path;
+        path.found = goal != STATES;
+        path.cells = 0;
+        path.time = 0;
+        if(!path.found)
+            return path;
+        std::vector<MouseMovement> reversed;
+        for(unsigned state = goal; parent[state] != STATES; state = parent[state]) {
+            if(how[state] == MoveForward)
+                reversed.insert(reversed.end(), runs[state], MoveForward);
+            else
+                reversed.push_back(how[state]);
+        }
+        path.movements.assign(reversed.rbegin(), reversed.rend());
+        path.cells = cellCount(path.movements);
+        path.time = best[goal];
+        return path;
+    }
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef ParallelFlood_h
+#define ParallelFlood_h
+
+#include <stdint.h> // uint32_t, uint64_t
+#include <cstddef>  // size_t
+#include <vector>
+#include <memory>   // std::unique_ptr
+#include <atomic>
+#include <thread>
+#include <algorithm> // std::fill
+
+#include "LargeMaze.h"
+
+/**
+ * Multi-threaded breadth first distances from the center of a LargeMaze.
+ *
+ * The flood is level synchronous: all the cells at distance d are expanded before any
+ * cell at distance d+1, so every cell gets exactly the distance LargeMaze::flood gives it,
+ * whatever the number of threads and however the work is split.
+ *
+ * The slots are dealt out to the threads in blocks of 2^OWNER_BITS, and only the owner of a
+ * cell ever reads or writes its distance, so distances are plain integers and claiming a cell
+ * costs no atomic operation. Each level has two steps:
+ *     claim    every thread goes through the cells sent to it during the previous level,
+ *              gives the unreached ones distance d and queues them as its frontier
+ *     expand   the frontiers are worked through in chunks of CHUNK cells: a thread takes
+ *              chunks from its own frontier first, then steals from the frontiers the other
+ *              threads have finished claiming. The open neighbors of every cell are sent to
+ *              their owner for the next level.
+ * One barrier ends each level.
+ */
+template <typename Layout>
+class ParallelFlood {
+public:
+    static const uint32_t UNREACHED = LargeMaze<Layout>::UNREACHED;
+    // cells taken from a frontier at a time.
+    static const size_t CHUNK = 64;
+    // consecutive slots with the same owner: 64x64 cells in Morton order.
+    static const unsigned OWNER_BITS = 12;
+
+    explicit ParallelFlood(const LargeMaze<Layout> &maze)
+    : maze(maze), distances(maze.getLayout().slots(), UNREACHED), workers(0) {}
+
+    /**
+     * Flood the maze from the center cells.
+     * @param threads: number of threads, including the calling one
+     * @return number of cells reached
+     */
+    size_t flood(unsigned threads) {
+        if(threads == 0)
+            threads = 1;
+        std::fill(distances.begin(), distances.end(), UNREACHED);
+        setup(threads);
+
+        // the center cells are sent to their owners for level 0.
+        const unsigned mid = maze.getSide() / 2;
+        seed(mid - 1, mid - 1);
+        seed(mid - 1, mid);
+        seed(mid, mid - 1);
+        seed(mid, mid);
+
+        std::vector<std::thread> pool;
+        for(unsigned t = 1; t < threads; t++) {
+            pool.push_back(std::thread(&ParallelFlood::work, this, t));
+        }
+        work(0);
+        for(unsigned t = 0; t < pool.size(); t++) {
+            pool[t].join();
+        }
+        return reached.load();
+    }
+
+    inline uint32_t distance(unsigned x, unsigned y) const {
+        return distances[maze.getLayout().index(x, y)];
+    }
+
+protected:
+    // a cell sent to a thread or queued in a frontier: the slot index in the high half,
+    // the cell packed as x | y << 16 in the low half.
+    typedef uint64_t Entry;
+
+    // a growing array with a separate length, so it can be written without checking every push.
+    struct Queue {
+        std::vector<Entry> entries;
+        size_t length;
+
+        Queue() : length(0) {}
+
+        // make room for n more entries.
+        inline void reserve(size_t n) {
+            if(length + n > entries.size())
+                entries.resize(2 * entries.size() + n);
+        }
+    };
+
+    static const size_t NOT_READY = ~(size_t)0;
+
+    // per thread state, a cache line apart from the next thread's.
+    struct alignas(64) Worker {
+        // frontier of the levels of each parity.
+        Queue frontier[2];
+        // length of frontier[p] once it can be stolen, NOT_READY before.
+        std::atomic<size_t> published[2];
+        // next entry of frontier[p] to take.
+        std::atomic<size_t> cursor[2];
+        // cells sent to each thread, for the levels of each parity.
+        std::vector<Queue> outbox[2];
+    };
+
+    inline unsigned owner(size_t i) const {
+        return (i >> OWNER_BITS) % workers;
+    }
+
+    void setup(unsigned threads) {
+        if(threads != workers) {
+            workers = threads;
+            state.reset(new Worker[threads]);
+            for(unsigned t = 0; t < threads; t++) {
+                for(unsigned p = 0; p < 2; p++) {
+                    state[t].outbox[p].assign(threads, Queue());
+                }
+            }
+        }
+        for(unsigned t = 0; t < threads; t++) {
+            Worker &w = state[t];
+            for(unsigned p = 0; p < 2; p++) {
+                w.frontier[p].length = 0;
+                w.published[p].store(NOT_READY, std::memory_order_relaxed);
+                w.cursor[p].store(0, std::memory_order_relaxed);
+                for(unsigned o = 0; o < threads; o++) {
+                    w.outbox[p][o].length = 0;
+                }
+            }
+        }
+        for(unsigned p = 0; p < 3; p++) {
+            sent[p].store(0, std::memory_order_relaxed);
+        }
+        arrived.store(0, std::memory_order_relaxed);
+        generation.store(0, std::memory_order_relaxed);
+        reached.store(0, std::memory_order_relaxed);
+    }
+
+    inline void seed(unsigned x, unsigned y) {
+        const size_t i = maze.getLayout().index(x, y);
+        Queue &q = state[0].outbox[0][owner(i)];
+        q.reserve(1);
+        q.entries[q.length++] = ((Entry)i << 32) | x | (y << 16);
+    }
+
+    // body of every thread, the calling one is thread 0.
+    void work(unsigned self) {
+        Worker &me = state[self];
+        size_t mine = 0;
+        for(uint32_t d = 0; ; d++) {
+            const unsigned current = d & 1;
+
+            // the count of level d+1 was last read after the barrier of level d-2, and is next added to after this one.
+            if(self == 0) {
+                sent[(d + 1) % 3].store(0, std::memory_order_relaxed);
+            }
+
+            // claim: only this thread touches the distances of the cells sent to it.
+            Queue &frontier = me.frontier[current];
+            for(unsigned from = 0; from < workers; from++) {
+                const Queue &in = state[from].outbox[current][self];
+                frontier.reserve(in.length);
+                frontier.length = claim(in.entries.data(), in.length, d, frontier.entries.data(), frontier.length);
+            }
+            mine += frontier.length;
+            me.published[current].store(frontier.length, std::memory_order_release);
+
+            // expand: own frontier first, then the others in turn. The outboxes for the next
+            // level were last read during this level's claim step, by their owners, before the last barrier.
+            std::vector<Queue> &out = me.outbox[current ^ 1];
+            for(unsigned o = 0; o < workers; o++) {
+                out[o].length = 0;
+            }
+            size_t total = 0;
+            for(unsigned k = 0; k < workers; k++) {
+                Worker &victim = state[(self + k) % workers];
+                const size_t length = victim.published[current].load(std::memory_order_acquire);
+                if(length == NOT_READY)
+                    continue;  // still claiming, it expands its own frontier
+                for(;;) {
+                    const size_t begin = victim.cursor[current].fetch_add(CHUNK, std::memory_order_relaxed);
+                    if(begin >= length)
+                        break;
+                    const size_t end = begin + CHUNK < length ? begin + CHUNK : length;
+                    total += expand(victim.frontier[current].entries.data() + begin, end - begin, out);
+                }
+            }
+            sent[d % 3].fetch_add(total, std::memory_order_relaxed);
+
+            barrier();
+
+            // nothing of this level is read again before the next barrier.
+            frontier.length = 0;
+            me.published[current].store(NOT_READY, std::memory_order_relaxed);
+            me.cursor[current].store(0, std::memory_order_relaxed);
+            if(sent[d % 3].load(std::memory_order_relaxed) == 0)
+                break;
+        }
+        reached.fetch_add(mine, std::memory_order_relaxed);
+    }
+
+    // give distance d to the unreached cells of in and append them to out. Returns the new length of out.
+    inline size_t claim(const Entry *in, size_t n, uint32_t d, Entry *out, size_t length) {
+        uint32_t *dist = distances.data();
+        for(size_t k = 0; k < n; k++) {
+            // without branches, whether a cell was reached is as good as random.
+            const size_t i = in[k] >> 32;
+            const bool first = dist[i] == UNREACHED;
+            dist[i] = first ? d : dist[i];
+            out[length] = in[k];
+            length += first;
+        }
+        return length;
+    }
+
+    // send the open neighbors of n frontier cells to their owners. Returns how many were sent.
+    size_t expand(const Entry *cells, size_t n, std::vector<Queue> &out) {
+        for(unsigned o = 0; o < workers; o++) {
+            out[o].reserve(4 * n);
+        }
+        const Layout &layout = maze.getLayout();
+        size_t total = 0;
+        for(size_t k = 0; k < n; k++) {
+            const size_t i = cells[k] >> 32;
+            const uint32_t packed = (uint32_t)cells[k];
+            const unsigned x = packed & 0xffff;
+            const unsigned y = packed >> 16;
+
+            size_t north, south, east, west;
+            layout.neighbors(x, y, i, north, south, east, west);
+
+            // off the maze the neighbor is the cell itself, with the wall of its own side closed.
+            total += send(maze.isNorthOpenAt(i), north, packed + (1 << 16), out);
+            total += send(y > 0 && maze.isNorthOpenAt(south), south, packed - (1 << 16), out);
+            total += send(maze.isEastOpenAt(i), east, packed + 1, out);
+            total += send(x > 0 && maze.isEastOpenAt(west), west, packed - 1, out);
+        }
+        return total;
+    }
+
+    // the slot is always written, the length only moves if there is no wall.
+    inline bool send(bool open, size_t i, uint32_t packed, std::vector<Queue> &out) {
+        Queue &q = out[owner(i)];
+        q.entries[q.length] = ((Entry)i << 32) | packed;
+        q.length += open;
+        return open;
+    }
+
+    // wait for all the threads. The last one to arrive lets the others go.
+    void barrier() {
+        const unsigned gen = generation.load(std::memory_order_acquire);
+        if(arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == workers) {
+            arrived.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+        } else {
+            while(generation.load(std::memory_order_acquire) == gen) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    const LargeMaze<Layout> &maze;
+    std::vector<uint32_t> distances;
+
+    unsigned workers;
+    std::unique_ptr<Worker[]> state;
+    // cells sent during level d are counted in sent[d % 3], none ends the flood.
+    std::atomic<size_t> sent[3];
+    std::atomic<unsigned> arrived;
+    std::atomic<unsigned> generation;
+    std::atomic<size_t> reached;
+};
+
+#endif
@@ -2,22 +2,23 @@
 #define PathFinder_h
 
 #include <string>
+#include <chrono>
+#include <ostream>
+#include <stdint.h> // uint64_t
 
-class Maze;
+#include "MazeDefinitions.h"
+#include "MouseMovement.h"
 
-enum MouseMovement {
-    MoveForward,            // Move in the direction mouse is facing
-    MoveBackward,           // Move opposite of the direction mouse is facing
-    TurnClockwise,          // Self explanatory
-    TurnCounterClockwise,   // Self explanatory
-    TurnAround,             // Face the opposite direction currently facing
-    Wait,                   // Do nothing this time, do some computation, then try again later
-    Finish                  // Mouse has achieved goals and is ending the simulation
-};
+template <unsigned LEN>
+class BasicMouseSession;
 
-class PathFinder {
+/**
+ * Path finder for a LEN x LEN maze. PathFinder is the one for the classic 16x16 maze.
+ */
+template <unsigned LEN>
+class BasicPathFinder {
 public:
-    virtual ~PathFinder() {}
+    virtual ~BasicPathFinder() {}
 
     /**
      * Function that instructs the maze how to move the mouse.
@@ -32,7 +33,48 @@ public:
      * @param y: current row of the mouse (0 is bottom of the maze)
      * @param maze: the maze object that can be queried for current wall positions
      */
-    virtual MouseMovement nextMovement(unsigned x, unsigned y, const Maze &maze) = 0;
+    virtual MouseMovement nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze) = 0;
+
+    /**
+     * Function called by the maze right before nextMovement when the maze has a time budget.
+     *
+     * PathFinders that can suspend their work should return the best movement they have
+     * once the deadline has passed, and pick up where they left off on the next call.
+     * The default implementation ignores the deadline.
+     *
+     * @param deadline: point in time by which the upcoming nextMovement call should return
+     */
+    virtual void setDeadline(std::chrono::steady_clock::time_point deadline) {
+        (void)deadline;
+    }
+
+    /**
+     * Function called by the maze when it carries out a movement the PathFinder did not return
+     * (see BasicMouseSession::force), e.g. to try another choice from a snapshot.
+     *
+     * PathFinders that keep track of the heading themselves should take the forced movement
+     * into account. The default implementation ignores it.
+     *
+     * @param movement: movement made in place of a nextMovement call
+     */
+    virtual void forced(MouseMovement movement) {
+        (void)movement;
+    }
+
+    /**
+     * Function used to detect loops (see BasicMouseSession::setLoopDetection).
+     *
+     * Hash everything the next movements depend on besides the pose of the mouse and the maze:
+     * what the PathFinder has learned and the mode it is in, but no counters. Two calls with the
+     * same hash in the same pose mean the run repeats itself from there on.
+     *
+     * @param hash: set to the hash of the state
+     * @return false if the state cannot be hashed (the default), e.g. because it depends on timing
+     */
+    virtual bool getStateHash(uint64_t &hash) const {
+        (void)hash;
+        return false;
+    }
 
     /**
      * Function used to draw extra info on the maze.
@@ -52,6 +94,53 @@ public:
         (void)maxInfoLen;
         return "";
     }
+
+    /**
+     * Function used to record the distance field with the run (see Replay.h).
+     *
+     * @param x: column of the cell
+     * @param y: row of the cell
+     * @return distance of the cell to the goal as the PathFinder knows it, ~0u if it keeps none
+     */
+    virtual unsigned getDistance(unsigned x, unsigned y) const {
+        (void)x;
+        (void)y;
+        return ~0u;
+    }
+
+    /**
+     * Function used to report algorithm statistics at the end of a run.
+     *
+     * Write the counters your PathFinder keeps (work done, peak memory, ...) as a single JSON object,
+     * so algorithm changes can be compared on more than the number of steps.
+     *
+     * @param out: stream to write the JSON object to
+     */
+    virtual void writeStats(std::ostream &out) const {
+        out << "{}";
+    }
+
+    /**
+     * Function used to cache run results (see ResultCache).
+     *
+     * Two runs of the same maze by PathFinders with the same id and version have to be the
+     * same run, so the id should name the algorithm and every option that changes what it does.
+     * The default empty id means runs are never cached, e.g. because they depend on timing.
+     *
+     * @return id of the algorithm and its configuration, e.g. "floodfill-relax"
+     */
+    virtual std::string getId() const {
+        return "";
+    }
+
+    /**
+     * @return version of the algorithm. Bump it with every change that can change a run.
+     */
+    virtual unsigned getVersion() const {
+        return 0;
+    }
 };
 
+typedef BasicPathFinder<MazeDefinitions::MAZE_LEN> PathFinder;
+
 #endif
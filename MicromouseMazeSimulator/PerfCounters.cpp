@@ -0,0 +1,231 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <iomanip>
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace PerfCounters {
+    namespace {
+        const char *counterNames[COUNTER_MAX] = { "cycles", "instructions", "branch-misses", "L1D-misses" };
+
+        std::mutex registryMutex;
+        Site *registry = NULL;
+        std::atomic<unsigned> currentMaze(0);
+        // set once any thread managed to open a counter, for the report.
+        std::atomic<bool> available[COUNTER_MAX];
+
+        // per-thread counter group.
+        struct Group {
+            Group() : opened(false) {
+                for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                    fd[c] = -1;
+                    overhead.value[c] = 0;
+                }
+                overhead.nanos = 0;
+            }
+
+            ~Group() {
+#ifdef __linux__
+                for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                    if(fd[c] >= 0) {
+                        close(fd[c]);
+                    }
+                }
+#endif
+            }
+
+            bool opened;
+            int fd[COUNTER_MAX];
+            // cost of one empty Scope, subtracted from every call.
+            Sample overhead;
+        };
+
+#ifdef __linux__
+        int openCounter(uint32_t type, uint64_t config) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // calling thread, any cpu
+            return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+
+        void readRaw(Group &group, Sample &sample) {
+            for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                uint64_t value = 0;
+#ifdef __linux__
+                if(group.fd[c] >= 0 && ::read(group.fd[c], &value, sizeof(value)) != sizeof(value)) {
+                    value = 0;
+                }
+#endif
+                sample.value[c] = value;
+            }
+            sample.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void open(Group &group) {
+            group.opened = true;
+#ifdef __linux__
+            group.fd[CYCLES]        = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            group.fd[INSTRUCTIONS]  = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            group.fd[BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            group.fd[L1D_MISSES]    = openCounter(PERF_TYPE_HW_CACHE,
+                                                  PERF_COUNT_HW_CACHE_L1D |
+                                                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+            for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                if(group.fd[c] >= 0) {
+                    available[c] = true;
+                }
+            }
+#endif
+
+            // measure what an empty scope costs.
+            const unsigned rounds = 1000;
+            Sample begin, end, first, last;
+            readRaw(group, first);
+            for(unsigned i = 0; i < rounds; i++) {
+                readRaw(group, begin);
+                readRaw(group, end);
+            }
+            readRaw(group, last);
+            for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                group.overhead.value[c] = (last.value[c] - first.value[c]) / (2 * rounds);
+            }
+            group.overhead.nanos = (last.nanos - first.nanos) / (2 * rounds);
+        }
+
+        Group &threadGroup() {
+            static thread_local Group group;
+            if(!group.opened) {
+                open(group);
+            }
+            return group;
+        }
+
+        uint64_t minusOverhead(uint64_t delta, uint64_t overhead) {
+            return delta > overhead ? delta - overhead : 0;
+        }
+
+        // print one row of the report.
+        void row(std::ostream &out, const char *maze, const char *site, uint64_t calls,
+                 const uint64_t value[COUNTER_MAX], uint64_t nanos) {
+            out << std::setw(6) << maze << "  " << std::left << std::setw(16) << site << std::right
+                << std::setw(10) << calls
+                << std::setw(12) << std::fixed << std::setprecision(1) << (double)nanos / calls;
+
+            for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                if(available[c]) {
+                    out << std::setw(14) << (double)value[c] / calls;
+                } else {
+                    out << std::setw(14) << "n/a";
+                }
+            }
+
+            if(available[CYCLES] && available[INSTRUCTIONS] && value[CYCLES] > 0) {
+                out << std::setw(8) << std::setprecision(2) << (double)value[INSTRUCTIONS] / value[CYCLES];
+            } else {
+                out << std::setw(8) << "n/a";
+            }
+            out << std::endl;
+        }
+    }
+
+    Site::Site(const char *name) : name(name), next(NULL) {
+        for(unsigned m = 0; m < MazeDefinitions::MAZE_NAME_MAX; m++) {
+            totals[m].calls = 0;
+            totals[m].nanos = 0;
+            for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                totals[m].value[c] = 0;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        next = registry;
+        registry = this;
+    }
+
+    void setMaze(unsigned index) {
+        currentMaze = index < MazeDefinitions::MAZE_NAME_MAX ? index : 0;
+    }
+
+    void read(Sample &sample) {
+        readRaw(threadGroup(), sample);
+    }
+
+    void add(Site &site, const Sample &begin, const Sample &end) {
+        const Group &group = threadGroup();
+        Totals &totals = site.totals[currentMaze.load(std::memory_order_relaxed)];
+
+        totals.calls.fetch_add(1, std::memory_order_relaxed);
+        totals.nanos.fetch_add(minusOverhead(end.nanos - begin.nanos, group.overhead.nanos), std::memory_order_relaxed);
+        for(unsigned c = 0; c < COUNTER_MAX; c++) {
+            totals.value[c].fetch_add(minusOverhead(end.value[c] - begin.value[c], group.overhead.value[c]),
+                                      std::memory_order_relaxed);
+        }
+    }
+
+    void report(std::ostream &out) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+
+        out << "Performance counters, per call (measurement overhead subtracted):" << std::endl;
+        out << std::setw(6) << "maze" << "  " << std::left << std::setw(16) << "site" << std::right
+            << std::setw(10) << "calls" << std::setw(12) << "ns";
+        for(unsigned c = 0; c < COUNTER_MAX; c++) {
+            out << std::setw(14) << counterNames[c];
+        }
+        out << std::setw(8) << "IPC" << std::endl;
+
+        for(Site *site = registry; site; site = site->next) {
+            uint64_t allCalls = 0;
+            uint64_t allNanos = 0;
+            uint64_t allValue[COUNTER_MAX] = { 0 };
+            unsigned mazes = 0;
+
+            for(unsigned m = 0; m < MazeDefinitions::MAZE_NAME_MAX; m++) {
+                const Totals &totals = site->totals[m];
+                if(totals.calls == 0) {
+                    continue;
+                }
+
+                uint64_t value[COUNTER_MAX];
+                for(unsigned c = 0; c < COUNTER_MAX; c++) {
+                    value[c] = totals.value[c];
+                    allValue[c] += value[c];
+                }
+                allCalls += totals.calls;
+                allNanos += totals.nanos;
+                mazes++;
+
+                char label[16];
+                snprintf(label, sizeof(label), "%u", m);
+                row(out, label, site->name, totals.calls, value, totals.nanos);
+            }
+
+            if(mazes > 1) {
+                row(out, "all", site->name, allCalls, allValue, allNanos);
+            }
+        }
+
+        if(available[BRANCH_MISSES] == false || available[CYCLES] == false) {
+            out << "Some hardware counters are not available (no PMU, or perf_event_paranoid is too high)." << std::endl;
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
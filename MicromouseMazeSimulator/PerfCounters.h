@@ -0,0 +1,95 @@
+#ifndef PerfCounters_h
+#define PerfCounters_h
+
+#include <stdint.h> // uint64_t
+#include <atomic>
+#include <ostream>
+
+#include "MazeDefinitions.h"
+
+/**
+ * Opt-in hardware performance counters for the flood kernels (Linux only).
+ *
+ * Wrap a kernel with PERF_SCOPE("name"). When built with -DPERF_COUNTERS (make perf),
+ * every call reads cycles, instructions, branch misses and L1 data cache read misses
+ * through perf_event_open on entry and exit, and adds the difference to the totals of
+ * that call site for the current maze. Without PERF_COUNTERS the macro compiles to nothing.
+ *
+ * Counters are opened per thread, so the background planner is measured too.
+ * The cost of reading the counters is measured once per thread and subtracted from every call.
+ * If the kernel or the machine does not provide a counter (e.g. in a VM without a PMU),
+ * it is reported as n/a and only call counts and wall time are collected for it.
+ */
+namespace PerfCounters {
+    enum Counter {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        COUNTER_MAX
+    };
+
+    // counter values at one point in time.
+    struct Sample {
+        uint64_t value[COUNTER_MAX];
+        uint64_t nanos;
+    };
+
+    // accumulated counters of one call site for one maze.
+    struct Totals {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> value[COUNTER_MAX];
+        std::atomic<uint64_t> nanos;
+    };
+
+    // a wrapped kernel. Sites register themselves on construction and live until the program exits.
+    struct Site {
+        explicit Site(const char *name);
+
+        const char *name;
+        Totals totals[MazeDefinitions::MAZE_NAME_MAX];
+        Site *next;
+    };
+
+    // attribute the following calls (from all threads) to maze index.
+    void setMaze(unsigned index);
+
+    // read the counters of the calling thread. Counters that are not available read as 0.
+    void read(Sample &sample);
+
+    // add the difference between two samples to site, minus the measurement overhead.
+    void add(Site &site, const Sample &begin, const Sample &end);
+
+    // print IPC and branch-miss figures per call site and maze, and per call site over all mazes.
+    void report(std::ostream &out);
+
+    class Scope {
+    public:
+        explicit Scope(Site &site) : site(site) {
+            read(begin);
+        }
+
+        ~Scope() {
+            Sample end;
+            read(end);
+            add(site, begin, end);
+        }
+
+    private:
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+
+        Site &site;
+        Sample begin;
+    };
+}
+
+#ifdef PERF_COUNTERS
+#define PERF_SCOPE(name) \
+    static PerfCounters::Site perfSite(name); \
+    PerfCounters::Scope perfScope(perfSite)
+#else
+#define PERF_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#include <cerrno>
+#include <cstdio>     // perror
+#include <fcntl.h>    // open
+#include <unistd.h>   // read, write
+#include "MouseMovement.h"
+#include "FloodFillEmbedded.h"
+#include "PtyLink.h"
+
+/**
+ * A stand-in for the mouse's firmware at the other end of PtyRun's line: the freestanding
+ * FloodFill (FloodFillEmbedded.h), driven only by the sensor frames that come in over the
+ * line, the way the control loop of the mouse would drive it from its serial port.
+ *
+ * It answers every sensor frame with a command frame until the line hangs up. A Finish
+ * starts a new search, should the simulator run the mouse again.
+ */
+
+namespace {
+    // read exactly len bytes, false once the line is closed.
+    bool readAll(int fd, uint8_t *in, unsigned len) {
+        for(unsigned done = 0; done < len; ) {
+            const ssize_t n = read(fd, in + done, len - done);
+            if(n < 0 && errno == EINTR)
+                continue;
+            if(n <= 0)
+                return false;
+            done += n;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    if(argc != 2) {
+        printf("Usage: %s PATH\n", argv[0]);
+        printf("\tPATH is the pseudo-terminal of a robot of PtyRun\n");
+        return -1;
+    }
+    // the simulator has made the line raw already.
+    const int fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if(fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    floodFillReset();
+    uint8_t sensors[PtyLink::SENSOR_FRAME];
+    while(readAll(fd, sensors, 1)) {
+        // out of step: drop bytes up to the next sync.
+        if(sensors[0] != PtyLink::SENSOR_SYNC || !readAll(fd, sensors + 1, PtyLink::SENSOR_FRAME - 1))
+            continue;
+        const uint8_t walls = sensors[3];
+        const int movement = floodFillNextMovement(sensors[1], sensors[2], walls & PtyLink::WALL_FRONT,
+                                                   walls & PtyLink::WALL_LEFT, walls & PtyLink::WALL_RIGHT);
+        const uint8_t command[PtyLink::COMMAND_FRAME] = { PtyLink::COMMAND_SYNC, (uint8_t)movement };
+        if(write(fd, command, sizeof(command)) != (ssize_t)sizeof(command))
+            break;
+        if(movement == Finish)
+            floodFillReset();
+    }
+    return 0;
+}
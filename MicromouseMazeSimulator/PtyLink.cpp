@@ -0,0 +1,132 @@
+#include <cerrno>
+#include <cstdlib>    // posix_openpt, grantpt, unlockpt, ptsname_r
+#include <cstring>    // strerror
+#include <fcntl.h>    // O_RDWR, O_NOCTTY, O_CLOEXEC
+#include <poll.h>
+#include <termios.h>  // cfmakeraw
+#include <unistd.h>   // read, write, close
+#include "PtyLink.h"
+
+namespace PtyLink {
+    int open(std::string &path, int &slave, std::string &error) {
+        slave = -1;
+        // close on exec: a planner started for one line must not keep another one open.
+        const int fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if(fd < 0) {
+            error = std::string("Cannot open a pseudo-terminal: ") + strerror(errno);
+            return -1;
+        }
+        char name[128];
+        if(grantpt(fd) != 0 || unlockpt(fd) != 0 || ptsname_r(fd, name, sizeof(name)) != 0) {
+            error = std::string("Cannot unlock the pseudo-terminal: ") + strerror(errno);
+            ::close(fd);
+            return -1;
+        }
+        // raw, before the planner can open it: no echo, no line editing, every byte as it is.
+        slave = ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+        struct termios raw;
+        if(slave < 0 || tcgetattr(slave, &raw) != 0) {
+            error = std::string("Cannot open ") + name + ": " + strerror(errno);
+            if(slave >= 0)
+                ::close(slave);
+            ::close(fd);
+            slave = -1;
+            return -1;
+        }
+        cfmakeraw(&raw);
+        tcsetattr(slave, TCSANOW, &raw);
+        path = name;
+        return fd;
+    }
+
+    bool exchange(int fd, const uint8_t *out, unsigned outLen, uint8_t *in, unsigned inLen,
+                  std::chrono::milliseconds timeout, std::string &error) {
+        for(unsigned done = 0; done < outLen; ) {
+            const ssize_t n = write(fd, out + done, outLen - done);
+            if(n < 0 && errno != EINTR) {
+                error = std::string("Cannot write to the planner: ") + strerror(errno);
+                return false;
+            }
+            done += n > 0 ? n : 0;
+        }
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+        for(unsigned done = 0; done < inLen; ) {
+            const long left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            struct pollfd p = {fd, POLLIN, 0};
+            const int ready = left > 0 ? poll(&p, 1, left) : 0;
+            if(ready == 0) {
+                error = "The planner did not answer in time";
+                return false;
+            }
+            if(ready < 0) {
+                if(errno == EINTR)
+                    continue;
+                error = std::string("Cannot wait for the planner: ") + strerror(errno);
+                return false;
+            }
+            const ssize_t n = read(fd, in + done, inLen - done);
+            if(n <= 0) {
+                if(n < 0 && errno == EINTR)
+                    continue;
+                // EIO once every descriptor of the planner's side is closed.
+                error = "The planner hung up";
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    template <unsigned LEN>
+    Robot<LEN>::Robot(std::chrono::milliseconds timeout)
+    : slave(-1), timeout(timeout) {
+        fd = PtyLink::open(path, slave, error);
+        // a run takes at most the step limit, 16 steps per cell by default.
+        latencies.reserve(16 * MazeDefinitions::Size<LEN>::CELLS);
+    }
+
+    template <unsigned LEN>
+    Robot<LEN>::~Robot() {
+        hangUp();
+    }
+
+    template <unsigned LEN>
+    void Robot<LEN>::hangUp() {
+        if(slave >= 0)
+            close(slave);
+        if(fd >= 0)
+            close(fd);
+        slave = fd = -1;
+    }
+
+    template <unsigned LEN>
+    MouseMovement Robot<LEN>::nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze) {
+        if(fd < 0)
+            return Finish;
+        const uint8_t sensors[SENSOR_FRAME] = {
+            SENSOR_SYNC, (uint8_t)x, (uint8_t)y,
+            (uint8_t)((maze.wallInFront() ? WALL_FRONT : 0) | (maze.wallOnLeft() ? WALL_LEFT : 0) | (maze.wallOnRight() ? WALL_RIGHT : 0))
+        };
+        uint8_t command[COMMAND_FRAME];
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if(!exchange(fd, sensors, SENSOR_FRAME, command, COMMAND_FRAME, timeout, error)) {
+            hangUp();
+            return Finish;
+        }
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        if(command[0] != COMMAND_SYNC || command[1] > Finish) {
+            error = "Malformed command from the planner";
+            hangUp();
+            return Finish;
+        }
+        // the planner has the line open, from now on its hanging up is noticed.
+        if(slave >= 0) {
+            close(slave);
+            slave = -1;
+        }
+        return (MouseMovement)command[1];
+    }
+
+    template class Robot<MazeDefinitions::MAZE_LEN>;
+    template class Robot<MazeDefinitions::HALF_SIZE_MAZE_LEN>;
+}
@@ -0,0 +1,121 @@
+#ifndef PtyLink_h
+#define PtyLink_h
+
+#include <stdint.h> // uint8_t, uint32_t
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "MazeDefinitions.h"
+#include "PathFinder.h"
+#include "MouseSession.h"
+
+/**
+ * Firmware in the loop: the simulator plays the robot to a planner running in another process,
+ * e.g. the mouse's own firmware built for the host, over a pseudo-terminal as if it were the
+ * robot's serial line.
+ *
+ * The protocol is lockstep and binary. For every move the simulator sends a sensor frame and
+ * the planner answers with a command frame:
+ *     sensors   SENSOR_SYNC, x, y, walls   (walls: WALL_FRONT | WALL_LEFT | WALL_RIGHT when closed)
+ *     command   COMMAND_SYNC, movement     (a MouseMovement; Finish ends the run)
+ * The planner sends nothing unasked. The simulator closes its side once the run is over, so
+ * reads on the planner's side fail then.
+ */
+namespace PtyLink {
+    const uint8_t SENSOR_SYNC = 0xa5;
+    const uint8_t COMMAND_SYNC = 0x5a;
+    const unsigned SENSOR_FRAME = 4;
+    const unsigned COMMAND_FRAME = 2;
+    const uint8_t WALL_FRONT = 1;
+    const uint8_t WALL_LEFT = 2;
+    const uint8_t WALL_RIGHT = 4;
+
+    /**
+     * Open a pseudo-terminal in raw mode.
+     * @param path: set to the path of the planner's side, e.g. /dev/pts/3
+     * @param slave: set to a descriptor of the planner's side, to keep it open until the planner has it
+     * @param error: set to why it could not be opened
+     * @return descriptor of the simulator's side, -1 on failure
+     */
+    int open(std::string &path, int &slave, std::string &error);
+
+    /**
+     * Send a frame and wait for the answer, at most timeout.
+     * @return false on a timeout, a closed line or a malformed answer, with error set
+     */
+    bool exchange(int fd, const uint8_t *out, unsigned outLen, uint8_t *in, unsigned inLen,
+                  std::chrono::milliseconds timeout, std::string &error);
+
+    /**
+     * The planner at the other end of a pseudo-terminal, as a PathFinder: nextMovement sends the
+     * walls the mouse senses and returns the command that comes back. The session, and the maze
+     * world behind it, keep the pose and the walls as for any PathFinder.
+     */
+    template <unsigned LEN>
+    class Robot : public BasicPathFinder<LEN> {
+    public:
+        /**
+         * Open the pseudo-terminal. See good and getPath.
+         * @param timeout: time the planner has to answer a sensor frame
+         */
+        explicit Robot(std::chrono::milliseconds timeout);
+
+        ~Robot();
+
+        inline bool good() const {
+            return fd >= 0;
+        }
+
+        // what went wrong: the pseudo-terminal, a timeout or a malformed command. Empty if nothing did.
+        inline const std::string &getError() const {
+            return error;
+        }
+
+        // the planner's side of the line, for it to open.
+        inline const std::string &getPath() const {
+            return path;
+        }
+
+        // Finish on any error, which getError tells from the planner finishing.
+        MouseMovement nextMovement(unsigned x, unsigned y, const BasicMouseSession<LEN> &maze);
+
+        // close the line, so the planner sees the end of the run.
+        void hangUp();
+
+        /**
+         * Round trips of the run, sensor frame written to command read, in nanoseconds and in the
+         * order they were made.
+         */
+        inline const std::vector<uint32_t> &getLatencies() const {
+            return latencies;
+        }
+
+        std::string getId() const {
+            return "";
+        }
+
+    protected:
+        int fd;
+        // the planner's side, kept open until its first answer so the line does not hang up before it connects.
+        int slave;
+        std::string path;
+        std::string error;
+        const std::chrono::milliseconds timeout;
+        std::vector<uint32_t> latencies;
+    };
+
+    /**
+     * Percentile of round trips, in nanoseconds.
+     * @param sorted: latencies in increasing order
+     * @param p: between 0 and 1
+     */
+    inline uint32_t percentile(const std::vector<uint32_t> &sorted, double p) {
+        if(sorted.empty())
+            return 0;
+        const size_t at = (size_t)(p * (sorted.size() - 1) + 0.5);
+        return sorted[at < sorted.size() ? at : sorted.size() - 1];
+    }
+}
+
+#endif
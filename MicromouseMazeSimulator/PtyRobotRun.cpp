@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm> // std::sort
+#include <memory>   // std::unique_ptr
+#include <sys/wait.h> // waitpid
+#include <unistd.h>   // fork, execl
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "MouseSession.h"
+#include "PtyLink.h"
+
+/**
+ * The simulator as N robots at once, each on a pseudo-terminal of its own (see PtyLink.h) and
+ * each in its own maze: robot i runs built-in maze (m + i) modulo the number of mazes.
+ *
+ * With -c CMD every robot starts `CMD PATH` for its planner, PATH being its line, e.g. the
+ * stand-in firmware (FirmwareRun). Without it the paths are printed and the robots wait for
+ * planners started by hand. Every robot is a session on its own thread and the sessions share
+ * the mazes, as in the simulator's own parallel modes. At the end each robot reports its steps
+ * and its round trips, then all of them the commands per second they got through together.
+ */
+
+namespace {
+    struct Options {
+        unsigned maze;
+        unsigned robots;
+        const char *command;
+        unsigned timeoutMillis;
+    };
+
+    // start the planner of a line, without waiting for it. -1 if it cannot be started.
+    pid_t startPlanner(const char *command, const std::string &path) {
+        const std::string line = std::string(command) + " " + path;
+        const pid_t pid = fork();
+        if(pid == 0) {
+            execl("/bin/sh", "sh", "-c", line.c_str(), (char *)NULL);
+            _exit(127);
+        }
+        return pid;
+    }
+
+    template <unsigned LEN>
+    int runRobots(const Options &options) {
+        typedef PtyLink::Robot<LEN> Robot;
+        const unsigned mazes = MazeDefinitions::Encodings<LEN>::COUNT;
+
+        std::vector<std::unique_ptr<Robot> > robots;
+        std::vector<std::unique_ptr<BasicMouseSession<LEN> > > sessions;
+        for(unsigned i = 0; i < options.robots; i++) {
+            robots.emplace_back(new Robot(std::chrono::milliseconds(options.timeoutMillis)));
+            if(!robots.back()->good()) {
+                std::cerr << robots.back()->getError() << std::endl;
+                return 1;
+            }
+            sessions.emplace_back(new BasicMouseSession<LEN>(BasicMazeWorld<LEN>::get((options.maze + i) % mazes), robots.back().get()));
+            // a planner that never finishes is cut off as the simulator would cut it off.
+            sessions.back()->setStepLimit(16 * MazeDefinitions::Size<LEN>::CELLS);
+        }
+
+        // the planners are started before any thread, fork copies only the calling one.
+        std::vector<pid_t> planners;
+        for(unsigned i = 0; i < options.robots; i++) {
+            if(!options.command) {
+                std::cout << "Robot " << i << " (maze " << (options.maze + i) % mazes << ") on " << robots[i]->getPath() << std::endl;
+                continue;
+            }
+            const pid_t pid = startPlanner(options.command, robots[i]->getPath());
+            if(pid < 0) {
+                std::cerr << "Cannot start " << options.command << std::endl;
+                return 1;
+            }
+            planners.push_back(pid);
+        }
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for(unsigned i = 0; i < options.robots; i++) {
+            threads.emplace_back([&robots, &sessions, i]() {
+                sessions[i]->start();
+                robots[i]->hangUp();
+            });
+        }
+        for(unsigned i = 0; i < options.robots; i++) {
+            threads[i].join();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // the planners see the line hang up and exit.
+        for(unsigned i = 0; i < planners.size(); i++) {
+            waitpid(planners[i], NULL, 0);
+        }
+
+        int failed = 0;
+        unsigned long commands = 0;
+        std::cout << std::fixed << std::setprecision(1);
+        for(unsigned i = 0; i < options.robots; i++) {
+            const Robot &robot = *robots[i];
+            const BasicMouseSession<LEN> &session = *sessions[i];
+            std::vector<uint32_t> sorted(robot.getLatencies());
+            std::sort(sorted.begin(), sorted.end());
+            commands += sorted.size();
+            std::cout << "Robot " << i << ", maze " << (options.maze + i) % mazes << ": " << session.getStepCount() << " steps, ";
+            if(!robot.getError().empty()) {
+                std::cout << robot.getError();
+                failed = 1;
+            } else {
+                std::cout << runOutcomeName(session.getOutcome());
+                failed |= session.wasCutOff();
+            }
+            std::cout << ", " << sorted.size() << " commands, round trip p50 " << PtyLink::percentile(sorted, 0.5) / 1000.0
+                      << " us, p99 " << PtyLink::percentile(sorted, 0.99) / 1000.0
+                      << " us, max " << (sorted.empty() ? 0 : sorted.back()) / 1000.0 << " us" << std::endl;
+        }
+        std::cout << options.robots << " robots, " << commands << " commands in " << seconds * 1000 << " ms: "
+                  << (seconds > 0 ? commands / seconds : 0) << " commands/s" << std::endl;
+        return failed;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    Options options = { 0, 1, NULL, 1000 };
+    unsigned size = MazeDefinitions::MAZE_LEN;
+    bool usage = false;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            size = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-m") == 0 && i+1 < argc) {
+            options.maze = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-n") == 0 && i+1 < argc) {
+            options.robots = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+            options.command = argv[++i];
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            options.timeoutMillis = atoi(argv[++i]);
+        } else {
+            usage = true;
+            break;
+        }
+    }
+    if(usage || options.robots == 0 || (size != MazeDefinitions::MAZE_LEN && size != MazeDefinitions::HALF_SIZE_MAZE_LEN)) {
+        std::cout << "Usage: " << argv[0] << " [-s 16|32] [-m N] [-n N] [-c CMD] [-t MS]" << std::endl;
+        std::cout << "\t-s 16|32 will run in the classic (default) or the half-size mazes" << std::endl;
+        std::cout << "\t-m N will start robot i in maze (N + i) modulo the number of mazes (default 0)" << std::endl;
+        std::cout << "\t-n N will run N robots at once, each on its own pseudo-terminal (default 1)" << std::endl;
+        std::cout << "\t-c CMD will run CMD PATH as the planner of every robot, e.g. -c ./FirmwareRun;" << std::endl;
+        std::cout << "\t       without it the paths are printed for planners started by hand" << std::endl;
+        std::cout << "\t-t MS will give up on a planner that does not answer within MS milliseconds (default 1000)" << std::endl;
+        return -1;
+    }
+
+    if(size == MazeDefinitions::HALF_SIZE_MAZE_LEN)
+        return runRobots<MazeDefinitions::HALF_SIZE_MAZE_LEN>(options);
+    return runRobots<MazeDefinitions::MAZE_LEN>(options);
+}
@@ -0,0 +1,213 @@
+#ifndef RelaxKernel_h
+#define RelaxKernel_h
+
+#include <stdint.h> // uint16_t
+#include <cstring>  // memset
+
+#include "BitVector256.h"
+#include "MazeDefinitions.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Whole-maze distance relaxation, a data parallel alternative to FloodFill's per cell
+ * reflood and assign_new_dis (-x option).
+ *
+ * Every active cell takes the distance min(distance of an open neighbor) + 1 until nothing
+ * changes. Cells that are not active keep their distance, and a cell with no open neighbor
+ * at a known distance is left alone. The result is the distance from each active cell to the
+ * nearest inactive one, so it does not depend on the order the cells are relaxed in.
+ *
+ * A column of the maze (x fixed, y = 0 .. LEN-1) is LEN 16 bit distances: one AVX2 register
+ * for 16x16, two SSE registers. Neighbors along the column are unaligned loads one cell
+ * before and after, the walls are bit masks expanded to lanes. Built without -mavx2 or
+ * -msse4.1 the same sweeps run one cell at a time.
+ */
+namespace Relax {
+    // distance of a cell no open neighbor leads to.
+    const uint16_t UNKNOWN = 0xffff;
+
+    template <unsigned LEN>
+    struct Field {
+        typedef typename BitVector<LEN>::Column Column;
+
+        // cells of column x are distance[x + 1][OFFSET .. OFFSET + LEN - 1]. The columns and
+        // cells around them are never written after clear, they only keep the loads of the edge
+        // cells in bounds.
+        static const unsigned OFFSET = 16;
+        static const unsigned STRIDE = LEN + 2 * OFFSET;
+
+        inline uint16_t &at(unsigned x, unsigned y) {
+            return distance[x + 1][OFFSET + y];
+        }
+
+        Field() {
+            clear();
+        }
+
+        // every distance UNKNOWN, every wall present, no cell active.
+        void clear() {
+            memset(distance, 0xff, sizeof(distance));
+            memset(north, 0, sizeof(north));
+            memset(south, 0, sizeof(south));
+            memset(east, 0, sizeof(east));
+            memset(west, 0, sizeof(west));
+            memset(active, 0, sizeof(active));
+        }
+
+        alignas(32) uint16_t distance[LEN + 2][STRIDE];
+        // bit y of column x is set when (x,y) is open to that side.
+        Column north[LEN];
+        Column south[LEN];
+        Column east[LEN];
+        Column west[LEN];
+        // bit y of column x is set when the distance of (x,y) is to be recomputed.
+        Column active[LEN];
+    };
+
+    // "AVX2", "SSE4.1" or "scalar", whichever relax was built with.
+    inline const char *instructionSet() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE4_1__)
+        return "SSE4.1";
+#else
+        return "scalar";
+#endif
+    }
+
+#if defined(__AVX2__)
+    // 16 lanes of 16 bits.
+    struct Lanes {
+        typedef __m256i V;
+        static const unsigned WIDTH = 16;
+
+        static inline V load(const uint16_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+        static inline void store(uint16_t *p, V v) { _mm256_storeu_si256((__m256i *)p, v); }
+        static inline V min(V a, V b) { return _mm256_min_epu16(a, b); }
+        static inline V plusOne(V a) { return _mm256_adds_epu16(a, _mm256_set1_epi16(1)); }
+        static inline V orNot(V a, V mask) { return _mm256_or_si256(a, _mm256_xor_si256(mask, _mm256_set1_epi16(-1))); }
+        static inline V andNot(V a, V b) { return _mm256_andnot_si256(a, b); }
+        static inline V equal(V a, V b) { return _mm256_cmpeq_epi16(a, b); }
+        static inline V select(V mask, V a, V b) { return _mm256_blendv_epi8(b, a, mask); }
+        static inline bool same(V a, V b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)) == -1; }
+        static inline V unknown() { return _mm256_set1_epi16(-1); }
+
+        // lane i is all ones if bit i of bits is set.
+        static inline V expand(unsigned bits) {
+            const V lane = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, (short)32768);
+            return _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16((short)bits), lane), lane);
+        }
+    };
+#elif defined(__SSE4_1__)
+    // 8 lanes of 16 bits.
+    struct Lanes {
+        typedef __m128i V;
+        static const unsigned WIDTH = 8;
+
+        static inline V load(const uint16_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+        static inline void store(uint16_t *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+        static inline V min(V a, V b) { return _mm_min_epu16(a, b); }
+        static inline V plusOne(V a) { return _mm_adds_epu16(a, _mm_set1_epi16(1)); }
+        static inline V orNot(V a, V mask) { return _mm_or_si128(a, _mm_xor_si128(mask, _mm_set1_epi16(-1))); }
+        static inline V andNot(V a, V b) { return _mm_andnot_si128(a, b); }
+        static inline V equal(V a, V b) { return _mm_cmpeq_epi16(a, b); }
+        static inline V select(V mask, V a, V b) { return _mm_blendv_epi8(b, a, mask); }
+        static inline bool same(V a, V b) { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) == 0xffff; }
+        static inline V unknown() { return _mm_set1_epi16(-1); }
+
+        static inline V expand(unsigned bits) {
+            const V lane = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+            return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16((short)bits), lane), lane);
+        }
+    };
+#endif
+
+    // relax column x once. Returns true if a distance changed.
+    template <unsigned LEN>
+    inline bool relaxColumn(Field<LEN> &f, unsigned x) {
+        uint16_t *column = &f.distance[x + 1][Field<LEN>::OFFSET];
+        const uint16_t *eastColumn = &f.distance[x + 2][Field<LEN>::OFFSET];
+        const uint16_t *westColumn = &f.distance[x][Field<LEN>::OFFSET];
+        bool changed = false;
+#if defined(__AVX2__) || defined(__SSE4_1__)
+        typedef typename Lanes::V V;
+        for(unsigned y = 0; y < LEN; y += Lanes::WIDTH) {
+            const unsigned mask = (1u << Lanes::WIDTH) - 1;
+            // a neighbor behind a wall counts as UNKNOWN: distance | ~open.
+            V best = Lanes::orNot(Lanes::load(column + y + 1), Lanes::expand((f.north[x] >> y) & mask));
+            best = Lanes::min(best, Lanes::orNot(Lanes::load(column + y - 1), Lanes::expand((f.south[x] >> y) & mask)));
+            best = Lanes::min(best, Lanes::orNot(Lanes::load(eastColumn + y), Lanes::expand((f.east[x] >> y) & mask)));
+            best = Lanes::min(best, Lanes::orNot(Lanes::load(westColumn + y), Lanes::expand((f.west[x] >> y) & mask)));
+
+            const V old = Lanes::load(column + y);
+            const V candidate = Lanes::plusOne(best);
+            // keep the old distance of inactive cells and of cells with no known neighbor.
+            const V update = Lanes::andNot(Lanes::equal(best, Lanes::unknown()), Lanes::expand((f.active[x] >> y) & mask));
+            const V result = Lanes::select(update, candidate, old);
+            if(!Lanes::same(result, old)) {
+                Lanes::store(column + y, result);
+                changed = true;
+            }
+        }
+#else
+        // the same as the vector code, a cell at a time. The column is written once all of
+        // it has been read, as if it were a single register.
+        uint16_t next[LEN];
+        for(unsigned y = 0; y < LEN; y++) {
+            uint16_t best = UNKNOWN;
+            if((f.north[x] >> y) & 1 && column[y + 1] < best)
+                best = column[y + 1];
+            if((f.south[x] >> y) & 1 && column[y - 1] < best)
+                best = column[y - 1];
+            if((f.east[x] >> y) & 1 && eastColumn[y] < best)
+                best = eastColumn[y];
+            if((f.west[x] >> y) & 1 && westColumn[y] < best)
+                best = westColumn[y];
+            next[y] = ((f.active[x] >> y) & 1) && best != UNKNOWN ? (best + 1 < UNKNOWN ? best + 1 : UNKNOWN) : column[y];
+        }
+        for(unsigned y = 0; y < LEN; y++) {
+            changed |= next[y] != column[y];
+            column[y] = next[y];
+        }
+#endif
+        return changed;
+    }
+
+    /**
+     * Relax the field until no distance changes.
+     * Sweeps the columns east then west, relaxing each one until it is stable so that a
+     * corridor along the column is done in one go. A column is only relaxed again once a
+     * neighboring column has changed.
+     * @return number of sweeps
+     */
+    template <unsigned LEN>
+    unsigned relax(Field<LEN> &f) {
+        // A region with no way out counts up forever. Real distances settle long before this.
+        const unsigned MAX_SWEEPS = 2 * MazeDefinitions::Size<LEN>::MAX_DISTANCE;
+        // bit x is set while column x may not be stable.
+        uint64_t dirty = ((uint64_t)1 << LEN) - 1;
+        unsigned sweeps = 0;
+        while(dirty && sweeps < MAX_SWEEPS) {
+            for(unsigned i = 0; i < LEN; i++) {
+                const unsigned x = sweeps % 2 ? LEN - 1 - i : i;
+                if(!((dirty >> x) & 1))
+                    continue;
+                dirty &= ~((uint64_t)1 << x);
+                // a change travels at most one cell along the column per pass.
+                bool changed = false;
+                for(unsigned pass = 0; pass < LEN && relaxColumn(f, x); pass++) {
+                    changed = true;
+                }
+                if(changed)
+                    dirty |= ((uint64_t)5 << x >> 1) & (((uint64_t)1 << LEN) - 1);
+            }
+            sweeps++;
+        }
+        return sweeps;
+    }
+}
+
+#endif
@@ -0,0 +1,389 @@
+#include <cstring>   // memcmp
+#include <sstream>
+#include <algorithm> // std::upper_bound
+#include "Replay.h"
+
+namespace Replay {
+    namespace {
+        const char MAGIC[8] = {'M', 'M', 'R', 'E', 'P', 'L', 'A', 'Y'};
+        const char END_MAGIC[8] = {'M', 'M', 'R', 'P', 'L', 'E', 'N', 'D'};
+        const uint8_t VERSION = 1;
+        const uint8_t FLAG_DISTANCES = 1;
+        const uint8_t FLAG_MIRRORED = 2;
+        // what follows the index: step count, offset of the index and END_MAGIC.
+        const size_t TRAILER = 4 + 8 + sizeof(END_MAGIC);
+
+        const uint8_t KEYFRAME = 7;
+        const uint8_t MOVEMENT = 7;
+        const unsigned WALL_SHIFT = 3;
+        const uint8_t CHANGES = 0x80;
+
+        inline void put(std::vector<uint8_t> &out, uint64_t value, unsigned bytes) {
+            for(unsigned b = 0; b < bytes; b++) {
+                out.push_back((value >> (8 * b)) & 0xff);
+            }
+        }
+
+        inline void putVarint(std::vector<uint8_t> &out, unsigned value) {
+            while(value >= 0x80) {
+                out.push_back((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out.push_back(value);
+        }
+
+        // the reading side: offset is where to read, set to 0 when past the end.
+        inline uint64_t get(const std::vector<uint8_t> &in, size_t &offset, unsigned bytes) {
+            if(offset == 0 || offset + bytes > in.size()) {
+                offset = 0;
+                return 0;
+            }
+            uint64_t value = 0;
+            for(unsigned b = 0; b < bytes; b++) {
+                value |= (uint64_t)in[offset + b] << (8 * b);
+            }
+            offset += bytes;
+            return value;
+        }
+
+        inline unsigned getVarint(const std::vector<uint8_t> &in, size_t &offset) {
+            unsigned value = 0;
+            for(unsigned shift = 0; offset != 0 && shift < 32; shift += 7) {
+                if(offset >= in.size()) {
+                    offset = 0;
+                    break;
+                }
+                const uint8_t b = in[offset++];
+                value |= (unsigned)(b & 0x7f) << shift;
+                if(!(b & 0x80))
+                    return value;
+            }
+            offset = 0;
+            return 0;
+        }
+
+        void move(Frame &frame) {
+            switch(frame.movement) {
+                case MoveForward:
+                case MoveBackward: {
+                    const Dir d = frame.movement == MoveForward ? frame.heading : opposite(frame.heading);
+                    frame.x += d == EAST ? 1 : d == WEST ? -1 : 0;
+                    frame.y += d == NORTH ? 1 : d == SOUTH ? -1 : 0;
+                    break;
+                }
+                case TurnClockwise:
+                    frame.heading = clockwise(frame.heading);
+                    break;
+                case TurnCounterClockwise:
+                    frame.heading = counterClockwise(frame.heading);
+                    break;
+                case TurnAround:
+                    frame.heading = opposite(frame.heading);
+                    break;
+                case Wait:
+                case Finish:
+                default:
+                    break;
+            }
+        }
+    }
+
+    Writer::Writer(const char *path, unsigned len, unsigned maze, uint64_t hash, bool mirrored, const std::string &pathFinder,
+                   bool distances)
+    : out(path, std::ios::binary | std::ios::trunc), len(len), withDistances(distances), closed(false), written(0), records(0),
+      walls(len * len, 0), distances(len * len, NO_DISTANCE), next(len * len, NO_DISTANCE) {
+        buffer.reserve(1 << 17);
+        changes.reserve(len * len * 6);
+        buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+        put(buffer, VERSION, 1);
+        put(buffer, len, 1);
+        put(buffer, (distances ? FLAG_DISTANCES : 0) | (mirrored ? FLAG_MIRRORED : 0), 1);
+        put(buffer, maze, 4);
+        put(buffer, hash, 8);
+        put(buffer, pathFinder.size(), 2);
+        buffer.insert(buffer.end(), pathFinder.begin(), pathFinder.end());
+    }
+
+    Writer::~Writer() {
+        close();
+    }
+
+    void Writer::keyframe(unsigned x, unsigned y, Dir heading) {
+        index.push_back(std::make_pair((uint32_t)records, written + buffer.size()));
+        put(buffer, KEYFRAME, 1);
+        put(buffer, records, 4);
+        put(buffer, x, 1);
+        put(buffer, y, 1);
+        put(buffer, heading, 1);
+        buffer.insert(buffer.end(), walls.begin(), walls.end());
+        if(withDistances) {
+            for(size_t i = 0; i < distances.size(); i++) {
+                put(buffer, distances[i], 2);
+            }
+        }
+    }
+
+    void Writer::step(unsigned x, unsigned y, Dir heading, unsigned cellWalls, MouseMovement movement) {
+        if(closed)
+            return;
+        if(records % KEYFRAME_INTERVAL == 0)
+            keyframe(x, y, heading);
+
+        walls[x * len + y] = (cellWalls & 15) | SENSED;
+        uint8_t tag = movement | (cellWalls & 15) << WALL_SHIFT;
+        unsigned count = 0;
+        if(withDistances) {
+            changes.clear();
+            for(unsigned i = 0; i < len * len; i++) {
+                if(next[i] != distances[i]) {
+                    putVarint(changes, i);
+                    putVarint(changes, next[i]);
+                    distances[i] = next[i];
+                    count++;
+                }
+            }
+        }
+        if(count) {
+            put(buffer, tag | CHANGES, 1);
+            putVarint(buffer, count);
+            buffer.insert(buffer.end(), changes.begin(), changes.end());
+        } else {
+            put(buffer, tag, 1);
+        }
+        records++;
+        if(buffer.size() >= (1 << 16))
+            flush();
+    }
+
+    void Writer::flush() {
+        out.write((const char *)&buffer[0], buffer.size());
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    bool Writer::close() {
+        if(closed)
+            return good();
+        closed = true;
+        const uint64_t indexOffset = written + buffer.size();
+        put(buffer, index.size(), 4);
+        for(size_t k = 0; k < index.size(); k++) {
+            put(buffer, index[k].first, 4);
+            put(buffer, index[k].second, 8);
+        }
+        put(buffer, records, 4);
+        put(buffer, indexOffset, 8);
+        buffer.insert(buffer.end(), END_MAGIC, END_MAGIC + sizeof(END_MAGIC));
+        flush();
+        out.close();
+        return good();
+    }
+
+    Reader::Reader(const char *path)
+    : len(0), maze(0), hash(0), mirrored(false), withDistances(false), firstRecord(0), steps(0) {
+        std::ifstream in(path, std::ios::binary);
+        if(!in) {
+            error = std::string("cannot open ") + path;
+            return;
+        }
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if(data.size() < sizeof(MAGIC) + 17 || memcmp(&data[0], MAGIC, sizeof(MAGIC)) != 0) {
+            error = std::string(path) + " is not a replay";
+            return;
+        }
+
+        size_t offset = sizeof(MAGIC);
+        const unsigned version = get(data, offset, 1);
+        len = get(data, offset, 1);
+        const unsigned flags = get(data, offset, 1);
+        maze = get(data, offset, 4);
+        hash = get(data, offset, 8);
+        const unsigned idLength = get(data, offset, 2);
+        if(version != VERSION || len == 0 || offset == 0 || offset + idLength > data.size()) {
+            error = std::string(path) + " is a replay of another version or is damaged";
+            return;
+        }
+        pathFinder.assign(data.begin() + offset, data.begin() + offset + idLength);
+        firstRecord = offset + idLength;
+        withDistances = flags & FLAG_DISTANCES;
+        mirrored = flags & FLAG_MIRRORED;
+
+        // the index, if the writer got to write it.
+        size_t trailer = data.size() - TRAILER;
+        if(data.size() >= firstRecord + TRAILER && memcmp(&data[data.size() - sizeof(END_MAGIC)], END_MAGIC, sizeof(END_MAGIC)) == 0) {
+            steps = get(data, trailer, 4);
+            size_t at = get(data, trailer, 8);
+            const size_t keyframes = get(data, at, 4);
+            for(size_t k = 0; k < keyframes && at; k++) {
+                const uint32_t step = get(data, at, 4);
+                index.push_back(std::make_pair(step, get(data, at, 8)));
+            }
+            if(at && trailer)
+                return;
+            index.clear();
+        }
+        scan();
+    }
+
+    void Reader::scan() {
+        steps = 0;
+        Frame frame;
+        for(size_t offset = firstRecord; offset < data.size(); ) {
+            size_t after;
+            if((data[offset] & MOVEMENT) == KEYFRAME) {
+                after = readKeyframe(offset, frame);
+                if(after && frame.step == steps)
+                    index.push_back(std::make_pair((uint32_t)steps, offset));
+            } else {
+                after = readRecord(offset, frame);
+                steps += after != 0;
+            }
+            if(!after)
+                break;
+            offset = after;
+        }
+        if(index.empty())
+            error = "replay has no complete keyframe";
+    }
+
+    size_t Reader::readKeyframe(size_t offset, Frame &frame) const {
+        offset++;
+        frame.step = get(data, offset, 4);
+        frame.x = get(data, offset, 1);
+        frame.y = get(data, offset, 1);
+        frame.heading = (Dir)get(data, offset, 1);
+        frame.movement = Wait;
+        const size_t cells = len * len;
+        if(!offset || offset + cells > data.size())
+            return 0;
+        frame.walls.assign(data.begin() + offset, data.begin() + offset + cells);
+        offset += cells;
+        frame.distances.assign(cells, NO_DISTANCE);
+        if(withDistances) {
+            for(size_t i = 0; i < cells; i++) {
+                frame.distances[i] = get(data, offset, 2);
+            }
+        }
+        if(frame.x >= len || frame.y >= len || frame.heading >= INVALID)
+            return 0;
+        return offset;
+    }
+
+    size_t Reader::readRecord(size_t offset, Frame &frame) const {
+        if(offset >= data.size())
+            return 0;
+        const uint8_t tag = data[offset++];
+        if((tag & MOVEMENT) > Finish)
+            return 0;
+        frame.movement = (MouseMovement)(tag & MOVEMENT);
+        if(frame.x < len && frame.y < len && !frame.walls.empty())
+            frame.walls[frame.x * len + frame.y] = ((tag >> WALL_SHIFT) & 15) | SENSED;
+        if(tag & CHANGES) {
+            const unsigned count = getVarint(data, offset);
+            for(unsigned k = 0; k < count && offset; k++) {
+                const unsigned cell = getVarint(data, offset);
+                const unsigned distance = getVarint(data, offset);
+                if(cell < frame.distances.size())
+                    frame.distances[cell] = distance;
+            }
+        }
+        frame.nextRecord = offset;
+        return offset;
+    }
+
+    bool Reader::seek(unsigned long step, Frame &frame) const {
+        if(step >= steps || index.empty())
+            return false;
+        // the last keyframe at or before step.
+        std::vector<std::pair<uint32_t, uint64_t> >::const_iterator k =
+            std::upper_bound(index.begin(), index.end(), std::make_pair((uint32_t)step, ~(uint64_t)0));
+        if(k == index.begin())
+            return false;
+        --k;
+        size_t offset = readKeyframe(k->second, frame);
+        if(!offset || !readRecord(offset, frame))
+            return false;
+        while(frame.step < step) {
+            if(!next(frame))
+                return false;
+        }
+        return true;
+    }
+
+    bool Reader::next(Frame &frame) const {
+        if(frame.step + 1 >= steps)
+            return false;
+        size_t offset = frame.nextRecord;
+        // a keyframe holds what frame already has.
+        if(offset < data.size() && (data[offset] & MOVEMENT) == KEYFRAME)
+            offset += 1 + 4 + 3 + len * len * (withDistances ? 3 : 1);
+        move(frame);
+        frame.step++;
+        if(frame.x >= len || frame.y >= len)
+            return false;
+        return readRecord(offset, frame) != 0;
+    }
+
+    // the maze as the mouse knew it at frame, drawn like BasicMouseSession::draw with the distances as cell info.
+    std::string draw(const Frame &frame, unsigned len) {
+        const size_t infoLen = 5;
+        const size_t cellWidth = infoLen + 1;
+        std::ostringstream out;
+
+        // a wall is known closed if either cell next to it was sensed with it closed.
+        struct Known {
+            const Frame &frame;
+            unsigned len;
+            bool closed(unsigned x, unsigned y, Dir d) const {
+                const uint8_t w = frame.walls[x * len + y];
+                if(w & SENSED)
+                    return w & (1 << d);
+                switch(d) {
+                    case NORTH:
+                        return y + 1 == len || (frame.walls[x * len + y + 1] & (SENSED | 1 << SOUTH)) == (SENSED | 1 << SOUTH);
+                    case SOUTH:
+                        return y == 0 || (frame.walls[x * len + y - 1] & (SENSED | 1 << NORTH)) == (SENSED | 1 << NORTH);
+                    case EAST:
+                        return x + 1 == len || (frame.walls[(x + 1) * len + y] & (SENSED | 1 << WEST)) == (SENSED | 1 << WEST);
+                    case WEST:
+                        return x == 0 || (frame.walls[(x - 1) * len + y] & (SENSED | 1 << EAST)) == (SENSED | 1 << EAST);
+                    case INVALID:
+                    default:
+                        return false;
+                }
+            }
+        } known = {frame, len};
+
+        for(unsigned row = 0; row < len; row++) {
+            const unsigned y = len - row - 1;
+            std::string upDown("*"), leftRight;
+            for(unsigned x = 0; x < len; x++) {
+                std::string cellInfo;
+                const uint16_t d = frame.distances.empty() ? NO_DISTANCE : frame.distances[x * len + y];
+                if(d != NO_DISTANCE) {
+                    std::ostringstream info;
+                    info << d;
+                    cellInfo = info.str().substr(0, infoLen);
+                } else {
+                    cellInfo.append(cellWidth / 2, ' ');
+                }
+                if(x == frame.x && y == frame.y) {
+                    const char arrows[] = {'^', 'V', '>', '<'};
+                    cellInfo += frame.heading < INVALID ? arrows[frame.heading] : '?';
+                }
+                if(cellInfo.length() < cellWidth) {
+                    cellInfo.append(cellWidth - cellInfo.length(), ' ');
+                }
+                upDown += std::string(cellWidth, known.closed(x, y, NORTH) ? '-' : ' ') + "*";
+                leftRight += (known.closed(x, y, WEST) ? "|" : " ") + cellInfo;
+            }
+            leftRight += known.closed(len - 1, y, EAST) ? "|" : " ";
+            out << upDown << '\n' << leftRight << '\n';
+        }
+        out << "*";
+        for(unsigned x = 0; x < len; x++) {
+            out << std::string(cellWidth, '-') << "*";
+        }
+        return out.str();
+    }
+}
@@ -0,0 +1,220 @@
+#ifndef Replay_h
+#define Replay_h
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstddef>  // size_t
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "Dir.h"
+#include "PathFinder.h"
+
+/**
+ * Binary replays of runs: what the mouse sensed and did at every step, written while it runs,
+ * and read back to rebuild any step without running the PathFinder.
+ *
+ * A replay starts with a header (maze, size, canonical hash, PathFinder id) followed by one
+ * record per nextMovement call:
+ *     tag byte   bits 0-2 the movement, bits 3-6 the walls around the cell (1 << Dir, set when
+ *                closed), bit 7 set when distance changes follow
+ *     changes    with bit 7: a varint count, then for each changed cell a varint cell number
+ *                (x * LEN + y) and a varint distance
+ * Every KEYFRAME_INTERVAL records a keyframe (tag 7, not a movement) comes first, holding the
+ * pose, the walls sensed so far and the whole distance field, so a step is at most an interval
+ * of records away from a complete state. An index of the keyframes ends the file. Numbers are
+ * little endian.
+ *
+ * A record without distance changes is one byte, so a replay is written at disk speed and
+ * costs the run little more than a byte per step.
+ */
+namespace Replay {
+    // distance of a cell the PathFinder keeps none for.
+    const uint16_t NO_DISTANCE = 0xffff;
+    // bit of a sensed cell in Frame::walls, besides its walls (1 << Dir).
+    const uint8_t SENSED = 1 << 4;
+
+    /**
+     * The state of a run at one step: where the mouse was when the PathFinder was asked,
+     * what it returned, everything sensed up to then and the distances it had afterwards.
+     */
+    struct Frame {
+        unsigned long step;
+        unsigned x;
+        unsigned y;
+        Dir heading;
+        MouseMovement movement;
+        // by cell number x * len + y: 1 << Dir for each closed side, SENSED once the mouse has been there.
+        std::vector<uint8_t> walls;
+        // by cell number, NO_DISTANCE when unknown.
+        std::vector<uint16_t> distances;
+        // where the record of the next step starts in the replay.
+        size_t nextRecord;
+    };
+
+    /**
+     * Writes a replay. Hand it to BasicMouseSession::setRecorder before start().
+     */
+    class Writer {
+    public:
+        static const unsigned KEYFRAME_INTERVAL = 64;
+
+        /**
+         * @param path: file to write
+         * @param len: side of the maze
+         * @param maze: built-in maze number
+         * @param hash: canonical hash of the maze (see BasicMazeWorld::getCanonicalHash)
+         * @param mirrored: the maze is the mirror image of the hashed one
+         * @param pathFinder: PathFinder id (see BasicPathFinder::getId)
+         * @param distances: record the PathFinder's distance field as well
+         */
+        Writer(const char *path, unsigned len, unsigned maze, uint64_t hash, bool mirrored, const std::string &pathFinder,
+               bool distances);
+
+        ~Writer();
+
+        // false once something could not be written.
+        inline bool good() const {
+            return out.good();
+        }
+
+        inline bool hasDistances() const {
+            return withDistances;
+        }
+
+        /**
+         * Where to put the distance field of the step about to be recorded, len * len cells by
+         * cell number, when hasDistances.
+         */
+        inline uint16_t *distanceBuffer() {
+            return &next[0];
+        }
+
+        /**
+         * Record a nextMovement call.
+         * @param x, y, heading: pose of the mouse when the PathFinder was asked
+         * @param walls: 1 << Dir for each closed side of the cell
+         * @param movement: what it returned
+         */
+        void step(unsigned x, unsigned y, Dir heading, unsigned walls, MouseMovement movement);
+
+        /**
+         * Write the keyframe index and close the file. Called by the destructor otherwise.
+         * @return false if the replay could not be written completely
+         */
+        bool close();
+
+    protected:
+        void keyframe(unsigned x, unsigned y, Dir heading);
+        void flush();
+
+        std::ofstream out;
+        const unsigned len;
+        const bool withDistances;
+        bool closed;
+        // bytes not written yet, and the bytes written before them.
+        std::vector<uint8_t> buffer;
+        std::vector<uint8_t> changes;
+        uint64_t written;
+        unsigned long records;
+        // state as of the last record, for keyframes and distance changes.
+        std::vector<uint8_t> walls;
+        std::vector<uint16_t> distances;
+        std::vector<uint16_t> next;
+        // step and file offset of every keyframe.
+        std::vector<std::pair<uint32_t, uint64_t> > index;
+    };
+
+    /**
+     * Reads a replay, all of it into memory, and rebuilds its steps.
+     */
+    class Reader {
+    public:
+        /**
+         * @param path: replay to read. See good and getError.
+         */
+        explicit Reader(const char *path);
+
+        inline bool good() const {
+            return error.empty();
+        }
+
+        // why the replay could not be read, empty if it could.
+        inline const std::string &getError() const {
+            return error;
+        }
+
+        inline unsigned getLen() const {
+            return len;
+        }
+
+        inline unsigned getMaze() const {
+            return maze;
+        }
+
+        inline uint64_t getHash() const {
+            return hash;
+        }
+
+        inline bool isMirrored() const {
+            return mirrored;
+        }
+
+        inline const std::string &getPathFinder() const {
+            return pathFinder;
+        }
+
+        inline bool hasDistances() const {
+            return withDistances;
+        }
+
+        // records, one per nextMovement call, the final Finish included.
+        inline unsigned long getSteps() const {
+            return steps;
+        }
+
+        inline size_t getKeyframes() const {
+            return index.size();
+        }
+
+        /**
+         * Rebuild a step from the keyframe before it.
+         * @return false if step is out of range
+         */
+        bool seek(unsigned long step, Frame &frame) const;
+
+        /**
+         * The step after frame, which has to come from this reader.
+         * @return false after the last step
+         */
+        bool next(Frame &frame) const;
+
+    protected:
+        // read the keyframe or the record at offset into frame. @return offset of what follows, 0 if malformed
+        size_t readKeyframe(size_t offset, Frame &frame) const;
+        size_t readRecord(size_t offset, Frame &frame) const;
+        // scan the records when the index is missing, e.g. the writer did not finish.
+        void scan();
+
+        std::string error;
+        std::vector<uint8_t> data;
+        unsigned len;
+        unsigned maze;
+        uint64_t hash;
+        bool mirrored;
+        std::string pathFinder;
+        bool withDistances;
+        size_t firstRecord;
+        unsigned long steps;
+        // step and offset of every keyframe.
+        std::vector<std::pair<uint32_t, uint64_t> > index;
+    };
+
+    /**
+     * The maze as the mouse knew it at frame, drawn like BasicMouseSession::draw with the distances as cell info.
+     * A wall is drawn if either cell next to it was sensed with it closed.
+     */
+    std::string draw(const Frame &frame, unsigned len);
+}
+
+#endif
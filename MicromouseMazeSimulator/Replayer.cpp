@@ -0,0 +1,126 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>  // atol, rand
+#include <cstring>  // strcmp
+#include <chrono>
+#include "MazeDefinitions.h"
+#include "MazeWorld.h"
+#include "Replay.h"
+
+/**
+ * Plays back a replay written with `run -w FILE` without running the PathFinder.
+ *
+ * By default it prints what was recorded and draws the last step. A step can be drawn on its
+ * own (-k), every step in order (-a), and seeking can be timed (-r). When the replay is of a
+ * built-in maze, every wall the mouse sensed is checked against the maze.
+ */
+
+// walls the mouse sensed that the built-in maze does not have, or the other way around.
+template <unsigned LEN>
+unsigned long checkWalls(const Replay::Reader &reader) {
+    const BasicMazeWorld<LEN> &world = BasicMazeWorld<LEN>::get(reader.getMaze());
+    bool mirrored;
+    if(world.getCanonicalHash(mirrored) != reader.getHash() || mirrored != reader.isMirrored())
+        return ~0ul;
+    Replay::Frame frame;
+    if(!reader.seek(reader.getSteps() - 1, frame))
+        return ~0ul;
+    unsigned long wrong = 0;
+    const Dir sides[] = {NORTH, SOUTH, EAST, WEST};
+    for(unsigned x = 0; x < LEN; x++) {
+        for(unsigned y = 0; y < LEN; y++) {
+            const uint8_t w = frame.walls[x * LEN + y];
+            for(unsigned s = 0; (w & Replay::SENSED) && s < 4; s++) {
+                wrong += ((w >> sides[s]) & 1) == world.isOpen(x, y, sides[s]);
+            }
+        }
+    }
+    return wrong;
+}
+
+int main(int argc, char * argv[]) {
+    const char *path = NULL;
+    long step = -1;
+    bool all = false;
+    unsigned long seeks = 0;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-k") == 0 && i+1 < argc) {
+            step = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-a") == 0) {
+            all = true;
+        } else if(strcmp(argv[i], "-r") == 0 && i+1 < argc) {
+            seeks = atol(argv[++i]);
+        } else if(argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if(!path) {
+        std::cout << "Usage: " << argv[0] << " FILE [-k N] [-a] [-r N]" << std::endl;
+        std::cout << "\tFILE is a replay written by run -w FILE" << std::endl;
+        std::cout << "\t-k N will draw step N instead of the last one" << std::endl;
+        std::cout << "\t-a will draw every step in order" << std::endl;
+        std::cout << "\t-r N will time N seeks to random steps" << std::endl;
+        return -1;
+    }
+
+    Replay::Reader reader(path);
+    if(!reader.good()) {
+        std::cerr << reader.getError() << std::endl;
+        return 1;
+    }
+    const unsigned len = reader.getLen();
+    std::cout << "Maze " << reader.getMaze() << " (" << len << "x" << len << ", hash " << std::hex << std::setw(16)
+              << std::setfill('0') << reader.getHash() << std::dec << std::setfill(' ') << (reader.isMirrored() ? ", mirrored" : "")
+              << "), PathFinder " << (reader.getPathFinder().empty() ? "unnamed" : reader.getPathFinder()) << ", "
+              << reader.getSteps() << " steps, " << reader.getKeyframes() << " keyframes"
+              << (reader.hasDistances() ? ", with distances" : "") << std::endl;
+
+    unsigned long wrong = ~0ul;
+    if(len == MazeDefinitions::MAZE_LEN)
+        wrong = checkWalls<MazeDefinitions::MAZE_LEN>(reader);
+    else if(len == MazeDefinitions::HALF_SIZE_MAZE_LEN)
+        wrong = checkWalls<MazeDefinitions::HALF_SIZE_MAZE_LEN>(reader);
+    if(wrong == ~0ul)
+        std::cout << "Not a built-in maze, walls not checked" << std::endl;
+    else
+        std::cout << "Sensed walls checked against built-in maze " << reader.getMaze() << ": " << wrong << " wrong" << std::endl;
+
+    Replay::Frame frame;
+    if(all) {
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        bool more = reader.seek(0, frame);
+        for(; more; more = reader.next(frame)) {
+            std::cout << "Step " << frame.step << ": (" << frame.x << "," << frame.y << ") " << movementName(frame.movement) << std::endl
+                      << Replay::draw(frame, len) << std::endl << std::endl;
+        }
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        std::cerr << reader.getSteps() << " steps drawn in " << nanos / 1e6 << " ms" << std::endl;
+    } else {
+        const unsigned long shown = step < 0 ? reader.getSteps() - 1 : step;
+        if(!reader.seek(shown, frame)) {
+            std::cerr << "No step " << shown << ", the replay has " << reader.getSteps() << std::endl;
+            return 1;
+        }
+        std::cout << "Step " << frame.step << ": (" << frame.x << "," << frame.y << ") " << movementName(frame.movement) << std::endl
+                  << Replay::draw(frame, len) << std::endl;
+    }
+
+    if(seeks) {
+        srand(1);
+        unsigned long checksum = 0;
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for(unsigned long i = 0; i < seeks; i++) {
+            reader.seek(rand() % reader.getSteps(), frame);
+            checksum += frame.x + frame.y;
+        }
+        const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << seeks << " random seeks: " << nanos / seeks << " ns per seek (" << checksum << ")" << std::endl;
+    }
+    return wrong == ~0ul || wrong == 0 ? 0 : 1;
+}
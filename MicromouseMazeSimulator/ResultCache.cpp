@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <functional> // std::hash
+#include <sys/stat.h> // mkdir
+#include <unistd.h>   // getpid, gethostname
+#include "ResultCache.h"
+
+namespace {
+    // written in front of every entry, a file that does not start with one is not one.
+    const char *const FORMAT = "micromouse-result-2";
+    const char *const TIMING_FORMAT = "micromouse-timing-1";
+
+    // temporary files of this process, so two writers never share one.
+    std::atomic<unsigned long> temporaries(0);
+
+    // append a part of a key, which is a file name.
+    void appendSafe(std::ostringstream &out, const std::string &part) {
+        for(size_t i = 0; i < part.size(); i++) {
+            const char c = part[i];
+            const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+            out << (safe ? c : '_');
+        }
+    }
+}
+
+ResultCache::ResultCache(const std::string &directory)
+: directory(directory), hits(0), misses(0) {
+    // fails harmlessly if it exists. If it cannot be created every store fails, and the runs are simulated.
+    mkdir(directory.c_str(), 0777);
+}
+
+std::string ResultCache::key(unsigned size, uint64_t mazeHash, bool mirrored, const std::string &pathFinder, unsigned version) {
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)mazeHash);
+
+    std::ostringstream out;
+    out << size << "-" << hash << "-" << (mirrored ? "m" : "n") << "-";
+    appendSafe(out, pathFinder);
+    out << "-v" << version;
+    return out.str();
+}
+
+std::string ResultCache::timingKey(const std::string &key, const std::string &build) {
+    std::ostringstream out;
+    out << key << "-";
+    appendSafe(out, build);
+    return out.str();
+}
+
+std::string ResultCache::buildId() {
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    // the simulator is built from all of its sources at once, so this is the time of the whole build.
+    char build[17];
+    snprintf(build, sizeof(build), "%016llx", (unsigned long long)std::hash<std::string>()(std::string(__VERSION__) + " " + __DATE__ + " " + __TIME__));
+    return std::string(host) + "-" + build;
+}
+
+std::string ResultCache::path(const std::string &key) const {
+    return directory + "/" + key;
+}
+
+bool ResultCache::load(const std::string &key, Result &result) {
+    std::ifstream in(path(key).c_str());
+    std::string format, storedKey;
+    Result r(result);
+    // a partly written entry never gets here (see write), this only rejects files that are not entries.
+    if(in >> format >> storedKey >> r.steps >> r.turns >> r.routeLength >> r.outcome
+       && format == FORMAT && storedKey == key) {
+        result = r;
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool ResultCache::store(const std::string &key, const Result &result) {
+    std::ostringstream entry;
+    entry << FORMAT << " " << key << " " << result.steps << " " << result.turns << " " << result.routeLength << " "
+          << (result.outcome.empty() ? "unknown" : result.outcome) << "\n";
+    return write(key, entry.str());
+}
+
+bool ResultCache::loadTimings(const std::string &key, Result &result) {
+    std::ifstream in(path(key).c_str());
+    std::string format, storedKey;
+    Result r(result);
+    if(in >> format >> storedKey >> r.runNanos >> r.refloodCycles >> r.assignCycles
+       && format == TIMING_FORMAT && storedKey == key) {
+        result = r;
+        return true;
+    }
+    return false;
+}
+
+bool ResultCache::storeTimings(const std::string &key, const Result &result) {
+    std::ostringstream entry;
+    entry.precision(17);
+    entry << TIMING_FORMAT << " " << key << " " << result.runNanos << " " << result.refloodCycles << " " << result.assignCycles << "\n";
+    return write(key, entry.str());
+}
+
+bool ResultCache::write(const std::string &key, const std::string &entry) {
+    std::ostringstream name;
+    name << path(key) << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id())
+         << "." << temporaries.fetch_add(1, std::memory_order_relaxed);
+    const std::string temporary = name.str();
+
+    {
+        std::ofstream out(temporary.c_str());
+        out << entry;
+        out.close();
+        if(!out) {
+            remove(temporary.c_str());
+            return false;
+        }
+    }
+    // readers see the old entry or the new one, never a mix.
+    if(rename(temporary.c_str(), path(key).c_str()) != 0) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
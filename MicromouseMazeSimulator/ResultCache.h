@@ -0,0 +1,119 @@
+#ifndef ResultCache_h
+#define ResultCache_h
+
+#include <stdint.h> // uint64_t
+#include <string>
+#include <atomic>
+
+/**
+ * On-disk cache of run results, so a sweep does not simulate the same maze with the same
+ * PathFinder build twice.
+ *
+ * A run is kept as two small files in the cache directory. The result, which is the same
+ * whichever build makes the run, is named after the key of the run:
+ *     <size>-<maze hash>-<orientation>-<PathFinder id>-v<PathFinder version>
+ * The maze hash is canonical, a maze and its mirror image across the start diagonal have the
+ * same one (see BasicMazeWorld::getCanonicalHash). The orientation (n for the maze as hashed, m for
+ * its mirror image) stays in the key: the mouse always starts facing north, so a run through
+ * the mirror image is not the mirror image of the run. The timings are only comparable within
+ * one compiler, build and machine, and are named after the key and the build (see timingKey).
+ *
+ * Entries are written to a temporary file first and then renamed over the entry, so any
+ * number of threads and processes can read and write the same directory: a reader sees
+ * either no entry or a complete one, and the last writer wins.
+ */
+class ResultCache {
+public:
+    // what is kept of a run.
+    struct Result {
+        Result() : steps(0), turns(0), routeLength(0), outcome("finished"), runNanos(0), refloodCycles(0), assignCycles(0) {}
+
+        // movements made, Wait included, and how many of them were turns. The result of the run.
+        unsigned long steps;
+        unsigned long turns;
+        // instructions in the route the PathFinder built.
+        unsigned long routeLength;
+        // how the run ended, one word.
+        std::string outcome;
+        // wall clock time of one run. The simulator has no model of the time a real mouse takes.
+        // The timings, measured by the build that stored them, on its machine.
+        double runNanos;
+        // time stamp counter cycles per reflood and per assign_new_dis, likewise.
+        unsigned long long refloodCycles;
+        unsigned long long assignCycles;
+    };
+
+    /**
+     * @param directory: where the entries are kept. Created if it does not exist.
+     */
+    explicit ResultCache(const std::string &directory);
+
+    /**
+     * Key of a run.
+     * @param size: side of the maze
+     * @param mazeHash: canonical hash of the maze
+     * @param mirrored: the maze is the mirror image of the one that was hashed
+     * @param pathFinder: PathFinder id, see BasicPathFinder::getId
+     * @param version: PathFinder version, see BasicPathFinder::getVersion
+     */
+    static std::string key(unsigned size, uint64_t mazeHash, bool mirrored, const std::string &pathFinder, unsigned version);
+
+    /**
+     * Key of the timings of a run.
+     * @param key: key of the run
+     * @param build: the build that measures the run, see buildId
+     */
+    static std::string timingKey(const std::string &key, const std::string &build);
+
+    /**
+     * This build of the simulator on this machine: the host name and a hash of the compiler version
+     * and the time it was built. Timings are only comparable within one.
+     */
+    static std::string buildId();
+
+    /**
+     * Look a run up.
+     * @return true and the result, timings left alone, if there is a complete entry for key
+     */
+    bool load(const std::string &key, Result &result);
+
+    /**
+     * Keep the result of a run, but not its timings, replacing any entry with the same key.
+     * @return false if the entry could not be written
+     */
+    bool store(const std::string &key, const Result &result);
+
+    /**
+     * Look the timings of a run up. Not counted in getHits and getMisses.
+     * @param key: see timingKey
+     * @return true and the timings, the rest of result left alone, if there is a complete entry for key
+     */
+    bool loadTimings(const std::string &key, Result &result);
+
+    /**
+     * Keep the timings of a run, replacing any entry with the same key.
+     * @return false if the entry could not be written
+     */
+    bool storeTimings(const std::string &key, const Result &result);
+
+    // lookups that found an entry and that did not, since construction.
+    inline unsigned long getHits() const {
+        return hits.load(std::memory_order_relaxed);
+    }
+
+    inline unsigned long getMisses() const {
+        return misses.load(std::memory_order_relaxed);
+    }
+
+protected:
+    std::string path(const std::string &key) const;
+
+    // write an entry to a temporary file and rename it over the one named key.
+    bool write(const std::string &key, const std::string &entry);
+
+    std::string directory;
+    std::atomic<unsigned long> hits;
+    std::atomic<unsigned long> misses;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>  // atol
+#include <cstring>  // strcmp
+
+/**
+ * Worst-case stack depth of a call graph, from the call graph GCC writes with
+ * -fcallgraph-info=su (a .ci file in VCG format: a node per function with its frame size,
+ * an edge per call). make embedded runs it on the freestanding FloodFill.
+ *
+ * The depth of a function is its own frame plus the deepest of its callees. It is only an
+ * upper bound the firmware can rely on when every frame is static (or bounded) and the calls
+ * do not recurse; anything else, and calls to functions outside the file (e.g. memset), is
+ * reported.
+ */
+
+struct Function {
+    std::string name;
+    std::string location;
+    // frame size in bytes, and whether it is known at compile time ("static" or "dynamic,bounded").
+    unsigned long frame;
+    bool bounded;
+    // defined elsewhere: its frame is not in the file.
+    bool external;
+    std::vector<std::string> callees;
+};
+
+// value of the quoted attribute key: "..." in a line of the .ci file, empty if there is none.
+std::string attribute(const std::string &line, const std::string &key) {
+    const size_t at = line.find(key + ": \"");
+    if(at == std::string::npos)
+        return "";
+    const size_t start = at + key.size() + 3;
+    const size_t end = line.find('"', start);
+    return line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// the label is "name\nfile:line:column\nN bytes (static)", with \n written out.
+void parseLabel(const std::string &label, Function &f) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for(size_t at; (at = label.find("\\n", start)) != std::string::npos; start = at + 2) {
+        parts.push_back(label.substr(start, at - start));
+    }
+    parts.push_back(label.substr(start));
+    f.name = parts[0];
+    f.location = parts.size() > 1 ? parts[1] : "";
+    f.frame = 0;
+    f.bounded = true;
+    f.external = true;
+    for(size_t i = 2; i < parts.size(); i++) {
+        const size_t bytes = parts[i].find(" bytes (");
+        if(bytes == std::string::npos)
+            continue;
+        f.frame = atol(parts[i].c_str());
+        f.bounded = parts[i].compare(bytes, 15, " bytes (dynamic") != 0 || parts[i].find("bounded") != std::string::npos;
+        f.external = false;
+    }
+}
+
+struct Depth {
+    unsigned long bytes;
+    bool bounded;
+    // deepest callee, empty at the bottom.
+    std::string next;
+};
+
+class Graph {
+public:
+    explicit Graph(std::istream &in) {
+        std::string line;
+        while(std::getline(in, line)) {
+            if(line.compare(0, 5, "node:") == 0) {
+                Function &f = functions[attribute(line, "title")];
+                parseLabel(attribute(line, "label"), f);
+            } else if(line.compare(0, 5, "edge:") == 0) {
+                functions[attribute(line, "sourcename")].callees.push_back(attribute(line, "targetname"));
+            }
+        }
+    }
+
+    bool has(const std::string &title) const {
+        return functions.count(title) != 0;
+    }
+
+    // functions nobody in the file calls.
+    std::vector<std::string> roots() const {
+        std::map<std::string, bool> called;
+        for(std::map<std::string, Function>::const_iterator i = functions.begin(); i != functions.end(); ++i) {
+            for(size_t c = 0; c < i->second.callees.size(); c++) {
+                called[i->second.callees[c]] = true;
+            }
+        }
+        std::vector<std::string> result;
+        for(std::map<std::string, Function>::const_iterator i = functions.begin(); i != functions.end(); ++i) {
+            if(!called.count(i->first) && !i->second.external)
+                result.push_back(i->first);
+        }
+        return result;
+    }
+
+    // worst-case depth from title. A call back into a function on the path makes it unbounded.
+    const Depth &depth(const std::string &title) {
+        std::map<std::string, Depth>::iterator known = depths.find(title);
+        if(known != depths.end())
+            return known->second;
+        const Function &f = functions[title];
+        Depth d = { f.frame, f.bounded, "" };
+        if(onPath[title]) {
+            recursive.push_back(title);
+            d.bounded = false;
+            return depths[title] = d;
+        }
+        onPath[title] = true;
+        Depth deepest = { 0, true, "" };
+        for(size_t c = 0; c < f.callees.size(); c++) {
+            const Depth &callee = depth(f.callees[c]);
+            if(callee.bytes > deepest.bytes || deepest.next.empty()) {
+                deepest.bytes = callee.bytes;
+                deepest.next = f.callees[c];
+            }
+            deepest.bounded = deepest.bounded && callee.bounded;
+            if(functions[f.callees[c]].external)
+                externals[functions[f.callees[c]].name] = true;
+        }
+        onPath[title] = false;
+        d.bytes += deepest.bytes;
+        d.bounded = d.bounded && deepest.bounded;
+        d.next = deepest.next;
+        return depths[title] = d;
+    }
+
+    // print the deepest call chain from title, a frame per line.
+    // A recursive chain is printed up to the call back into it.
+    void printChain(const std::string &title) {
+        std::map<std::string, bool> printed;
+        for(std::string t = title; !t.empty() && !printed[t]; t = depths[t].next) {
+            const Function &f = functions[t];
+            std::cout << "\t" << f.frame << (f.bounded ? "" : "+") << "\t" << f.name
+                      << (f.external ? " (external)" : " (" + f.location + ")") << std::endl;
+            printed[t] = true;
+        }
+    }
+
+    std::vector<std::string> recursive;
+    std::map<std::string, bool> externals;
+
+private:
+    std::map<std::string, Function> functions;
+    std::map<std::string, Depth> depths;
+    std::map<std::string, bool> onPath;
+};
+
+int main(int argc, char * argv[]) {
+    const char *path = NULL;
+    unsigned long limit = 0;
+    std::vector<std::string> entries;
+
+    // Skip the program name, start with argument index 1
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            limit = atol(argv[++i]);
+        } else if(argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else if(argv[i][0] != '-') {
+            entries.push_back(argv[i]);
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if(!path) {
+        std::cout << "Usage: " << argv[0] << " FILE [FUNCTION...] [-l N]" << std::endl;
+        std::cout << "\tFILE is a call graph written by g++ -fcallgraph-info=su" << std::endl;
+        std::cout << "\tFUNCTION is an entry point to report, by its symbol. Every function nobody calls by default" << std::endl;
+        std::cout << "\t-l N will fail if an entry point can take more than N bytes of stack" << std::endl;
+        return -1;
+    }
+
+    std::ifstream in(path);
+    if(!in) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return 1;
+    }
+    Graph graph(in);
+    if(entries.empty())
+        entries = graph.roots();
+
+    bool ok = true;
+    for(size_t i = 0; i < entries.size(); i++) {
+        if(!graph.has(entries[i])) {
+            std::cerr << "No function " << entries[i] << " in " << path << std::endl;
+            ok = false;
+            continue;
+        }
+        const Depth &d = graph.depth(entries[i]);
+        std::cout << entries[i] << ": " << d.bytes << " bytes of stack"
+                  << (d.bounded ? "" : ", at least: a frame is dynamic or a call recurses") << std::endl;
+        graph.printChain(entries[i]);
+        if(!d.bounded || (limit && d.bytes > limit))
+            ok = false;
+    }
+    for(size_t i = 0; i < graph.recursive.size(); i++) {
+        std::cout << "Recursion through " << graph.recursive[i] << std::endl;
+    }
+    if(!graph.externals.empty()) {
+        std::cout << "Not counted, defined elsewhere:";
+        for(std::map<std::string, bool>::const_iterator e = graph.externals.begin(); e != graph.externals.end(); ++e) {
+            std::cout << " " << e->first;
+        }
+        std::cout << std::endl;
+    }
+    if(limit)
+        std::cout << (ok ? "Within " : "Over ") << limit << " bytes" << std::endl;
+    return ok ? 0 : 1;
+}
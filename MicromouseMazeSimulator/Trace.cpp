@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include "Trace.h"
+
+namespace Trace {
+    std::atomic<bool> active(false);
+
+    namespace {
+        const unsigned CHUNK_SIZE = 4096;
+        const unsigned MAX_CHUNKS = 4096;
+
+        std::chrono::steady_clock::time_point epoch;
+
+        /**
+         * Events of a single thread. Only the owning thread appends; write() reads
+         * the first 'count' events, which are complete once count has been published.
+         * Events are stored in fixed-size chunks so they never move while being read.
+         */
+        struct Buffer {
+            Buffer(unsigned tid) : tid(tid), count(0), next(NULL) {
+                for(unsigned i = 0; i < MAX_CHUNKS; i++) {
+                    chunks[i] = NULL;
+                }
+            }
+
+            unsigned tid;
+            std::atomic<unsigned> count;
+            Event *chunks[MAX_CHUNKS];
+            Buffer *next;
+        };
+
+        // All buffers ever created. Buffers are never freed so the trace outlives its threads.
+        std::mutex registryMutex;
+        Buffer *registry = NULL;
+        unsigned nextTid = 1;
+
+        Buffer *threadBuffer() {
+            static thread_local Buffer *buffer = NULL;
+            if(!buffer) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                buffer = new Buffer(nextTid++);
+                buffer->next = registry;
+                registry = buffer;
+            }
+            return buffer;
+        }
+    }
+
+    void enable() {
+        epoch = std::chrono::steady_clock::now();
+        active.store(true);
+    }
+
+    int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void record(const char *name, const char *category, char phase, int64_t start, int64_t duration, int x, int y) {
+        Buffer *buffer = threadBuffer();
+        const unsigned index = buffer->count.load(std::memory_order_relaxed);
+        const unsigned chunk = index / CHUNK_SIZE;
+
+        if(chunk >= MAX_CHUNKS) {
+            return; // full, drop the event
+        }
+        if(!buffer->chunks[chunk]) {
+            buffer->chunks[chunk] = new Event[CHUNK_SIZE];
+        }
+
+        Event &event = buffer->chunks[chunk][index % CHUNK_SIZE];
+        event.name = name;
+        event.category = category;
+        event.phase = phase;
+        event.start = start;
+        event.duration = duration;
+        event.x = x;
+        event.y = y;
+
+        buffer->count.store(index + 1, std::memory_order_release);
+    }
+
+    bool write(const char *path) {
+        FILE *out = fopen(path, "w");
+        if(!out) {
+            return false;
+        }
+
+        fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+        bool first = true;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for(Buffer *buffer = registry; buffer; buffer = buffer->next) {
+            const unsigned count = buffer->count.load(std::memory_order_acquire);
+
+            for(unsigned i = 0; i < count; i++) {
+                const Event &event = buffer->chunks[i / CHUNK_SIZE][i % CHUNK_SIZE];
+
+                fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                        first ? "" : ",\n", event.name, event.category, event.phase, buffer->tid, event.start / 1000.0);
+                if(event.phase == 'X') {
+                    fprintf(out, ",\"dur\":%.3f", event.duration / 1000.0);
+                } else {
+                    fprintf(out, ",\"s\":\"t\"");
+                }
+                if(event.x >= 0) {
+                    fprintf(out, ",\"args\":{\"x\":%d,\"y\":%d}", event.x, event.y);
+                }
+                fprintf(out, "}");
+                first = false;
+            }
+        }
+
+        fprintf(out, "\n]}\n");
+        return fclose(out) == 0;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef Trace_h
+#define Trace_h
+
+#include <stdint.h> // int64_t
+
+#ifdef TRACE_DISABLED
+/**
+ * Tracing compiled out, e.g. for the firmware (make embedded): spans and instant events cost nothing.
+ */
+namespace Trace {
+    namespace {
+        inline void instant(const char *, const char *, int = -1, int = -1) {}
+
+        class Span {
+        public:
+            Span(const char *, const char *, int = -1, int = -1) {}
+        };
+    }
+}
+#else
+#include <atomic>
+
+/**
+ * Lightweight tracing of simulation and planner phases.
+ *
+ * Spans and instant events are recorded into a buffer owned by the calling thread,
+ * so recording never takes a lock and tracing works with any number of threads.
+ * The result is written in Chrome trace-event JSON, which can be opened in
+ * Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Tracing is off by default. While it is off, a Span costs a single relaxed load.
+ */
+namespace Trace {
+    // a single recorded event. x and y are cell coordinates, -1 when not applicable.
+    struct Event {
+        const char *name;
+        const char *category;
+        char phase;         // 'X' for a complete span, 'i' for an instant event
+        int64_t start;      // nanoseconds since tracing was enabled
+        int64_t duration;   // nanoseconds, 0 for instant events
+        int x;
+        int y;
+    };
+
+    extern std::atomic<bool> active;
+
+    // start recording events.
+    void enable();
+
+    // stop recording events. Events recorded so far are kept.
+    inline void disable() {
+        active.store(false);
+    }
+
+    inline bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // nanoseconds since tracing was enabled.
+    int64_t now();
+
+    // record a finished span or an instant event on the calling thread. name and category must outlive the trace.
+    void record(const char *name, const char *category, char phase, int64_t start, int64_t duration, int x = -1, int y = -1);
+
+    // record an instant event, e.g. a mode transition.
+    inline void instant(const char *name, const char *category, int x = -1, int y = -1) {
+        if(enabled()) {
+            record(name, category, 'i', now(), 0, x, y);
+        }
+    }
+
+    /**
+     * Write every event recorded so far, from all threads, as Chrome trace JSON.
+     * @param path: output file
+     * @return false if the file could not be written
+     */
+    bool write(const char *path);
+
+    /**
+     * Records the lifetime of a scope as a span.
+     * Usage: Trace::Span span("reflood", "FloodFill", x, y);
+     */
+    class Span {
+    public:
+        Span(const char *name, const char *category, int x = -1, int y = -1)
+        : name(name), category(category), x(x), y(y), start(enabled() ? now() : -1) {
+        }
+
+        ~Span() {
+            if(start >= 0) {
+                record(name, category, 'X', start, now() - start, x, y);
+            }
+        }
+
+    private:
+        Span(const Span &);
+        Span &operator=(const Span &);
+
+        const char *name;
+        const char *category;
+        int x;
+        int y;
+        int64_t start;
+    };
+}
+#endif
+
+#endif
@@ -1,9 +1,10 @@
 #include <iostream>
 #include <cstdlib>  // atoi
 
-#include "Maze.h"
+#include "MouseSession.h"
 #include "MazeDefinitions.h"
 #include "PathFinder.h"
+#include "Trace.h"
 
 
 /**
@@ -16,7 +17,6 @@ class LeftWallFollower : public PathFinder {
 public:
     LeftWallFollower(bool shouldPause = false) : pause(shouldPause) {
         shouldGoForward = false;
-        visitedStart = false;
     }
 
 
@@ -42,7 +42,7 @@ public:
     }
 
 
-    MouseMovement nextMovement(unsigned x, unsigned y, const Maze &maze) {
+    MouseMovement nextMovement(unsigned x, unsigned y, const MouseSession &maze) {
         const bool frontWall = maze.wallInFront();
         const bool leftWall  = maze.wallOnLeft();
 
@@ -63,17 +63,6 @@ public:
             return Finish;
         }
 
-        // If we hit the start of the maze a second time, then
-        // we couldn't find the center and never will...
-        if(x == 0 && y == 0) {
-            if(visitedStart) {
-                std::cout << "Unable to find center, giving up." << std::endl;
-                return Finish;
-            } else {
-                visitedStart = true;
-            }
-        }
-
         // If we have just turned left, we should take that path!
         if(!frontWall && shouldGoForward) {
             shouldGoForward = false;
@@ -105,13 +94,17 @@ public:
         return Finish;
     }
 
+    // If we come back to a cell facing the same way, about to do the same,
+    // we couldn't find the center and never will: the maze cuts us off.
+    bool getStateHash(uint64_t &hash) const {
+        hash = shouldGoForward;
+        return true;
+    }
+
 protected:
     // Helps us determine that we should go forward if we have just turned left.
     bool shouldGoForward;
 
-    // Helps us determine if we've made a loop around the maze without finding the center.
-    bool visitedStart;
-
     // Indicates we should pause before moving to next cell.
     // Useful for command line usage.
     const bool pause;
@@ -133,6 +126,8 @@ protected:
 int main(int argc, char * argv[]) {
     MazeDefinitions::MazeEncodingName mazeName = MazeDefinitions::MAZE_CAMM_2012;
     bool pause = false;
+    const char *tracePath = NULL;
+    bool json = false;
 
     // Since Windows does not support getopt directly, we will
     // have to parse the command line arguments ourselves.
@@ -146,17 +141,41 @@ int main(int argc, char * argv[]) {
             }
         } else if(strcmp(argv[i], "-p") == 0) {
             pause = true;
+        } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            tracePath = argv[++i];
+        } else if(strcmp(argv[i], "-j") == 0) {
+            json = true;
         } else {
-            std::cout << "Usage: " << argv[0] << " [-m N] [-p]" << std::endl;
+            std::cout << "Usage: " << argv[0] << " [-m N] [-p] [-t FILE] [-j]" << std::endl;
             std::cout << "\t-m N will load the maze corresponding to N, or 0 if invalid N or missing option" << std::endl;
             std::cout << "\t-p will wait for a newline in between cell traversals" << std::endl;
+            std::cout << "\t-t FILE will write a Chrome trace of the run to FILE (open it in ui.perfetto.dev)" << std::endl;
+            std::cout << "\t-j will print the run statistics as JSON at the end" << std::endl;
             return -1;
         }
     }
 
+    if(tracePath) {
+        Trace::enable();
+    }
+
     LeftWallFollower leftWallFollower(pause);
-    Maze maze(mazeName, &leftWallFollower);
+    MouseSession maze(mazeName, &leftWallFollower);
+    maze.setLoopDetection(true);
     std::cout << maze.draw(5) << std::endl << std::endl;
 
     maze.start();
+    if(maze.getOutcome() == RUN_LOOPED) {
+        std::cout << "Unable to find center, giving up: back where we were at step " << maze.getLoopStart()
+                  << " after " << maze.getStepCount() << " steps." << std::endl;
+    }
+
+    if(json) {
+        maze.writeStats(std::cout);
+        std::cout << std::endl;
+    }
+
+    if(tracePath && !Trace::write(tracePath)) {
+        std::cerr << "Could not write trace to " << tracePath << std::endl;
+    }
 }